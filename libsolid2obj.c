@@ -0,0 +1,7266 @@
+/*
+    solid2obj
+    Copyright (C) 2013 melchips (Francois Truphemus : francois (at) truphemus (dot) fr)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
+#include <utime.h>
+#endif
+
+#ifdef _WIN32
+#include <sys/stat.h>
+#include <direct.h>
+#include <process.h>
+#endif
+
+#ifndef _MSC_VER
+#include <dirent.h>
+#endif
+
+/* byte order of the host : solid file records are byte swapped in bulk on little endian hosts and copied as they are on big endian ones,
+   other hosts decode them value by value (Windows targets are all little endian) */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SOLID_HOST_LITTLE_ENDIAN
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SOLID_HOST_BIG_ENDIAN
+#elif defined(_WIN32)
+#define SOLID_HOST_LITTLE_ENDIAN
+#endif
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/* atomic additions to the counters shared by the threads : 64 bit ones need an 8 byte compare and swap that 32 bit x86 targets
+   before the pentium (i486) don't have, they are added under a spin lock there */
+#if defined(_MSC_VER)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#define ATOMIC_ADD_64(counter, value) InterlockedExchangeAdd64((volatile LONG64 *) (counter), (LONG64) (value))
+#define ATOMIC_ADD_32(counter, value) ((unsigned int) InterlockedExchangeAdd((volatile LONG *) (counter), (LONG) (value)))
+#elif defined(__ATOMIC_RELAXED) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+#define ATOMIC_ADD_64(counter, value) __atomic_fetch_add((counter), (uint64_t) (value), __ATOMIC_RELAXED)
+#define ATOMIC_ADD_32(counter, value) __atomic_fetch_add((counter), (unsigned int) (value), __ATOMIC_RELAXED)
+#else
+#define ATOMIC_ADD_64(counter, value) atomic_add_64_locked((counter), (uint64_t) (value))
+#define ATOMIC_ADD_32(counter, value) __sync_fetch_and_add((counter), (unsigned int) (value))
+
+/* add to a 64 bit counter shared by the threads without 64 bit atomics */
+static void atomic_add_64_locked(uint64_t *counter, uint64_t value)
+{
+    static volatile int lock = 0;
+
+    while (__sync_lock_test_and_set(&lock, 1))
+        ;
+    *counter += value;
+    __sync_lock_release(&lock);
+}
+#endif
+
+#include "solid2obj_private.h"
+
+/* statistics of the conversions of every thread, nothing is measured when it is not set */
+static conversion_stats_t *stats_capture = NULL;
+
+/* add to a counter of the statistics being captured (from any thread) */
+#define STATS_ADD(counter, value) do { if (stats_capture != NULL) ATOMIC_ADD_64(&stats_capture->counter, value); } while (0)
+
+/* set the default conversion options */
+void conversion_options_init(conversion_options_t *options)
+{
+    options->float_precision = -1;
+    options->threads_count = 1;
+    options->weld_epsilon = -1.0f;
+    options->optimize_vertex_cache = 0;
+    options->decimation_faces = 0;
+    options->decimation_vertices = 0;
+    options->stream_window_size = 0;
+    options->cache_directory = NULL;
+    options->material_file_path = NULL;
+    options->material_file_state = NULL;
+    options->solid_format = SOLID_FORMAT_V1;
+    options->compute_normals = 0;
+}
+
+/* init an empty byte buffer */
+void solid_buffer_init(solid_buffer_t *buffer)
+{
+    buffer->data = NULL;
+    buffer->used = 0;
+    buffer->allocated = 0;
+}
+
+/* free the memory used by a byte buffer */
+void solid_buffer_free(solid_buffer_t *buffer)
+{
+    if (buffer->data != NULL)
+        free(buffer->data);
+
+    solid_buffer_init(buffer);
+}
+
+/* append "size" bytes to a buffer and return where to store them (NULL on error) */
+unsigned char * solid_buffer_append(solid_buffer_t *buffer, size_t size)
+{
+    unsigned char *new_data = NULL;
+    size_t new_allocated = 0;
+    unsigned char *appended = NULL;
+
+    if (buffer->used + size > buffer->allocated)
+        {
+            new_allocated = (buffer->allocated > 0) ? buffer->allocated : 4096;
+            while (new_allocated < buffer->used + size)
+                new_allocated *= 2;
+
+            /* errors are reported by the callers (reports may be captured in a buffer themselves) */
+            new_data = (unsigned char *) realloc(buffer->data, new_allocated);
+            if (new_data == NULL)
+                return NULL;
+            buffer->data = new_data;
+            buffer->allocated = new_allocated;
+            STATS_ADD(reallocs, 1);
+        }
+
+    appended = buffer->data + buffer->used;
+    buffer->used += size;
+    return appended;
+}
+
+/* append formatted text to a buffer (returns 0 on error) */
+int solid_buffer_printf(solid_buffer_t *buffer, const char *format, ...)
+{
+    va_list arguments;
+    char text[512];
+    int length = 0;
+    unsigned char *appended = NULL;
+
+    va_start(arguments, format);
+    length = vsnprintf(text, sizeof(text), format, arguments);
+    va_end(arguments);
+
+    if (length < 0)
+        return 0;
+
+    appended = solid_buffer_append(buffer, length + 1);
+    if (appended == NULL)
+        return 0;
+
+    /* short texts are copied, longer ones are formatted again straight into the buffer */
+    if ((size_t) length < sizeof(text))
+        {
+            memcpy(appended, text, length);
+        }
+    else
+        {
+            va_start(arguments, format);
+            vsnprintf((char *) appended, length + 1, format, arguments);
+            va_end(arguments);
+        }
+
+    /* the terminating null character is not part of the content */
+    buffer->used--;
+    return 1;
+}
+
+/* make sure "size" more bytes can be appended to a buffer and return where they go (NULL on error, "used" is not changed) */
+unsigned char * solid_buffer_reserve(solid_buffer_t *buffer, size_t size)
+{
+    if (solid_buffer_append(buffer, size) == NULL)
+        return NULL;
+
+    buffer->used -= size;
+    return buffer->data + buffer->used;
+}
+
+/* "00" to "99", used to write integers two digits at a time */
+static const char text_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* primes of the XXH64 hash */
+#define HASH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME64_3 0x165667B19E3779F9ULL
+#define HASH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define HASH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+/* rotate a 64 bits word left */
+static uint64_t hash_rotl64(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/* mix 8 bytes of input into an accumulator of the XXH64 hash */
+static uint64_t hash_round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * HASH_PRIME64_2;
+    accumulator = hash_rotl64(accumulator, 31);
+    return accumulator * HASH_PRIME64_1;
+}
+
+/* merge an accumulator into the XXH64 hash */
+static uint64_t hash_merge_round(uint64_t hash, uint64_t accumulator)
+{
+    hash ^= hash_round(0, accumulator);
+    return hash * HASH_PRIME64_1 + HASH_PRIME64_4;
+}
+
+/* 64 bits hash of "size" bytes (XXH64 algorithm, words read in the byte order of the machine) */
+uint64_t hash_xxh64(const void *data, size_t size, uint64_t seed)
+{
+    const unsigned char *cursor = (const unsigned char *) data;
+    const unsigned char *end = cursor + size;
+    uint64_t accumulators[4];
+    uint64_t hash = 0;
+    uint64_t word = 0;
+    uint32_t half_word = 0;
+    int index = 0;
+
+    if (size >= 32)
+        {
+            accumulators[0] = seed + HASH_PRIME64_1 + HASH_PRIME64_2;
+            accumulators[1] = seed + HASH_PRIME64_2;
+            accumulators[2] = seed;
+            accumulators[3] = seed - HASH_PRIME64_1;
+
+            /* 4 independent lanes of 8 bytes */
+            while (end - cursor >= 32)
+                {
+                    for (index = 0; index < 4; index++)
+                        {
+                            memcpy(&word, cursor, 8);
+                            accumulators[index] = hash_round(accumulators[index], word);
+                            cursor += 8;
+                        }
+                }
+
+            hash = hash_rotl64(accumulators[0], 1) + hash_rotl64(accumulators[1], 7) + hash_rotl64(accumulators[2], 12) + hash_rotl64(accumulators[3], 18);
+            for (index = 0; index < 4; index++)
+                hash = hash_merge_round(hash, accumulators[index]);
+        }
+    else
+        {
+            hash = seed + HASH_PRIME64_5;
+        }
+
+    hash += (uint64_t) size;
+
+    /* the last bytes, 8 then 4 then 1 at a time */
+    while (end - cursor >= 8)
+        {
+            memcpy(&word, cursor, 8);
+            hash ^= hash_round(0, word);
+            hash = hash_rotl64(hash, 27) * HASH_PRIME64_1 + HASH_PRIME64_4;
+            cursor += 8;
+        }
+    if (end - cursor >= 4)
+        {
+            memcpy(&half_word, cursor, 4);
+            hash ^= (uint64_t) half_word * HASH_PRIME64_1;
+            hash = hash_rotl64(hash, 23) * HASH_PRIME64_2 + HASH_PRIME64_3;
+            cursor += 4;
+        }
+    while (cursor < end)
+        {
+            hash ^= (uint64_t) *cursor * HASH_PRIME64_5;
+            hash = hash_rotl64(hash, 11) * HASH_PRIME64_1;
+            cursor++;
+        }
+
+    /* avalanche */
+    hash ^= hash >> 33;
+    hash *= HASH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= HASH_PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/* number of decimal digits of an unsigned integer */
+int text_decimal_length(uint64_t value)
+{
+    int length = 1;
+
+    while (value >= 10000)
+        {
+            value /= 10000;
+            length += 4;
+        }
+
+    return length + (value >= 10) + (value >= 100) + (value >= 1000);
+}
+
+/* write an unsigned integer (no terminating null character) and return the end of the text */
+char * text_format_uint(char *text, uint64_t value)
+{
+    int length = text_decimal_length(value);
+    char *cursor = text + length;
+    unsigned int pair = 0;
+
+    while (value >= 100)
+        {
+            pair = (unsigned int) (value % 100) * 2;
+            value /= 100;
+            *--cursor = text_digit_pairs[pair + 1];
+            *--cursor = text_digit_pairs[pair];
+        }
+    if (value >= 10)
+        {
+            *--cursor = text_digit_pairs[value * 2 + 1];
+            *--cursor = text_digit_pairs[value * 2];
+        }
+    else
+        {
+            *--cursor = (char) ('0' + value);
+        }
+
+    return text + length;
+}
+
+/* write a signed integer (no terminating null character) and return the end of the text */
+char * text_format_int(char *text, int value)
+{
+    if (value < 0)
+        {
+            *text++ = '-';
+            return text_format_uint(text, 0 - (uint64_t) (int64_t) value);
+        }
+
+    return text_format_uint(text, (uint64_t) value);
+}
+
+/* shortest decimal representation of floats, following the Ryu algorithm (Ulf Adams, PLDI 2018) */
+
+#define FLOAT_MANTISSA_BITS 23
+#define FLOAT_EXPONENT_BIAS 127
+#define FLOAT_POW5_INV_BITCOUNT 59
+#define FLOAT_POW5_BITCOUNT 61
+
+/* floor(2^(59 + ceil(log2(5^i)) - 1) / 5^i) + 1 */
+static const uint64_t float_pow5_inv_split[31] =
+{
+    UINT64_C(576460752303423489), UINT64_C(461168601842738791), UINT64_C(368934881474191033),
+    UINT64_C(295147905179352826), UINT64_C(472236648286964522), UINT64_C(377789318629571618),
+    UINT64_C(302231454903657294), UINT64_C(483570327845851670), UINT64_C(386856262276681336),
+    UINT64_C(309485009821345069), UINT64_C(495176015714152110), UINT64_C(396140812571321688),
+    UINT64_C(316912650057057351), UINT64_C(507060240091291761), UINT64_C(405648192073033409),
+    UINT64_C(324518553658426727), UINT64_C(519229685853482763), UINT64_C(415383748682786211),
+    UINT64_C(332306998946228969), UINT64_C(531691198313966350), UINT64_C(425352958651173080),
+    UINT64_C(340282366920938464), UINT64_C(544451787073501542), UINT64_C(435561429658801234),
+    UINT64_C(348449143727040987), UINT64_C(557518629963265579), UINT64_C(446014903970612463),
+    UINT64_C(356811923176489971), UINT64_C(570899077082383953), UINT64_C(456719261665907162),
+    UINT64_C(365375409332725730)};
+
+/* 5^i truncated to its 61 most significant bits */
+static const uint64_t float_pow5_split[47] =
+{
+    UINT64_C(1152921504606846976), UINT64_C(1441151880758558720), UINT64_C(1801439850948198400),
+    UINT64_C(2251799813685248000), UINT64_C(1407374883553280000), UINT64_C(1759218604441600000),
+    UINT64_C(2199023255552000000), UINT64_C(1374389534720000000), UINT64_C(1717986918400000000),
+    UINT64_C(2147483648000000000), UINT64_C(1342177280000000000), UINT64_C(1677721600000000000),
+    UINT64_C(2097152000000000000), UINT64_C(1310720000000000000), UINT64_C(1638400000000000000),
+    UINT64_C(2048000000000000000), UINT64_C(1280000000000000000), UINT64_C(1600000000000000000),
+    UINT64_C(2000000000000000000), UINT64_C(1250000000000000000), UINT64_C(1562500000000000000),
+    UINT64_C(1953125000000000000), UINT64_C(1220703125000000000), UINT64_C(1525878906250000000),
+    UINT64_C(1907348632812500000), UINT64_C(1192092895507812500), UINT64_C(1490116119384765625),
+    UINT64_C(1862645149230957031), UINT64_C(1164153218269348144), UINT64_C(1455191522836685180),
+    UINT64_C(1818989403545856475), UINT64_C(2273736754432320594), UINT64_C(1421085471520200371),
+    UINT64_C(1776356839400250464), UINT64_C(2220446049250313080), UINT64_C(1387778780781445675),
+    UINT64_C(1734723475976807094), UINT64_C(2168404344971008868), UINT64_C(1355252715606880542),
+    UINT64_C(1694065894508600678), UINT64_C(2117582368135750847), UINT64_C(1323488980084844279),
+    UINT64_C(1654361225106055349), UINT64_C(2067951531382569187), UINT64_C(1292469707114105741),
+    UINT64_C(1615587133892632177), UINT64_C(2019483917365790221)
+};
+
+/* ceil(log2(5^e)) (1 for e = 0) */
+static int float_pow5_bits(int e)
+{
+    return (int) (((uint32_t) e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) */
+static int float_log10_pow2(int e)
+{
+    return (int) (((uint32_t) e * 78913) >> 18);
+}
+
+/* floor(log10(5^e)) */
+static int float_log10_pow5(int e)
+{
+    return (int) (((uint32_t) e * 732923) >> 20);
+}
+
+/* true if value is a multiple of 5^p */
+static int float_multiple_of_pow5(uint32_t value, int p)
+{
+    int count = 0;
+
+    while (value % 5 == 0)
+        {
+            value /= 5;
+            count++;
+        }
+
+    return count >= p;
+}
+
+/* (m * factor) >> shift with shift > 32 */
+static uint32_t float_mul_shift(uint32_t m, uint64_t factor, int shift)
+{
+    uint64_t low = (uint64_t) m * (uint32_t) factor;
+    uint64_t high = (uint64_t) m * (uint32_t) (factor >> 32);
+
+    return (uint32_t) (((low >> 32) + high) >> (shift - 32));
+}
+
+/* shortest "digits * 10^exponent" reading back as the float of the given mantissa and exponent bits (finite, not zero) */
+void float_shortest_decimal(uint32_t ieee_mantissa, uint32_t ieee_exponent, uint32_t *digits, int *exponent)
+{
+    int e2 = 0;
+    uint32_t m2 = 0;
+    int accept_bounds = 0;
+    uint32_t mv = 0;
+    uint32_t mp = 0;
+    uint32_t mm = 0;
+    uint32_t mm_shift = 0;
+    uint32_t vr = 0;
+    uint32_t vp = 0;
+    uint32_t vm = 0;
+    int e10 = 0;
+    int vm_is_trailing_zeros = 0;
+    int vr_is_trailing_zeros = 0;
+    uint32_t last_removed_digit = 0;
+    int removed = 0;
+    int q = 0;
+    int i = 0;
+    int j = 0;
+    int k = 0;
+
+    if (ieee_exponent == 0)
+        {
+            e2 = 1 - FLOAT_EXPONENT_BIAS - FLOAT_MANTISSA_BITS - 2;
+            m2 = ieee_mantissa;
+        }
+    else
+        {
+            e2 = (int) ieee_exponent - FLOAT_EXPONENT_BIAS - FLOAT_MANTISSA_BITS - 2;
+            m2 = (1u << FLOAT_MANTISSA_BITS) | ieee_mantissa;
+        }
+    accept_bounds = (m2 & 1) == 0;
+
+    /* the float and the halfway points to its neighbours, times 4 */
+    mv = 4 * m2;
+    mp = 4 * m2 + 2;
+    mm_shift = (ieee_mantissa != 0 || ieee_exponent <= 1);
+    mm = 4 * m2 - 1 - mm_shift;
+
+    /* the three of them in base 10 */
+    if (e2 >= 0)
+        {
+            q = float_log10_pow2(e2);
+            e10 = q;
+            k = FLOAT_POW5_INV_BITCOUNT + float_pow5_bits(q) - 1;
+            i = -e2 + q + k;
+            vr = float_mul_shift(mv, float_pow5_inv_split[q], i);
+            vp = float_mul_shift(mp, float_pow5_inv_split[q], i);
+            vm = float_mul_shift(mm, float_pow5_inv_split[q], i);
+            if (q != 0 && (vp - 1) / 10 <= vm / 10)
+                {
+                    /* one removed digit is needed even if the loop below does not run */
+                    j = FLOAT_POW5_INV_BITCOUNT + float_pow5_bits(q - 1) - 1;
+                    last_removed_digit = float_mul_shift(mv, float_pow5_inv_split[q - 1], -e2 + q - 1 + j) % 10;
+                }
+            if (q <= 9)
+                {
+                    /* only one of mp, mv and mm can be a multiple of 5 */
+                    if (mv % 5 == 0)
+                        vr_is_trailing_zeros = float_multiple_of_pow5(mv, q);
+                    else if (accept_bounds)
+                        vm_is_trailing_zeros = float_multiple_of_pow5(mm, q);
+                    else
+                        vp -= float_multiple_of_pow5(mp, q);
+                }
+        }
+    else
+        {
+            q = float_log10_pow5(-e2);
+            e10 = q + e2;
+            i = -e2 - q;
+            k = float_pow5_bits(i) - FLOAT_POW5_BITCOUNT;
+            j = q - k;
+            vr = float_mul_shift(mv, float_pow5_split[i], j);
+            vp = float_mul_shift(mp, float_pow5_split[i], j);
+            vm = float_mul_shift(mm, float_pow5_split[i], j);
+            if (q != 0 && (vp - 1) / 10 <= vm / 10)
+                {
+                    j = q - 1 - (float_pow5_bits(i + 1) - FLOAT_POW5_BITCOUNT);
+                    last_removed_digit = float_mul_shift(mv, float_pow5_split[i + 1], j) % 10;
+                }
+            if (q <= 1)
+                {
+                    /* mv has at least q trailing zero bits, so vr is exact */
+                    vr_is_trailing_zeros = 1;
+                    if (accept_bounds)
+                        vm_is_trailing_zeros = (mm_shift == 1);
+                    else
+                        vp--;
+                }
+            else if (q < 31)
+                {
+                    vr_is_trailing_zeros = (mv & ((1u << (q - 1)) - 1)) == 0;
+                }
+        }
+
+    /* remove as many digits as possible while staying between the halfway points */
+    if (vm_is_trailing_zeros || vr_is_trailing_zeros)
+        {
+            while (vp / 10 > vm / 10)
+                {
+                    vm_is_trailing_zeros &= (vm % 10 == 0);
+                    vr_is_trailing_zeros &= (last_removed_digit == 0);
+                    last_removed_digit = vr % 10;
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    removed++;
+                }
+            if (vm_is_trailing_zeros)
+                {
+                    while (vm % 10 == 0)
+                        {
+                            vr_is_trailing_zeros &= (last_removed_digit == 0);
+                            last_removed_digit = vr % 10;
+                            vr /= 10;
+                            vp /= 10;
+                            vm /= 10;
+                            removed++;
+                        }
+                }
+            /* exact halfway : round to even */
+            if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+                last_removed_digit = 4;
+            *digits = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+        }
+    else
+        {
+            while (vp / 10 > vm / 10)
+                {
+                    last_removed_digit = vr % 10;
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    removed++;
+                }
+            *digits = vr + (vr == vm || last_removed_digit >= 5);
+        }
+
+    *exponent = e10 + removed;
+}
+
+/* write "digits * 10^exponent" without exponent notation (no terminating null character) and return the end of the text */
+char * text_format_decimal(char *text, uint32_t digits, int exponent)
+{
+    char digits_text[10];
+    int length = 0;
+    int point = 0;
+
+    while (digits != 0 && digits % 10 == 0)
+        {
+            digits /= 10;
+            exponent++;
+        }
+
+    length = (int) (text_format_uint(digits_text, digits) - digits_text);
+    point = length + exponent;
+
+    if (exponent >= 0)
+        {
+            /* integer : digits followed by zeros */
+            memcpy(text, digits_text, length);
+            text += length;
+            memset(text, '0', exponent);
+            text += exponent;
+        }
+    else if (point > 0)
+        {
+            memcpy(text, digits_text, point);
+            text += point;
+            *text++ = '.';
+            memcpy(text, digits_text + point, length - point);
+            text += length - point;
+        }
+    else
+        {
+            *text++ = '0';
+            *text++ = '.';
+            memset(text, '0', -point);
+            text += -point;
+            memcpy(text, digits_text, length);
+            text += length;
+        }
+
+    return text;
+}
+
+/* write a positive float with "precision" decimals exactly as printf("%.*f") does (no terminating null character) */
+char * text_format_fixed(char *text, float value, int precision)
+{
+    static const double powers_of_ten[TEXT_FLOAT_MAX_PRECISION + 1] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12
+        };
+    char digits_text[TEXT_FLOAT_MAX_LENGTH];
+    double scaled = 0.0;
+    double fraction = 0.0;
+    uint64_t integer = 0;
+    int length = 0;
+    int zeros = 0;
+
+    /* a float has 24 significant bits and 5^12 only 28, so the product is exact in a double */
+    scaled = (double) value * powers_of_ten[precision];
+    if (scaled >= 18446744073709551616.0)
+        {
+            /* huge values are left to the C library */
+            length = snprintf(text, TEXT_FLOAT_MAX_LENGTH, "%.*f", precision, (double) value);
+            return text + ((length > 0 && length < TEXT_FLOAT_MAX_LENGTH) ? length : 0);
+        }
+
+    /* round half to even, as printf does in the default rounding mode */
+    integer = (uint64_t) scaled;
+    fraction = scaled - (double) integer;
+    if (fraction > 0.5 || (fraction == 0.5 && (integer & 1) != 0))
+        integer++;
+
+    /* at least one digit before the point */
+    length = (int) (text_format_uint(digits_text, integer) - digits_text);
+    if (length <= precision)
+        {
+            zeros = precision + 1 - length;
+            memmove(digits_text + zeros, digits_text, length);
+            memset(digits_text, '0', zeros);
+            length += zeros;
+        }
+
+    memcpy(text, digits_text, length - precision);
+    text += length - precision;
+    if (precision > 0)
+        {
+            *text++ = '.';
+            memcpy(text, digits_text + length - precision, precision);
+            text += precision;
+        }
+
+    return text;
+}
+
+/* write a float (no terminating null character) and return the end of the text : the shortest text reading back as
+   the same float if "precision" is negative, otherwise "precision" decimals (at most TEXT_FLOAT_MAX_PRECISION) as printf("%.*f") */
+char * text_format_float(char *text, float value, int precision)
+{
+    uint32_t bits = 0;
+    uint32_t ieee_mantissa = 0;
+    uint32_t ieee_exponent = 0;
+    uint32_t digits = 0;
+    int exponent = 0;
+
+    memcpy(&bits, &value, sizeof(bits));
+    ieee_mantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+    ieee_exponent = (bits >> FLOAT_MANTISSA_BITS) & 0xff;
+
+    if (bits >> 31)
+        *text++ = '-';
+
+    if (ieee_exponent == 0xff)
+        {
+            memcpy(text, (ieee_mantissa != 0) ? "nan" : "inf", 3);
+            return text + 3;
+        }
+
+    if (precision >= 0)
+        {
+            bits &= 0x7fffffff;
+            memcpy(&value, &bits, sizeof(value));
+            return text_format_fixed(text, value, (precision > TEXT_FLOAT_MAX_PRECISION) ? TEXT_FLOAT_MAX_PRECISION : precision);
+        }
+
+    if (ieee_exponent == 0 && ieee_mantissa == 0)
+        {
+            *text++ = '0';
+            return text;
+        }
+
+    float_shortest_decimal(ieee_mantissa, ieee_exponent, &digits, &exponent);
+    return text_format_decimal(text, digits, exponent);
+}
+
+/* messages of the current thread are appended to this buffer instead of stdout when it is set (batch mode) */
+static THREAD_LOCAL solid_buffer_t *report_capture = NULL;
+
+/* append a formatted message to the capture buffer of the current thread */
+void report_capture_vprintf(const char *format, va_list arguments)
+{
+    char message[2048];
+    int length = 0;
+    unsigned char *appended = NULL;
+
+    length = vsnprintf(message, sizeof(message), format, arguments);
+    if (length < 0)
+        return;
+    if ((size_t) length >= sizeof(message))
+        length = sizeof(message) - 1;
+
+    appended = solid_buffer_append(report_capture, length);
+    if (appended != NULL)
+        memcpy(appended, message, length);
+}
+
+/* capture the messages of the current thread in a buffer instead of printing them (NULL to print them again), returns the previous buffer */
+solid_buffer_t * report_set_capture(solid_buffer_t *buffer)
+{
+    solid_buffer_t *previous_capture = report_capture;
+
+    report_capture = buffer;
+    return previous_capture;
+}
+
+/* report an error (captured per file in batch mode) */
+void report_error(const char *format, ...)
+{
+    va_list arguments;
+
+    va_start(arguments, format);
+    if (report_capture != NULL)
+        report_capture_vprintf(format, arguments);
+    else
+        vprintf(format, arguments);
+    va_end(arguments);
+}
+
+/* report a warning : the conversion goes on (shown in batch mode too, with the messages of its file) */
+void report_warning(const char *format, ...)
+{
+    va_list arguments;
+
+    va_start(arguments, format);
+    if (report_capture != NULL)
+        report_capture_vprintf(format, arguments);
+    else
+        vprintf(format, arguments);
+    va_end(arguments);
+}
+
+/* report progress information (silent in batch mode) */
+void report_info(const char *format, ...)
+{
+    va_list arguments;
+
+    if (report_capture != NULL)
+        return;
+
+    va_start(arguments, format);
+    vprintf(format, arguments);
+    va_end(arguments);
+}
+
+/* report again the messages captured by another thread (kept in the capture buffer of the current thread if there is one) */
+void report_replay(const solid_buffer_t *messages)
+{
+    unsigned char *appended = NULL;
+
+    if (messages->used == 0)
+        return;
+
+    if (report_capture != NULL)
+        {
+            appended = solid_buffer_append(report_capture, messages->used);
+            if (appended != NULL)
+                memcpy(appended, messages->data, messages->used);
+        }
+    else
+        {
+            fwrite(messages->data, 1, messages->used, stdout);
+        }
+}
+
+/* stage of the current thread and when it started */
+static THREAD_LOCAL int stats_stage = STATS_STAGE_NONE;
+static THREAD_LOCAL uint64_t stats_stage_start = 0;
+
+/* names of the stages and of the keywords in the tables and JSON written */
+static const char *stats_stage_names[STATS_STAGES_COUNT] = { "open", "read", "parse", "dedup", "optimize", "normals", "format", "write" };
+static const char *stats_keyword_names[STATS_KEYWORDS_COUNT] = { "v", "vt", "vn", "f", "usemtl", "mtllib", "newmtl", "Kd", "other" };
+
+/* set all the durations and counters of statistics to 0 */
+void conversion_stats_init(conversion_stats_t *stats)
+{
+    memset(stats, 0, sizeof(conversion_stats_t));
+}
+
+/* add the durations and counters of the conversions of every thread to "stats" (NULL to stop), returns the previous statistics */
+conversion_stats_t * stats_set_capture(conversion_stats_t *stats)
+{
+    conversion_stats_t *previous_stats = stats_capture;
+
+    stats_capture = stats;
+    return previous_stats;
+}
+
+/* monotonic clock in nanoseconds */
+uint64_t stats_clock(void)
+{
+#ifndef _WIN32
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+#else
+    return (uint64_t) clock() * (1000000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+/* end the stage of the current thread and start another one (STATS_STAGE_NONE to start none), returns the stage ended */
+int stats_enter_stage(int stage)
+{
+    int previous_stage = stats_stage;
+    uint64_t now = 0;
+
+    if (stats_capture == NULL)
+        return STATS_STAGE_NONE;
+
+    now = stats_clock();
+    if (previous_stage != STATS_STAGE_NONE)
+        ATOMIC_ADD_64(&stats_capture->stage_nanoseconds[previous_stage], now - stats_stage_start);
+
+    stats_stage = stage;
+    stats_stage_start = now;
+    return previous_stage;
+}
+
+/* add the lines counted for each keyword to the statistics being captured */
+void stats_add_keyword_lines(const int *keyword_lines)
+{
+    int keyword = 0;
+
+    for (keyword = 0; keyword < STATS_KEYWORDS_COUNT; keyword++)
+        {
+            if (keyword_lines[keyword] > 0)
+                STATS_ADD(keyword_lines[keyword], keyword_lines[keyword]);
+        }
+}
+
+/* largest memory used by the process so far in kB (-1 if unknown) */
+long stats_peak_memory_kb(void)
+{
+#ifndef _WIN32
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+    return -1;
+}
+
+/* write statistics as a table or as JSON (returns 0 on error) */
+int conversion_stats_format(const conversion_stats_t *stats, int as_json, solid_buffer_t *buffer)
+{
+    uint64_t total_nanoseconds = 0;
+    int stage = 0;
+    int keyword = 0;
+    int result = 1;
+
+    for (stage = 0; stage < STATS_STAGES_COUNT; stage++)
+        total_nanoseconds += stats->stage_nanoseconds[stage];
+
+    if (as_json)
+        {
+            result &= solid_buffer_printf(buffer, "{\n  \"seconds\": {");
+            for (stage = 0; stage < STATS_STAGES_COUNT; stage++)
+                result &= solid_buffer_printf(buffer, "%s\"%s\": %.6f", (stage > 0) ? ", " : "", stats_stage_names[stage], stats->stage_nanoseconds[stage] / 1e9);
+            result &= solid_buffer_printf(buffer, ", \"total\": %.6f},\n  \"lines\": {", total_nanoseconds / 1e9);
+            for (keyword = 0; keyword < STATS_KEYWORDS_COUNT; keyword++)
+                result &= solid_buffer_printf(buffer, "%s\"%s\": %llu", (keyword > 0) ? ", " : "", stats_keyword_names[keyword], (unsigned long long) stats->keyword_lines[keyword]);
+            result &= solid_buffer_printf(buffer, "},\n  \"bytes_read\": %llu,\n  \"bytes_written\": %llu,\n  \"reallocs\": %llu,\n  \"hash_probes\": %llu,\n  \"cache_hits\": %llu,\n  \"cache_misses\": %llu,\n  \"peak_memory_kb\": %ld\n}\n",
+                                          (unsigned long long) stats->bytes_read, (unsigned long long) stats->bytes_written,
+                                          (unsigned long long) stats->reallocs, (unsigned long long) stats->hash_probes,
+                                          (unsigned long long) stats->cache_hits, (unsigned long long) stats->cache_misses, stats_peak_memory_kb());
+        }
+    else
+        {
+            result &= solid_buffer_printf(buffer, "%-10s %12s %7s\n", "stage", "seconds", "share");
+            for (stage = 0; stage < STATS_STAGES_COUNT; stage++)
+                result &= solid_buffer_printf(buffer, "%-10s %12.6f %6.1f%%\n", stats_stage_names[stage], stats->stage_nanoseconds[stage] / 1e9,
+                                              (total_nanoseconds > 0) ? 100.0 * stats->stage_nanoseconds[stage] / total_nanoseconds : 0.0);
+            result &= solid_buffer_printf(buffer, "%-10s %12.6f\n\n", "total", total_nanoseconds / 1e9);
+            for (keyword = 0; keyword < STATS_KEYWORDS_COUNT; keyword++)
+                result &= solid_buffer_printf(buffer, "%-16s : %llu\n", stats_keyword_names[keyword], (unsigned long long) stats->keyword_lines[keyword]);
+            result &= solid_buffer_printf(buffer, "%-16s : %llu\n%-16s : %llu\n%-16s : %llu\n%-16s : %llu\n%-16s : %llu\n%-16s : %llu\n%-16s : %ld\n",
+                                          "bytes read", (unsigned long long) stats->bytes_read, "bytes written", (unsigned long long) stats->bytes_written,
+                                          "reallocs", (unsigned long long) stats->reallocs, "hash probes", (unsigned long long) stats->hash_probes,
+                                          "cache hits", (unsigned long long) stats->cache_hits, "cache misses", (unsigned long long) stats->cache_misses,
+                                          "peak memory kB", stats_peak_memory_kb());
+        }
+
+    return result;
+}
+
+/* arena of the current thread, meshes and material tables are allocated with malloc when it is not set */
+static THREAD_LOCAL solid_arena_t *arena_current = NULL;
+
+/* size of the header of an arena block, the memory following it stays aligned */
+#define SOLID_ARENA_HEADER_SIZE ((sizeof(solid_arena_block_t) + SOLID_ARENA_ALIGNMENT - 1) & ~(size_t) (SOLID_ARENA_ALIGNMENT - 1))
+
+/* allocations grown past this size get a block of their own, grown with realloc afterwards instead of being copied */
+#define SOLID_ARENA_OWN_BLOCK_MIN_SIZE (SOLID_ARENA_BLOCK_SIZE / 8)
+
+/* init an empty arena */
+void solid_arena_init(solid_arena_t *arena)
+{
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->last_allocation = NULL;
+}
+
+/* free all the blocks of an arena */
+void solid_arena_free(solid_arena_t *arena)
+{
+    solid_arena_block_t *block = arena->first;
+    solid_arena_block_t *next_block = NULL;
+
+    while (block != NULL)
+        {
+            next_block = block->next;
+            free(block);
+            block = next_block;
+        }
+
+    solid_arena_init(arena);
+}
+
+/* give back at once all the memory of an arena (its blocks are kept for the next conversion) */
+void solid_arena_reset(solid_arena_t *arena)
+{
+    /* the blocks after the current one are emptied when they become current */
+    arena->current = arena->first;
+    if (arena->current != NULL)
+        arena->current->used = 0;
+    arena->last_allocation = NULL;
+}
+
+/* allocate "size" bytes in an arena (NULL on error) */
+void * solid_arena_alloc(solid_arena_t *arena, size_t size)
+{
+    solid_arena_block_t *block = arena->current;
+    solid_arena_block_t *new_block = NULL;
+    size_t block_size = 0;
+
+    size = (size + SOLID_ARENA_ALIGNMENT - 1) & ~(size_t) (SOLID_ARENA_ALIGNMENT - 1);
+    if (size == 0)
+        size = SOLID_ARENA_ALIGNMENT;
+
+    if (block == NULL || block->size - block->used < size)
+        {
+            /* the next blocks are empty, those too small are skipped until the arena is reset */
+            block = (block != NULL) ? block->next : NULL;
+            while (block != NULL && block->size < size)
+                block = block->next;
+
+            if (block == NULL)
+                {
+                    /* big allocations get a block of their own */
+                    block_size = (size > SOLID_ARENA_BLOCK_SIZE) ? size : SOLID_ARENA_BLOCK_SIZE;
+                    new_block = (solid_arena_block_t *) malloc(SOLID_ARENA_HEADER_SIZE + block_size);
+                    if (new_block == NULL)
+                        return NULL;
+                    new_block->size = block_size;
+                    if (arena->current == NULL)
+                        {
+                            new_block->next = arena->first;
+                            arena->first = new_block;
+                        }
+                    else
+                        {
+                            new_block->next = arena->current->next;
+                            arena->current->next = new_block;
+                        }
+                    block = new_block;
+                }
+
+            block->used = 0;
+            arena->current = block;
+        }
+
+    arena->last_allocation = (unsigned char *) block + SOLID_ARENA_HEADER_SIZE + block->used;
+    block->used += size;
+    return arena->last_allocation;
+}
+
+/* allocate "size" bytes in a block of their own, put before the current block of an arena so that nothing else goes in it until the arena is reset
+   (NULL on error) */
+void * solid_arena_alloc_block(solid_arena_t *arena, size_t size)
+{
+    solid_arena_block_t *new_block = NULL;
+    solid_arena_block_t *previous_block = NULL;
+
+    size = (size + SOLID_ARENA_ALIGNMENT - 1) & ~(size_t) (SOLID_ARENA_ALIGNMENT - 1);
+    new_block = (solid_arena_block_t *) malloc(SOLID_ARENA_HEADER_SIZE + size);
+    if (new_block == NULL)
+        return NULL;
+    new_block->size = size;
+    new_block->used = size;
+
+    if (arena->current == NULL)
+        {
+            /* full, the next allocation starts another block after it */
+            new_block->next = arena->first;
+            arena->first = new_block;
+            arena->current = new_block;
+        }
+    else if (arena->first == arena->current)
+        {
+            new_block->next = arena->first;
+            arena->first = new_block;
+        }
+    else
+        {
+            previous_block = arena->first;
+            while (previous_block->next != arena->current)
+                previous_block = previous_block->next;
+            new_block->next = arena->current;
+            previous_block->next = new_block;
+        }
+
+    return (unsigned char *) new_block + SOLID_ARENA_HEADER_SIZE;
+}
+
+/* grow the block holding a single allocation of an arena with realloc (NULL if the allocation shares its block or on error) */
+void * solid_arena_grow_block(solid_arena_t *arena, void *pointer, size_t old_size, size_t new_size)
+{
+    solid_arena_block_t *block = (solid_arena_block_t *) ((unsigned char *) pointer - SOLID_ARENA_HEADER_SIZE);
+    solid_arena_block_t *previous_block = NULL;
+    solid_arena_block_t *new_block = NULL;
+
+    old_size = (old_size + SOLID_ARENA_ALIGNMENT - 1) & ~(size_t) (SOLID_ARENA_ALIGNMENT - 1);
+    if (old_size < SOLID_ARENA_OWN_BLOCK_MIN_SIZE)
+        return NULL;
+
+    /* only blocks of the arena starting with this allocation and holding nothing else can be moved */
+    if (arena->first != block)
+        {
+            previous_block = arena->first;
+            while (previous_block != NULL && previous_block->next != block)
+                previous_block = previous_block->next;
+            if (previous_block == NULL)
+                return NULL;
+        }
+    if (block->used != old_size || block->size >= new_size)
+        return NULL;
+
+    new_block = (solid_arena_block_t *) realloc(block, SOLID_ARENA_HEADER_SIZE + new_size);
+    if (new_block == NULL)
+        return NULL;
+    new_block->size = new_size;
+    new_block->used = new_size;
+
+    if (previous_block == NULL)
+        arena->first = new_block;
+    else
+        previous_block->next = new_block;
+    if (arena->current == block)
+        arena->current = new_block;
+    if (arena->last_allocation == (unsigned char *) pointer)
+        arena->last_allocation = (unsigned char *) new_block + SOLID_ARENA_HEADER_SIZE;
+
+    return (unsigned char *) new_block + SOLID_ARENA_HEADER_SIZE;
+}
+
+/* grow an allocation of an arena (in place if it is the last one and its block has room, big allocations are moved to a block of their own
+   grown with realloc, NULL on error) */
+void * solid_arena_realloc(solid_arena_t *arena, void *pointer, size_t old_size, size_t new_size)
+{
+    solid_arena_block_t *block = arena->current;
+    size_t offset = 0;
+    void *new_pointer = NULL;
+
+    if (pointer == NULL)
+        return solid_arena_alloc(arena, new_size);
+    if (new_size <= old_size)
+        return pointer;
+
+    new_size = (new_size + SOLID_ARENA_ALIGNMENT - 1) & ~(size_t) (SOLID_ARENA_ALIGNMENT - 1);
+    if ((unsigned char *) pointer == arena->last_allocation)
+        {
+            offset = arena->last_allocation - ((unsigned char *) block + SOLID_ARENA_HEADER_SIZE);
+            if (block->size - offset >= new_size)
+                {
+                    block->used = offset + new_size;
+                    return pointer;
+                }
+        }
+
+    new_pointer = solid_arena_grow_block(arena, pointer, old_size, new_size);
+    if (new_pointer != NULL)
+        return new_pointer;
+
+    /* the old memory is only given back when the arena is reset */
+    if (new_size >= SOLID_ARENA_OWN_BLOCK_MIN_SIZE)
+        new_pointer = solid_arena_alloc_block(arena, new_size);
+    else
+        new_pointer = solid_arena_alloc(arena, new_size);
+    if (new_pointer != NULL)
+        memcpy(new_pointer, pointer, old_size);
+    return new_pointer;
+}
+
+/* allocate the meshes and material tables created by the current thread in an arena (NULL to use malloc again), returns the previous arena */
+solid_arena_t * solid_arena_set_current(solid_arena_t *arena)
+{
+    solid_arena_t *previous_arena = arena_current;
+
+    arena_current = arena;
+    return previous_arena;
+}
+
+/* arena of the current thread (NULL if there is none) */
+solid_arena_t * solid_arena_current(void)
+{
+    return arena_current;
+}
+
+/* allocate memory in an arena or with malloc if there is none */
+void * memory_alloc(solid_arena_t *arena, size_t size)
+{
+    if (arena != NULL)
+        return solid_arena_alloc(arena, size);
+
+    return malloc(size);
+}
+
+/* allocate memory set to 0 in an arena or with calloc if there is none */
+void * memory_calloc(solid_arena_t *arena, size_t count, size_t size)
+{
+    void *pointer = NULL;
+
+    if (arena == NULL)
+        return calloc(count, size);
+
+    if (size > 0 && count > (size_t) -1 / size)
+        return NULL;
+    pointer = solid_arena_alloc(arena, count * size);
+    if (pointer != NULL)
+        memset(pointer, 0, count * size);
+    return pointer;
+}
+
+/* grow memory allocated by memory_alloc */
+void * memory_realloc(solid_arena_t *arena, void *pointer, size_t old_size, size_t new_size)
+{
+    if (arena != NULL)
+        return solid_arena_realloc(arena, pointer, old_size, new_size);
+
+    return realloc(pointer, new_size);
+}
+
+/* free memory allocated by memory_alloc (nothing to do in an arena, it is reset as a whole) */
+void memory_free(solid_arena_t *arena, void *pointer)
+{
+    if (arena == NULL)
+        free(pointer);
+}
+
+/* run the jobs of a pool until there is none left, taking the next one each time (thread entry point of threads_run_jobs) */
+void * threads_pool_worker(void *data)
+{
+    threads_pool_t *pool = (threads_pool_t *) data;
+    unsigned int job_index = 0;
+
+    while (1)
+        {
+            job_index = ATOMIC_ADD_32(&pool->next_job, 1);
+            if (job_index >= (unsigned int) pool->jobs_count)
+                break;
+            pool->function((char *) pool->jobs + pool->job_size * job_index);
+        }
+
+    return NULL;
+}
+
+/* run "function" on each job of an array with at most "threads_count" threads taking the jobs in turn (the calling thread is one of them) */
+void threads_run_jobs(void * (*function)(void *), void *jobs, size_t job_size, int jobs_count, int threads_count)
+{
+    threads_pool_t pool;
+#ifndef _WIN32
+    pthread_t *threads = NULL;
+    int threads_started = 0;
+    int thread_index = 0;
+#endif
+
+    pool.function = function;
+    pool.jobs = jobs;
+    pool.job_size = job_size;
+    pool.jobs_count = jobs_count;
+    pool.next_job = 0;
+
+#ifndef _WIN32
+    if (threads_count > jobs_count)
+        threads_count = jobs_count;
+    threads = (threads_count > 1) ? (pthread_t *) malloc(sizeof(pthread_t) * (threads_count - 1)) : NULL;
+    if (threads != NULL)
+        {
+            /* threads that could not be started leave their jobs to the others */
+            for (thread_index = 0; thread_index < threads_count - 1; thread_index++)
+                {
+                    if (pthread_create(&threads[threads_started], NULL, threads_pool_worker, &pool) == 0)
+                        threads_started++;
+                }
+        }
+
+    threads_pool_worker(&pool);
+
+    for (thread_index = 0; thread_index < threads_started; thread_index++)
+        pthread_join(threads[thread_index], NULL);
+    if (threads != NULL)
+        free(threads);
+#else
+    /* no threads on this platform, jobs are run one after the other */
+    (void) threads_count;
+    threads_pool_worker(&pool);
+#endif
+}
+
+/* capacity needed by an array to hold at least "needed" elements (grows geometrically, up to INT_MAX) */
+int obj_array_capacity(int allocated, int needed)
+{
+    int new_allocated = 0;
+
+    /* double the capacity to keep the cost of the reallocations amortized, without going past INT_MAX */
+    new_allocated = (allocated > 0) ? allocated : 16;
+    while (new_allocated < needed)
+        new_allocated = (new_allocated > INT_MAX / 2) ? INT_MAX : new_allocated * 2;
+
+    return new_allocated;
+}
+
+/* make sure a obj mesh array can hold at least "needed" elements (allocated in "arena" if it is not NULL) */
+int obj_array_reserve(solid_arena_t *arena, void **buffer, int *allocated, int needed, size_t element_size)
+{
+    void *new_buffer = NULL;
+    int new_allocated = 0;
+
+    if (needed <= *allocated)
+        return 1;
+
+    new_allocated = obj_array_capacity(*allocated, needed);
+
+    /* sizes that don't fit in a size_t (32 bit targets) can't be allocated */
+    if ((size_t) new_allocated > (size_t) -1 / element_size)
+        return 0;
+
+    new_buffer = memory_realloc(arena, *buffer, element_size * *allocated, element_size * new_allocated);
+    if (new_buffer == NULL)
+        return 0;
+
+    *buffer = new_buffer;
+    *allocated = new_allocated;
+    STATS_ADD(reallocs, 1);
+    return 1;
+}
+
+/* make sure the face arrays of a obj mesh can hold at least "needed" faces */
+int obj_faces_reserve(obj_mesh_t *obj_mesh, int needed)
+{
+    int *new_buffer = NULL;
+    int new_allocated = 0;
+
+    if (needed <= obj_mesh->faces_allocated)
+        return 1;
+
+    new_allocated = obj_array_capacity(obj_mesh->faces_allocated, needed);
+    if ((size_t) new_allocated >= (size_t) -1 / sizeof(int))
+        return 0;
+
+    /* one more offset to store the end of the last face */
+    new_buffer = (int *) memory_realloc(obj_mesh->arena, obj_mesh->face_offsets, sizeof(int) * ((size_t) obj_mesh->faces_allocated + 1), sizeof(int) * ((size_t) new_allocated + 1));
+    if (new_buffer == NULL)
+        return 0;
+    obj_mesh->face_offsets = new_buffer;
+
+    new_buffer = (int *) memory_realloc(obj_mesh->arena, obj_mesh->face_materials, sizeof(int) * obj_mesh->faces_allocated, sizeof(int) * new_allocated);
+    if (new_buffer == NULL)
+        return 0;
+    obj_mesh->face_materials = new_buffer;
+
+    obj_mesh->faces_allocated = new_allocated;
+    STATS_ADD(reallocs, 1);
+    return 1;
+}
+
+/* make sure the corner arrays of a obj mesh can hold at least "needed" corners */
+int obj_corners_reserve(obj_mesh_t *obj_mesh, int needed)
+{
+    int *new_buffer = NULL;
+    int new_allocated = 0;
+
+    if (needed <= obj_mesh->corners_allocated)
+        return 1;
+
+    new_allocated = obj_array_capacity(obj_mesh->corners_allocated, needed);
+    if ((size_t) new_allocated > (size_t) -1 / sizeof(int))
+        return 0;
+
+    new_buffer = (int *) memory_realloc(obj_mesh->arena, obj_mesh->corner_vertices, sizeof(int) * obj_mesh->corners_allocated, sizeof(int) * new_allocated);
+    if (new_buffer == NULL)
+        return 0;
+    obj_mesh->corner_vertices = new_buffer;
+
+    /* texture and normal indexes are only stored once a face uses them */
+    if (obj_mesh->corner_textures != NULL)
+        {
+            new_buffer = (int *) memory_realloc(obj_mesh->arena, obj_mesh->corner_textures, sizeof(int) * obj_mesh->corners_allocated, sizeof(int) * new_allocated);
+            if (new_buffer == NULL)
+                return 0;
+            obj_mesh->corner_textures = new_buffer;
+        }
+
+    if (obj_mesh->corner_normals != NULL)
+        {
+            new_buffer = (int *) memory_realloc(obj_mesh->arena, obj_mesh->corner_normals, sizeof(int) * obj_mesh->corners_allocated, sizeof(int) * new_allocated);
+            if (new_buffer == NULL)
+                return 0;
+            obj_mesh->corner_normals = new_buffer;
+        }
+
+    obj_mesh->corners_allocated = new_allocated;
+    STATS_ADD(reallocs, 1);
+    return 1;
+}
+
+/* reserve memory for the given number of vertices, faces and materials in a obj mesh (counts are not changed) */
+int obj_mesh_reserve(obj_mesh_t *obj_mesh, int vertices, int faces, int materials)
+{
+    if (obj_mesh == NULL)
+        return 0;
+
+    if (!obj_array_reserve(obj_mesh->arena, (void **) &obj_mesh->vertices, &obj_mesh->vertices_allocated, vertices, sizeof(obj_vertex_t)))
+        {
+            report_error("Error : can't reserve %d vertices in function obj_mesh_reserve !\n", vertices);
+            return 0;
+        }
+
+    /* faces are expected to be triangles */
+    if (!obj_faces_reserve(obj_mesh, faces) || !obj_corners_reserve(obj_mesh, faces * 3))
+        {
+            report_error("Error : can't reserve %d faces in function obj_mesh_reserve !\n", faces);
+            return 0;
+        }
+
+    if (!obj_array_reserve(obj_mesh->arena, (void **) &obj_mesh->materials, &obj_mesh->materials_allocated, materials, sizeof(obj_material_t)))
+        {
+            report_error("Error : can't reserve %d materials in function obj_mesh_reserve !\n", materials);
+            return 0;
+        }
+
+    return 1;
+}
+
+/* create a new vertex in a obj mesh and return its handle */
+obj_vertex_t * obj_add_vertex(obj_mesh_t *obj_mesh)
+{
+    obj_vertex_t *new_vertex = NULL;
+
+    if (obj_mesh == NULL)
+        return NULL;
+
+    /* reserved memory is full or has not yet been created */
+    if (!obj_array_reserve(obj_mesh->arena, (void **) &obj_mesh->vertices, &obj_mesh->vertices_allocated, obj_mesh->vertices_used + 1, sizeof(obj_vertex_t)))
+        {
+            report_error("Error : can't realloc vertices buffer in function obj_add_vertex !\n");
+            return NULL;
+        }
+
+    new_vertex = obj_mesh->vertices + obj_mesh->vertices_used;
+    obj_mesh->vertices_used++;
+    return new_vertex;
+}
+
+/* start a new (empty) face in a obj mesh and return its index (-1 on error) */
+int obj_add_face(obj_mesh_t *obj_mesh, int material_index)
+{
+    if (obj_mesh == NULL)
+        return -1;
+
+    /* reserved memory is full or has not yet been created */
+    if (!obj_faces_reserve(obj_mesh, obj_mesh->faces_used + 1))
+        {
+            report_error("Error : can't realloc faces buffer in function obj_add_face !\n");
+            return -1;
+        }
+
+    obj_mesh->face_offsets[obj_mesh->faces_used] = obj_mesh->corners_used;
+    obj_mesh->face_materials[obj_mesh->faces_used] = material_index;
+    obj_mesh->faces_used++;
+    obj_mesh->face_offsets[obj_mesh->faces_used] = obj_mesh->corners_used;
+
+    return obj_mesh->faces_used - 1;
+}
+
+/* allocate the texture or normal indexes of the corners already stored (they are set to 0) */
+int * obj_corner_indexes_create(obj_mesh_t *obj_mesh)
+{
+    int *indexes = NULL;
+
+    indexes = (int *) memory_calloc(obj_mesh->arena, obj_mesh->corners_allocated, sizeof(int));
+    if (indexes == NULL)
+        report_error("Error : can't allocate corner indexes in function obj_corner_indexes_create !\n");
+
+    return indexes;
+}
+
+/* append a corner to the last face of a obj mesh (texture and normal are 0 if absent) */
+int obj_add_face_corner(obj_mesh_t *obj_mesh, int vertex, int texture, int normal)
+{
+    int corner_index = 0;
+
+    if (obj_mesh == NULL || obj_mesh->faces_used == 0)
+        return 0;
+
+    /* reserved memory is full or has not yet been created */
+    if (!obj_corners_reserve(obj_mesh, obj_mesh->corners_used + 1))
+        {
+            report_error("Error : can't realloc corners buffer in function obj_add_face_corner !\n");
+            return 0;
+        }
+
+    if (texture != 0 && obj_mesh->corner_textures == NULL)
+        {
+            obj_mesh->corner_textures = obj_corner_indexes_create(obj_mesh);
+            if (obj_mesh->corner_textures == NULL)
+                return 0;
+        }
+
+    if (normal != 0 && obj_mesh->corner_normals == NULL)
+        {
+            obj_mesh->corner_normals = obj_corner_indexes_create(obj_mesh);
+            if (obj_mesh->corner_normals == NULL)
+                return 0;
+        }
+
+    corner_index = obj_mesh->corners_used;
+    obj_mesh->corner_vertices[corner_index] = vertex;
+    if (obj_mesh->corner_textures != NULL)
+        obj_mesh->corner_textures[corner_index] = texture;
+    if (obj_mesh->corner_normals != NULL)
+        obj_mesh->corner_normals[corner_index] = normal;
+
+    obj_mesh->corners_used++;
+    obj_mesh->face_offsets[obj_mesh->faces_used] = obj_mesh->corners_used;
+
+    return 1;
+}
+
+/* number of corners of a face */
+int obj_face_corner_count(const obj_mesh_t *obj_mesh, int face_index)
+{
+    return obj_mesh->face_offsets[face_index + 1] - obj_mesh->face_offsets[face_index];
+}
+
+/* create a new material in a obj mesh and return its handle */
+obj_material_t * obj_add_material(obj_mesh_t *obj_mesh)
+{
+    obj_material_t *new_material = NULL;
+
+    if (obj_mesh == NULL)
+        return NULL;
+
+    /* reserved memory is full or has not yet been created */
+    if (!obj_array_reserve(obj_mesh->arena, (void **) &obj_mesh->materials, &obj_mesh->materials_allocated, obj_mesh->materials_used + 1, sizeof(obj_material_t)))
+        {
+            report_error("Error : can't realloc materials buffer in function obj_add_material !\n");
+            return NULL;
+        }
+
+    new_material = obj_mesh->materials + obj_mesh->materials_used;
+    obj_mesh->materials_used++;
+    return new_material;
+}
+
+/* create a new obj mesh in memory (in the arena of the current thread if it has one) */
+obj_mesh_t * obj_mesh_create(char *filename)
+{
+    obj_mesh_t *obj_mesh = NULL;
+    solid_arena_t *arena = solid_arena_current();
+
+    obj_mesh = (obj_mesh_t *) memory_alloc(arena, sizeof(obj_mesh_t));
+
+    if (obj_mesh == NULL)
+        {
+            report_error("Error : can't allocate obj_mesh_t in function obj_mesh_create !\n");
+            return NULL;
+        }
+
+    /* init filename */
+    strncpy(obj_mesh->filename, filename, 1024);
+
+    /* init material filename (we need to parse the file to get the real name of the mat file) */
+    memset(obj_mesh->material_filename,'\0', 1024);
+
+    /* init vertices */
+    obj_mesh->vertices = NULL;
+    obj_mesh->vertices_used = 0;
+    obj_mesh->vertices_allocated = 0;
+
+    /* init faces */
+    obj_mesh->face_offsets = NULL;
+    obj_mesh->face_materials = NULL;
+    obj_mesh->faces_used = 0;
+    obj_mesh->faces_allocated = 0;
+    obj_mesh->corner_vertices = NULL;
+    obj_mesh->corner_textures = NULL;
+    obj_mesh->corner_normals = NULL;
+    obj_mesh->corners_used = 0;
+    obj_mesh->corners_allocated = 0;
+
+    /* init materials */
+    obj_mesh->materials = NULL;
+    obj_mesh->materials_used = 0;
+    obj_mesh->materials_allocated = 0;
+    obj_mesh->material_slots = NULL;
+    obj_mesh->material_slots_count = 0;
+
+    /* everything else of the mesh goes in the same arena */
+    obj_mesh->arena = arena;
+
+    return obj_mesh;
+}
+
+/* free a obj mesh from memory */
+void obj_mesh_free(obj_mesh_t *obj_mesh)
+{
+    if (obj_mesh == NULL)
+        return;
+
+    if (obj_mesh->vertices != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->vertices);
+
+    if (obj_mesh->face_offsets != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->face_offsets);
+
+    if (obj_mesh->face_materials != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->face_materials);
+
+    if (obj_mesh->corner_vertices != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->corner_vertices);
+
+    if (obj_mesh->corner_textures != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->corner_textures);
+
+    if (obj_mesh->corner_normals != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->corner_normals);
+
+    if (obj_mesh->materials != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->materials);
+
+    if (obj_mesh->material_slots != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->material_slots);
+
+    memory_free(obj_mesh->arena, obj_mesh);
+}
+
+/* length of the directory part of a path (up to and including its last separator) */
+size_t path_directory_length(const char *path)
+{
+    size_t length = strlen(path);
+
+    while (length > 0 && path[length - 1] != '/' && path[length - 1] != '\\')
+        length--;
+
+    return length;
+}
+
+/* "path" as seen from the directory of "file_path" (the directory is only stripped when both share it) */
+const char * path_relative_to_file(const char *path, const char *file_path)
+{
+    size_t directory_length = path_directory_length(file_path);
+
+    if (directory_length == path_directory_length(path) && strncmp(path, file_path, directory_length) == 0)
+        return path + directory_length;
+
+    return path;
+}
+
+/* open a file and map its whole content in memory (read only) */
+int mapped_file_open(mapped_file_t *mapped_file, const char *path)
+{
+#ifdef _WIN32
+    FILE *file = NULL;
+    struct stat file_stat;
+    long size = 0;
+    int previous_stage = STATS_STAGE_NONE;
+
+    mapped_file->data = NULL;
+    mapped_file->size = 0;
+    mapped_file->is_mapped = 0;
+    mapped_file->time = 0;
+    previous_stage = stats_enter_stage(STATS_STAGE_OPEN);
+
+    /* no mmap here, read the whole file in a single buffer instead */
+    file = fopen(path, "rb");
+    if (file == NULL)
+        {
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0)
+        {
+            fclose(file);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+    if (stat(path, &file_stat) == 0)
+        mapped_file->time = (long long) file_stat.st_mtime;
+
+    stats_enter_stage(STATS_STAGE_READ);
+    if (size > 0)
+        {
+            mapped_file->data = (char *) malloc(size);
+            if (mapped_file->data == NULL || fread(mapped_file->data, size, 1, file) != 1)
+                {
+                    report_error("Error : can't read '%s' in function mapped_file_open !\n", path);
+                    free(mapped_file->data);
+                    mapped_file->data = NULL;
+                    fclose(file);
+                    stats_enter_stage(previous_stage);
+                    return 0;
+                }
+        }
+    mapped_file->size = size;
+
+    fclose(file);
+    STATS_ADD(bytes_read, size);
+    stats_enter_stage(previous_stage);
+    return 1;
+#else
+    int fd = -1;
+    struct stat file_stat;
+    void *data = NULL;
+    int previous_stage = STATS_STAGE_NONE;
+
+    mapped_file->data = NULL;
+    mapped_file->size = 0;
+    mapped_file->is_mapped = 0;
+    mapped_file->time = 0;
+    previous_stage = stats_enter_stage(STATS_STAGE_OPEN);
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        {
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+
+    if (fstat(fd, &file_stat) != 0)
+        {
+            close(fd);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+
+    mapped_file->time = (long long) file_stat.st_mtime;
+
+    /* an empty file can't be mapped but is still a valid (empty) input */
+    stats_enter_stage(STATS_STAGE_READ);
+    if (file_stat.st_size > 0)
+        {
+            data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+                {
+                    report_error("Error : can't map '%s' in function mapped_file_open !\n", path);
+                    close(fd);
+                    stats_enter_stage(previous_stage);
+                    return 0;
+                }
+            madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+            mapped_file->data = (char *) data;
+            mapped_file->size = file_stat.st_size;
+            mapped_file->is_mapped = 1;
+        }
+
+    /* the mapping stays valid once the descriptor is closed */
+    close(fd);
+    STATS_ADD(bytes_read, mapped_file->size);
+    stats_enter_stage(previous_stage);
+    return 1;
+#endif
+}
+
+/* release a file opened with mapped_file_open */
+void mapped_file_close(mapped_file_t *mapped_file)
+{
+    if (mapped_file->data == NULL)
+        return;
+
+#ifndef _WIN32
+    if (mapped_file->is_mapped)
+        munmap(mapped_file->data, mapped_file->size);
+    else
+#endif
+        free(mapped_file->data);
+
+    mapped_file->data = NULL;
+    mapped_file->size = 0;
+    mapped_file->is_mapped = 0;
+    mapped_file->time = 0;
+}
+
+/* hash of the content of a file opened with mapped_file_open (the one the mesh cache keys and checks files with) */
+uint64_t mapped_file_hash(const mapped_file_t *mapped_file)
+{
+    return hash_xxh64(mapped_file->data, mapped_file->size, 0);
+}
+
+/* state of a file opened with mapped_file_open, "hash" is its mapped_file_hash (state may be NULL) */
+void solid_file_state_set(solid_file_state_t *state, const mapped_file_t *mapped_file, uint64_t hash)
+{
+    if (state == NULL)
+        return;
+
+    state->found = 1;
+    state->size = (uint64_t) mapped_file->size;
+    state->time = mapped_file->time;
+    state->hash = hash;
+}
+
+/* map the material file of an obj file, looked for next to the obj file then relatively to the current directory (material_file_path,
+   1024 bytes or NULL, receives the path opened or "material_filename" if it is found nowhere, returns 0 if it can't be opened) */
+int obj_material_file_open(mapped_file_t *mapped_file, const char *obj_file_path, const char *material_filename, char *material_file_path)
+{
+    char path[1024];
+    size_t directory_length = 0;
+    int result = 0;
+
+    directory_length = path_directory_length(obj_file_path);
+    result = (snprintf(path, sizeof(path), "%.*s%s", (int) directory_length, obj_file_path, material_filename) < (int) sizeof(path)
+              && mapped_file_open(mapped_file, path));
+    if (!result && directory_length > 0 && mapped_file_open(mapped_file, material_filename))
+        {
+            snprintf(path, sizeof(path), "%s", material_filename);
+            result = 1;
+        }
+
+    /* a missing file is named as declared, obj_material_file_exists looks for it in both places again */
+    if (!result)
+        snprintf(path, sizeof(path), "%s", material_filename);
+
+    if (material_file_path != NULL)
+        snprintf(material_file_path, 1024, "%s", path);
+    return result;
+}
+
+/* true if the material file of an obj file can be found where the conversions look for it (next to the obj file, then relatively to the current directory) */
+int obj_material_file_exists(const char *obj_file_path, const char *material_filename)
+{
+    mapped_file_t mapped_file;
+
+    if (!obj_material_file_open(&mapped_file, obj_file_path, material_filename, NULL))
+        return 0;
+
+    mapped_file_close(&mapped_file);
+    return 1;
+}
+
+/* skip spaces and tabs (never goes past the end of the line) */
+const char * obj_skip_blanks(const char *cursor, const char *end)
+{
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r'))
+        cursor++;
+    return cursor;
+}
+
+/* true if the keyword at the start of the line is exactly "keyword" */
+int obj_line_has_keyword(const char *line, const char *end, const char *keyword, size_t keyword_length)
+{
+    if ((size_t) (end - line) < keyword_length || memcmp(line, keyword, keyword_length) != 0)
+        return 0;
+
+    /* the keyword has to be followed by a separator ("v" must not match "vt") */
+    line += keyword_length;
+    return (line == end || *line == ' ' || *line == '\t' || *line == '\r');
+}
+
+/* read a signed decimal integer at the cursor and move the cursor after it (returns 0 if there is no number or if it does not fit in an int) */
+int obj_parse_int(const char **cursor, const char *end, int *value)
+{
+    const char *c = *cursor;
+    int negative = 0;
+    int result = 0;
+
+    if (c < end && (*c == '-' || *c == '+'))
+        {
+            negative = (*c == '-');
+            c++;
+        }
+
+    if (c >= end || *c < '0' || *c > '9')
+        return 0;
+
+    while (c < end && *c >= '0' && *c <= '9')
+        {
+            /* numbers too large for an int are not read (the face using them is dropped) */
+            if (result > (INT_MAX - (*c - '0')) / 10)
+                return 0;
+            result = result * 10 + (*c - '0');
+            c++;
+        }
+
+    *value = negative ? -result : result;
+    *cursor = c;
+    return 1;
+}
+
+/* read a float at the cursor (after optional blanks) and move the cursor after it (returns 0 if there is no number) */
+int obj_parse_float(const char **cursor, const char *end, float *value)
+{
+    char number_buffer[64];
+    const char *start = NULL;
+    char *number_end = NULL;
+    size_t length = 0;
+
+    start = obj_skip_blanks(*cursor, end);
+
+    /* the mapped data is not null terminated, copy the token to convert it */
+    while (start + length < end && length < sizeof(number_buffer) - 1
+            && start[length] != ' ' && start[length] != '\t' && start[length] != '\r' && start[length] != '\n')
+        {
+            number_buffer[length] = start[length];
+            length++;
+        }
+    number_buffer[length] = '\0';
+
+    if (length == 0)
+        return 0;
+
+    *value = strtof(number_buffer, &number_end);
+    if (number_end == number_buffer)
+        return 0;
+
+    *cursor = start + (number_end - number_buffer);
+    return 1;
+}
+
+/* read a "r g b" color at the cursor */
+int obj_parse_color(const char **cursor, const char *end, float *r, float *g, float *b)
+{
+    return obj_parse_float(cursor, end, r)
+           && obj_parse_float(cursor, end, g)
+           && obj_parse_float(cursor, end, b);
+}
+
+/* read a name (up to the next blank) at the cursor into a null terminated buffer */
+int obj_parse_name(const char **cursor, const char *end, char *name, size_t name_size)
+{
+    const char *c = NULL;
+    size_t length = 0;
+
+    c = obj_skip_blanks(*cursor, end);
+    while (c < end && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n')
+        {
+            if (length < name_size - 1)
+                {
+                    name[length] = *c;
+                    length++;
+                }
+            c++;
+        }
+    name[length] = '\0';
+
+    *cursor = c;
+    return (length > 0);
+}
+
+/* parse a face line ("v", "v/t", "v//n" or "v/t/n" groups) in a single pass (chunk is NULL unless parsing a part of a file, returns 0 on memory error only) */
+int obj_read_face(const char *read_line, const char *line_end, obj_mesh_t *obj_mesh, int material_index, obj_chunk_t *chunk)
+{
+    const char *cursor = read_line;
+    int vertex = 0;
+    int texture = 0;
+    int normal = 0;
+    int relative_corners_used = (chunk != NULL) ? chunk->relative_corners_used : 0;
+
+    if (obj_add_face(obj_mesh, material_index) == -1)
+        return 0;
+
+    /* skip the "f" keyword */
+    cursor = obj_skip_blanks(cursor, line_end);
+    if (cursor < line_end && *cursor == 'f')
+        cursor++;
+
+    while (1)
+        {
+            cursor = obj_skip_blanks(cursor, line_end);
+
+            if (!obj_parse_int(&cursor, line_end, &vertex))
+                break;
+
+            texture = 0;
+            normal = 0;
+            if (cursor < line_end && *cursor == '/')
+                {
+                    cursor++;
+                    /* texture index is empty in the "v//n" form */
+                    obj_parse_int(&cursor, line_end, &texture);
+                    if (cursor < line_end && *cursor == '/')
+                        {
+                            cursor++;
+                            obj_parse_int(&cursor, line_end, &normal);
+                        }
+                }
+
+            /* negative indexes are relative to the last vertex read */
+            if (vertex < 0)
+                {
+                    vertex = obj_mesh->vertices_used + vertex + 1;
+
+                    /* the vertices of the previous chunks are only counted by the merge */
+                    if (chunk != NULL)
+                        {
+                            if (!obj_array_reserve(NULL, (void **) &chunk->relative_corners, &chunk->relative_corners_allocated, chunk->relative_corners_used + 1, sizeof(int)))
+                                {
+                                    report_error("Error : can't realloc relative corners buffer in function obj_read_face !\n");
+                                    return 0;
+                                }
+                            chunk->relative_corners[chunk->relative_corners_used++] = obj_mesh->corners_used;
+                        }
+                }
+
+            if (!obj_add_face_corner(obj_mesh, vertex, texture, normal))
+                return 0;
+
+            /* anything else than a separator ends the face */
+            if (cursor >= line_end || (*cursor != ' ' && *cursor != '\t'))
+                break;
+        }
+
+    /* drop faces that can't make a triangle */
+    if (obj_face_corner_count(obj_mesh, obj_mesh->faces_used - 1) < 3)
+        {
+            report_error("Unknown face format\n");
+            obj_mesh->faces_used--;
+            obj_mesh->corners_used = obj_mesh->face_offsets[obj_mesh->faces_used];
+            /* its corners are reused by the next face, the merge must not offset them */
+            if (chunk != NULL)
+                chunk->relative_corners_used = relative_corners_used;
+        }
+
+    return 1;
+}
+
+/* hash a material name (FNV-1a) */
+unsigned int obj_material_name_hash(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    while (*name != '\0')
+        {
+            hash = (hash ^ (unsigned char) *name) * 16777619u;
+            name++;
+        }
+
+    return hash;
+}
+
+/* rebuild the material names hash table with at least twice as many slots as materials */
+int obj_material_slots_rebuild(obj_mesh_t *obj_mesh, int slots_count)
+{
+    int *new_slots = NULL;
+    int slot_index = 0;
+    int material_index = 0;
+
+    new_slots = (int *) memory_alloc(obj_mesh->arena, sizeof(int) * slots_count);
+    if (new_slots == NULL)
+        {
+            report_error("Error : can't allocate material slots in function obj_material_slots_rebuild !\n");
+            return 0;
+        }
+
+    for (slot_index = 0; slot_index < slots_count; slot_index++)
+        new_slots[slot_index] = -1;
+
+    for (material_index = 0; material_index < obj_mesh->materials_used; material_index++)
+        {
+            slot_index = obj_material_name_hash(obj_mesh->materials[material_index].name) & (slots_count - 1);
+            while (new_slots[slot_index] != -1)
+                slot_index = (slot_index + 1) & (slots_count - 1);
+            new_slots[slot_index] = material_index;
+        }
+
+    if (obj_mesh->material_slots != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->material_slots);
+    obj_mesh->material_slots = new_slots;
+    obj_mesh->material_slots_count = slots_count;
+    STATS_ADD(reallocs, 1);
+    return 1;
+}
+
+/* get the index of a material from its name (returns -1 if there is no such material) */
+int obj_get_material_index(obj_mesh_t *obj_mesh, const char *name)
+{
+    int slot_index = 0;
+    int material_index = 0;
+    int probes_count = 1;
+
+    if (obj_mesh == NULL || obj_mesh->material_slots == NULL)
+        return -1;
+
+    slot_index = obj_material_name_hash(name) & (obj_mesh->material_slots_count - 1);
+    while ((material_index = obj_mesh->material_slots[slot_index]) != -1)
+        {
+            if (strcmp(obj_mesh->materials[material_index].name, name) == 0)
+                {
+                    STATS_ADD(hash_probes, probes_count);
+                    return material_index;
+                }
+
+            slot_index = (slot_index + 1) & (obj_mesh->material_slots_count - 1);
+            probes_count++;
+        }
+    STATS_ADD(hash_probes, probes_count);
+
+    return -1;
+}
+
+/* get the index of a material from its name, a black material is created if there is no such material (returns -1 on error) */
+int obj_get_or_add_material(obj_mesh_t *obj_mesh, const char *name)
+{
+    obj_material_t *obj_material = NULL;
+    int material_index = 0;
+    int slot_index = 0;
+
+    material_index = obj_get_material_index(obj_mesh, name);
+    if (material_index != -1)
+        return material_index;
+
+    obj_material = obj_add_material(obj_mesh);
+    if (obj_material == NULL)
+        return -1;
+
+    strncpy(obj_material->name, name, 1023);
+    obj_material->name[1023] = '\0';
+    obj_material->ambient_r = 0.0f;
+    obj_material->ambient_g = 0.0f;
+    obj_material->ambient_b = 0.0f;
+    obj_material->diffuse_r = 0.0f;
+    obj_material->diffuse_g = 0.0f;
+    obj_material->diffuse_b = 0.0f;
+    obj_material->specular_r = 0.0f;
+    obj_material->specular_g = 0.0f;
+    obj_material->specular_b = 0.0f;
+    obj_material->specular_coefficient = 0.0f;
+    material_index = obj_mesh->materials_used - 1;
+
+    /* keep the load factor under 1/2, the new material is indexed by the rebuild */
+    if (obj_mesh->materials_used * 2 > obj_mesh->material_slots_count)
+        {
+            if (!obj_material_slots_rebuild(obj_mesh, obj_mesh->material_slots_count > 0 ? obj_mesh->material_slots_count * 2 : 64))
+                {
+                    obj_mesh->materials_used--;
+                    return -1;
+                }
+            return material_index;
+        }
+
+    slot_index = obj_material_name_hash(name) & (obj_mesh->material_slots_count - 1);
+    while (obj_mesh->material_slots[slot_index] != -1)
+        slot_index = (slot_index + 1) & (obj_mesh->material_slots_count - 1);
+    obj_mesh->material_slots[slot_index] = material_index;
+
+    return material_index;
+}
+
+/* get a material from its name */
+obj_material_t * obj_get_material_by_name(obj_mesh_t *obj_mesh, const char *name)
+{
+    int material_index = 0;
+
+    material_index = obj_get_material_index(obj_mesh, name);
+    if (material_index == -1)
+        return NULL;
+
+    return &obj_mesh->materials[material_index];
+}
+
+/* count the lines starting with a keyword to reserve the obj mesh arrays in one go */
+void obj_mesh_reserve_from_data(obj_mesh_t *obj_mesh, const char *data, size_t size)
+{
+    const char *line = data;
+    const char *end = data + size;
+    const char *line_end = NULL;
+    int vertices = 0;
+    int faces = 0;
+
+    while (line < end)
+        {
+            if (end - line >= 2 && (line[1] == ' ' || line[1] == '\t'))
+                {
+                    if (line[0] == 'v')
+                        vertices++;
+                    else if (line[0] == 'f')
+                        faces++;
+                }
+
+            line_end = (const char *) memchr(line, '\n', end - line);
+            if (line_end == NULL)
+                break;
+            line = line_end + 1;
+        }
+
+    obj_mesh_reserve(obj_mesh, vertices, faces, 0);
+}
+
+/* parse the lines of an obj file or of a part of it (chunk is NULL when parsing a whole file) */
+int obj_mesh_parse_lines(obj_mesh_t *obj_mesh, const char *data, size_t size, obj_chunk_t *chunk)
+{
+    const char *line = data;
+    const char *end = data + size;
+    const char *line_end = NULL;
+    const char *cursor = NULL;
+    obj_vertex_t *obj_vertex = NULL;
+    char current_material_name[1024];
+    int current_material_index = -1;
+    int keyword_lines[STATS_KEYWORDS_COUNT];
+
+    if (obj_mesh == NULL)
+        return 0;
+
+    memset(current_material_name, '\0', 1024);
+    memset(keyword_lines, 0, sizeof(keyword_lines));
+
+    /* faces before the first usemtl of a chunk use the material left by the previous chunks */
+    if (chunk != NULL)
+        current_material_index = OBJ_MATERIAL_INHERITED;
+
+    while (line < end)
+        {
+            line_end = (const char *) memchr(line, '\n', end - line);
+            if (line_end == NULL)
+                line_end = end;
+
+            cursor = obj_skip_blanks(line, line_end);
+
+            /* dispatch on the first byte of the keyword */
+            switch (cursor < line_end ? *cursor : '\0')
+                {
+                /* vertex line */
+                case 'v':
+                    if (obj_line_has_keyword(cursor, line_end, "v", 1))
+                        {
+                            obj_vertex = obj_add_vertex(obj_mesh);
+                            if (obj_vertex == NULL)
+                                return 0;
+                            obj_vertex->x = 0;
+                            obj_vertex->y = 0;
+                            obj_vertex->z = 0;
+                            obj_vertex->w = 0;
+                            cursor++;
+                            if (obj_parse_float(&cursor, line_end, &obj_vertex->x)
+                                    && obj_parse_float(&cursor, line_end, &obj_vertex->y)
+                                    && obj_parse_float(&cursor, line_end, &obj_vertex->z))
+                                {
+                                    obj_parse_float(&cursor, line_end, &obj_vertex->w);
+                                }
+                            keyword_lines[STATS_KEYWORD_V]++;
+                        }
+                    else if (obj_line_has_keyword(cursor, line_end, "vt", 2))
+                        keyword_lines[STATS_KEYWORD_VT]++;
+                    else if (obj_line_has_keyword(cursor, line_end, "vn", 2))
+                        keyword_lines[STATS_KEYWORD_VN]++;
+                    else
+                        keyword_lines[STATS_KEYWORD_OTHER]++;
+                    break;
+
+                /* face line */
+                case 'f':
+                    if (obj_line_has_keyword(cursor, line_end, "f", 1))
+                        {
+                            if (!obj_read_face(cursor, line_end, obj_mesh, current_material_index, chunk))
+                                return 0;
+                            keyword_lines[STATS_KEYWORD_F]++;
+                        }
+                    else
+                        keyword_lines[STATS_KEYWORD_OTHER]++;
+                    break;
+
+                /* use material */
+                case 'u':
+                    if (obj_line_has_keyword(cursor, line_end, "usemtl", 6))
+                        {
+                            cursor += 6;
+                            /* materials are resolved by name now, the mtl file only fills their colors later */
+                            if (obj_parse_name(&cursor, line_end, current_material_name, 1024))
+                                current_material_index = obj_get_or_add_material(obj_mesh, current_material_name);
+                            else
+                                current_material_index = -1;
+                            keyword_lines[STATS_KEYWORD_USEMTL]++;
+                        }
+                    else
+                        keyword_lines[STATS_KEYWORD_OTHER]++;
+                    break;
+
+                /* material file */
+                case 'm':
+                    if (obj_line_has_keyword(cursor, line_end, "mtllib", 6))
+                        {
+                            cursor += 6;
+                            obj_parse_name(&cursor, line_end, obj_mesh->material_filename, 1024);
+                            if (chunk != NULL)
+                                chunk->has_material_file = 1;
+                            keyword_lines[STATS_KEYWORD_MTLLIB]++;
+                        }
+                    else
+                        keyword_lines[STATS_KEYWORD_OTHER]++;
+                    break;
+
+                /* comment and unsupported keywords */
+                default:
+                    keyword_lines[STATS_KEYWORD_OTHER]++;
+                    break;
+                }
+
+            line = line_end + 1;
+        }
+
+    if (chunk != NULL)
+        chunk->last_material_index = current_material_index;
+    stats_add_keyword_lines(keyword_lines);
+
+    return 1;
+}
+
+/* parse the content of an obj file (data does not need to be null terminated) */
+int obj_mesh_parse(obj_mesh_t *obj_mesh, const char *data, size_t size)
+{
+    if (obj_mesh == NULL)
+        return 0;
+
+    obj_mesh_reserve_from_data(obj_mesh, data, size);
+
+    return obj_mesh_parse_lines(obj_mesh, data, size, NULL);
+}
+
+/* parse a chunk of an obj file into its own mesh (thread entry point, errors are kept in the chunk messages) */
+void * obj_chunk_parse(void *data)
+{
+    obj_chunk_t *chunk = (obj_chunk_t *) data;
+    solid_buffer_t *previous_capture = NULL;
+    solid_arena_t *previous_arena = NULL;
+
+    previous_capture = report_set_capture(&chunk->messages);
+
+    /* chunks are freed once merged, they would only fill the arena of the calling thread (which runs one of them) */
+    previous_arena = solid_arena_set_current(NULL);
+    chunk->obj_mesh = obj_mesh_create("");
+    solid_arena_set_current(previous_arena);
+    if (chunk->obj_mesh != NULL)
+        {
+            obj_mesh_reserve_from_data(chunk->obj_mesh, chunk->data, chunk->size);
+            chunk->result = obj_mesh_parse_lines(chunk->obj_mesh, chunk->data, chunk->size, chunk);
+        }
+
+    report_set_capture(previous_capture);
+    return NULL;
+}
+
+/* append a parsed chunk to an obj mesh, "material_index" is the material in use at the start of the chunk and is updated */
+int obj_chunk_merge(obj_mesh_t *obj_mesh, obj_chunk_t *chunk, int *material_index)
+{
+    obj_mesh_t *chunk_mesh = chunk->obj_mesh;
+    int *material_map = NULL;
+    int index = 0;
+    int vertex_base = obj_mesh->vertices_used;
+    int face_base = obj_mesh->faces_used;
+    int corner_base = obj_mesh->corners_used;
+    int face_material = 0;
+
+    /* materials are added in the order they appear in the file, as the sequential parser does */
+    material_map = (int *) malloc(sizeof(int) * (chunk_mesh->materials_used > 0 ? chunk_mesh->materials_used : 1));
+    if (material_map == NULL)
+        {
+            report_error("Error : can't allocate material map in function obj_chunk_merge !\n");
+            return 0;
+        }
+    for (index = 0; index < chunk_mesh->materials_used; index++)
+        {
+            material_map[index] = obj_get_or_add_material(obj_mesh, chunk_mesh->materials[index].name);
+            if (material_map[index] == -1)
+                {
+                    free(material_map);
+                    return 0;
+                }
+        }
+
+    if (!obj_array_reserve(obj_mesh->arena, (void **) &obj_mesh->vertices, &obj_mesh->vertices_allocated, vertex_base + chunk_mesh->vertices_used, sizeof(obj_vertex_t))
+            || !obj_faces_reserve(obj_mesh, face_base + chunk_mesh->faces_used)
+            || !obj_corners_reserve(obj_mesh, corner_base + chunk_mesh->corners_used))
+        {
+            report_error("Error : can't realloc mesh buffers in function obj_chunk_merge !\n");
+            free(material_map);
+            return 0;
+        }
+
+    /* texture and normal indexes exist for the whole mesh as soon as a chunk has some */
+    if (chunk_mesh->corner_textures != NULL && obj_mesh->corner_textures == NULL)
+        obj_mesh->corner_textures = obj_corner_indexes_create(obj_mesh);
+    if (chunk_mesh->corner_normals != NULL && obj_mesh->corner_normals == NULL)
+        obj_mesh->corner_normals = obj_corner_indexes_create(obj_mesh);
+    if ((chunk_mesh->corner_textures != NULL && obj_mesh->corner_textures == NULL)
+            || (chunk_mesh->corner_normals != NULL && obj_mesh->corner_normals == NULL))
+        {
+            free(material_map);
+            return 0;
+        }
+
+    /* vertices */
+    memcpy(obj_mesh->vertices + vertex_base, chunk_mesh->vertices, sizeof(obj_vertex_t) * chunk_mesh->vertices_used);
+    obj_mesh->vertices_used += chunk_mesh->vertices_used;
+
+    /* corners, negative indexes were resolved against the vertices of the chunk only */
+    for (index = 0; index < chunk->relative_corners_used; index++)
+        chunk_mesh->corner_vertices[chunk->relative_corners[index]] += vertex_base;
+    memcpy(obj_mesh->corner_vertices + corner_base, chunk_mesh->corner_vertices, sizeof(int) * chunk_mesh->corners_used);
+    if (obj_mesh->corner_textures != NULL)
+        {
+            if (chunk_mesh->corner_textures != NULL)
+                memcpy(obj_mesh->corner_textures + corner_base, chunk_mesh->corner_textures, sizeof(int) * chunk_mesh->corners_used);
+            else
+                memset(obj_mesh->corner_textures + corner_base, 0, sizeof(int) * chunk_mesh->corners_used);
+        }
+    if (obj_mesh->corner_normals != NULL)
+        {
+            if (chunk_mesh->corner_normals != NULL)
+                memcpy(obj_mesh->corner_normals + corner_base, chunk_mesh->corner_normals, sizeof(int) * chunk_mesh->corners_used);
+            else
+                memset(obj_mesh->corner_normals + corner_base, 0, sizeof(int) * chunk_mesh->corners_used);
+        }
+    obj_mesh->corners_used += chunk_mesh->corners_used;
+
+    /* faces */
+    for (index = 0; index < chunk_mesh->faces_used; index++)
+        {
+            face_material = chunk_mesh->face_materials[index];
+            if (face_material == OBJ_MATERIAL_INHERITED)
+                face_material = *material_index;
+            else if (face_material >= 0)
+                face_material = material_map[face_material];
+
+            obj_mesh->face_offsets[face_base + index] = corner_base + chunk_mesh->face_offsets[index];
+            obj_mesh->face_materials[face_base + index] = face_material;
+        }
+    obj_mesh->faces_used += chunk_mesh->faces_used;
+    obj_mesh->face_offsets[obj_mesh->faces_used] = obj_mesh->corners_used;
+
+    /* state left for the next chunk */
+    if (chunk->last_material_index != OBJ_MATERIAL_INHERITED)
+        *material_index = (chunk->last_material_index >= 0) ? material_map[chunk->last_material_index] : -1;
+    if (chunk->has_material_file)
+        memcpy(obj_mesh->material_filename, chunk_mesh->material_filename, sizeof(obj_mesh->material_filename));
+
+    free(material_map);
+    return 1;
+}
+
+/* parse the content of an obj file split in newline aligned chunks on a pool of threads (same result as obj_mesh_parse) */
+int obj_mesh_parse_parallel(obj_mesh_t *obj_mesh, const char *data, size_t size, int threads_count)
+{
+    obj_chunk_t *chunks = NULL;
+    int chunks_count = 0;
+    int chunk_index = 0;
+    const char *chunk_start = data;
+    const char *chunk_end = NULL;
+    int vertices = 0;
+    int faces = 0;
+    int corners = 0;
+    int material_index = -1;
+    int result = 1;
+
+    if (obj_mesh == NULL)
+        return 0;
+
+    /* small files are not worth the threads */
+    chunks_count = threads_count;
+    if ((size_t) chunks_count > size / OBJ_PARSE_MIN_CHUNK_SIZE)
+        chunks_count = (int) (size / OBJ_PARSE_MIN_CHUNK_SIZE);
+    if (chunks_count <= 1)
+        return obj_mesh_parse(obj_mesh, data, size);
+
+    chunks = (obj_chunk_t *) calloc(chunks_count, sizeof(obj_chunk_t));
+    if (chunks == NULL)
+        {
+            report_error("Error : can't allocate chunks in function obj_mesh_parse_parallel !\n");
+            return 0;
+        }
+
+    /* chunks end after a new line so that no line is split */
+    for (chunk_index = 0; chunk_index < chunks_count; chunk_index++)
+        {
+            if (chunk_index == chunks_count - 1)
+                {
+                    chunk_end = data + size;
+                }
+            else
+                {
+                    chunk_end = data + size / chunks_count * (chunk_index + 1);
+                    if (chunk_end < chunk_start)
+                        chunk_end = chunk_start;
+                    chunk_end = (const char *) memchr(chunk_end, '\n', data + size - chunk_end);
+                    chunk_end = (chunk_end == NULL) ? data + size : chunk_end + 1;
+                }
+
+            chunks[chunk_index].data = chunk_start;
+            chunks[chunk_index].size = chunk_end - chunk_start;
+            chunks[chunk_index].last_material_index = OBJ_MATERIAL_INHERITED;
+            solid_buffer_init(&chunks[chunk_index].messages);
+            chunk_start = chunk_end;
+        }
+
+    threads_run_jobs(obj_chunk_parse, chunks, sizeof(obj_chunk_t), chunks_count, chunks_count);
+
+    /* reserve the whole mesh once */
+    for (chunk_index = 0; chunk_index < chunks_count; chunk_index++)
+        {
+            if (chunks[chunk_index].obj_mesh != NULL)
+                {
+                    vertices += chunks[chunk_index].obj_mesh->vertices_used;
+                    faces += chunks[chunk_index].obj_mesh->faces_used;
+                    corners += chunks[chunk_index].obj_mesh->corners_used;
+                }
+        }
+    result = obj_mesh_reserve(obj_mesh, obj_mesh->vertices_used + vertices, obj_mesh->faces_used + faces, 0)
+             && obj_corners_reserve(obj_mesh, obj_mesh->corners_used + corners);
+
+    /* merge in file order, messages are reported in that order too */
+    for (chunk_index = 0; chunk_index < chunks_count; chunk_index++)
+        {
+            report_replay(&chunks[chunk_index].messages);
+            if (result)
+                result = chunks[chunk_index].obj_mesh != NULL && chunks[chunk_index].result
+                         && obj_chunk_merge(obj_mesh, &chunks[chunk_index], &material_index);
+
+            if (chunks[chunk_index].obj_mesh != NULL)
+                obj_mesh_free(chunks[chunk_index].obj_mesh);
+            if (chunks[chunk_index].relative_corners != NULL)
+                free(chunks[chunk_index].relative_corners);
+            solid_buffer_free(&chunks[chunk_index].messages);
+        }
+
+    free(chunks);
+
+    return result;
+}
+
+/* parse the content of a mtl file (data does not need to be null terminated) */
+int obj_mesh_parse_materials(obj_mesh_t *obj_mesh, const char *data, size_t size)
+{
+    const char *line = data;
+    const char *end = data + size;
+    const char *line_end = NULL;
+    const char *cursor = NULL;
+    obj_material_t *obj_material = NULL;
+    char material_name[1024];
+    int material_index = 0;
+    int keyword_lines[STATS_KEYWORDS_COUNT];
+
+    if (obj_mesh == NULL)
+        return 0;
+
+    memset(keyword_lines, 0, sizeof(keyword_lines));
+
+    while (line < end)
+        {
+            line_end = (const char *) memchr(line, '\n', end - line);
+            if (line_end == NULL)
+                line_end = end;
+
+            cursor = obj_skip_blanks(line, line_end);
+
+            if (obj_line_has_keyword(cursor, line_end, "newmtl", 6))
+                {
+                    cursor += 6;
+                    obj_parse_name(&cursor, line_end, material_name, 1024);
+                    /* the material may already exist if it has been used by the obj file */
+                    material_index = obj_get_or_add_material(obj_mesh, material_name);
+                    if (material_index == -1)
+                        return 0;
+                    obj_material = &obj_mesh->materials[material_index];
+                    keyword_lines[STATS_KEYWORD_NEWMTL]++;
+                }
+            else if (obj_material != NULL && cursor + 2 <= line_end && cursor[0] == 'K')
+                {
+                    if (obj_line_has_keyword(cursor, line_end, "Ka", 2))
+                        {
+                            cursor += 2;
+                            obj_parse_color(&cursor, line_end, &obj_material->ambient_r, &obj_material->ambient_g, &obj_material->ambient_b);
+                        }
+                    else if (obj_line_has_keyword(cursor, line_end, "Kd", 2))
+                        {
+                            cursor += 2;
+                            obj_parse_color(&cursor, line_end, &obj_material->diffuse_r, &obj_material->diffuse_g, &obj_material->diffuse_b);
+                            keyword_lines[STATS_KEYWORD_KD]++;
+                        }
+                    else if (obj_line_has_keyword(cursor, line_end, "Ks", 2))
+                        {
+                            cursor += 2;
+                            obj_parse_color(&cursor, line_end, &obj_material->specular_r, &obj_material->specular_g, &obj_material->specular_b);
+                        }
+                }
+            else if (obj_material != NULL && obj_line_has_keyword(cursor, line_end, "Ns", 2))
+                {
+                    cursor += 2;
+                    obj_parse_float(&cursor, line_end, &obj_material->specular_coefficient);
+                }
+
+            keyword_lines[STATS_KEYWORD_OTHER]++;
+            line = line_end + 1;
+        }
+
+    /* every line has been counted as other, newmtl and Kd ones included */
+    keyword_lines[STATS_KEYWORD_OTHER] -= keyword_lines[STATS_KEYWORD_NEWMTL] + keyword_lines[STATS_KEYWORD_KD];
+    stats_add_keyword_lines(keyword_lines);
+    return 1;
+}
+
+/* bit pattern of a color component used as hash key (-0.0 and 0.0 are the same color) */
+unsigned int solid_color_bits(float component)
+{
+    union
+    {
+        float f;
+        unsigned int u;
+    } bits;
+
+    bits.f = (component == 0.0f) ? 0.0f : component;
+    return bits.u;
+}
+
+/* hash a color from the bit patterns of its components */
+unsigned int solid_color_hash(float r, float g, float b)
+{
+    unsigned int hash = 2166136261u;
+
+    hash = (hash ^ solid_color_bits(r)) * 16777619u;
+    hash = (hash ^ solid_color_bits(g)) * 16777619u;
+    hash = (hash ^ solid_color_bits(b)) * 16777619u;
+
+    /* final mix so that close colors spread over the whole table */
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+
+    return hash;
+}
+
+/* create an empty material table (in the arena of the current thread if it has one) */
+solid_material_table_t * solid_material_table_create(void)
+{
+    solid_material_table_t *table = NULL;
+    solid_arena_t *arena = solid_arena_current();
+    int slot_index = 0;
+
+    table = (solid_material_table_t *) memory_alloc(arena, sizeof(solid_material_table_t));
+    if (table == NULL)
+        {
+            report_error("Error : can't allocate solid_material_table_t in function solid_material_table_create !\n");
+            return NULL;
+        }
+
+    table->arena = arena;
+    table->materials = NULL;
+    table->materials_used = 0;
+    table->materials_allocated = 0;
+
+    table->slots_count = 64;
+    table->slots = (int *) memory_alloc(arena, sizeof(int) * table->slots_count);
+    if (table->slots == NULL)
+        {
+            report_error("Error : can't allocate slots in function solid_material_table_create !\n");
+            memory_free(arena, table);
+            return NULL;
+        }
+    for (slot_index = 0; slot_index < table->slots_count; slot_index++)
+        table->slots[slot_index] = -1;
+
+    return table;
+}
+
+/* free a material table from memory */
+void solid_material_table_free(solid_material_table_t *table)
+{
+    if (table == NULL)
+        return;
+
+    if (table->materials != NULL)
+        memory_free(table->arena, table->materials);
+
+    if (table->slots != NULL)
+        memory_free(table->arena, table->slots);
+
+    memory_free(table->arena, table);
+}
+
+/* double the number of slots of a material table and rehash its materials */
+int solid_material_table_grow(solid_material_table_t *table)
+{
+    int *new_slots = NULL;
+    int new_slots_count = 0;
+    int slot_index = 0;
+    int material_index = 0;
+    solid_material_t *material = NULL;
+
+    new_slots_count = table->slots_count * 2;
+    new_slots = (int *) memory_alloc(table->arena, sizeof(int) * new_slots_count);
+    if (new_slots == NULL)
+        return 0;
+
+    for (slot_index = 0; slot_index < new_slots_count; slot_index++)
+        new_slots[slot_index] = -1;
+
+    for (material_index = 0; material_index < table->materials_used; material_index++)
+        {
+            material = &table->materials[material_index];
+            slot_index = solid_color_hash(material->r, material->g, material->b) & (new_slots_count - 1);
+            while (new_slots[slot_index] != -1)
+                slot_index = (slot_index + 1) & (new_slots_count - 1);
+            new_slots[slot_index] = material_index;
+        }
+
+    memory_free(table->arena, table->slots);
+    table->slots = new_slots;
+    table->slots_count = new_slots_count;
+    STATS_ADD(reallocs, 1);
+    return 1;
+}
+
+/* get the index of the material matching the color supplied or insert a new one (returns -1 on error) */
+int solid_material_table_get_or_insert(solid_material_table_t *table, float r, float g, float b)
+{
+    solid_material_t *new_buffer = NULL;
+    solid_material_t *material = NULL;
+    unsigned int hash = 0;
+    int slot_index = 0;
+    int material_index = 0;
+    int probes_count = 1;
+
+    hash = solid_color_hash(r, g, b);
+
+    /* linear probing until the color or a free slot is found */
+    slot_index = hash & (table->slots_count - 1);
+    while (table->slots[slot_index] != -1)
+        {
+            material = &table->materials[table->slots[slot_index]];
+            if (solid_color_bits(material->r) == solid_color_bits(r)
+                    && solid_color_bits(material->g) == solid_color_bits(g)
+                    && solid_color_bits(material->b) == solid_color_bits(b))
+                {
+                    STATS_ADD(hash_probes, probes_count);
+                    return table->slots[slot_index];
+                }
+
+            slot_index = (slot_index + 1) & (table->slots_count - 1);
+            probes_count++;
+        }
+    STATS_ADD(hash_probes, probes_count);
+
+    /* material not found, insert a new one */
+    if (table->materials_used == table->materials_allocated)
+        {
+            material_index = (table->materials_allocated > 0) ? table->materials_allocated * 2 : 16;
+            new_buffer = (solid_material_t *) memory_realloc(table->arena, table->materials, sizeof(solid_material_t) * table->materials_allocated, sizeof(solid_material_t) * material_index);
+            if (new_buffer == NULL)
+                {
+                    report_error("Error : can't realloc materials in function solid_material_table_get_or_insert !\n");
+                    return -1;
+                }
+            table->materials = new_buffer;
+            table->materials_allocated = material_index;
+            STATS_ADD(reallocs, 1);
+        }
+
+    material_index = table->materials_used;
+    material = &table->materials[material_index];
+    material->r = r;
+    material->g = g;
+    material->b = b;
+    material->id = material_index;
+    material->name[0] = '\0';
+    table->materials_used++;
+    table->slots[slot_index] = material_index;
+
+    /* keep the load factor under 1/2 so probe sequences stay short */
+    if (table->materials_used * 2 > table->slots_count && !solid_material_table_grow(table))
+        {
+            report_error("Error : can't grow slots in function solid_material_table_get_or_insert !\n");
+            return -1;
+        }
+
+    return material_index;
+}
+
+/* assign unique id and name to each material in the table */
+void solid_material_table_assign_unique_id_and_name(solid_material_table_t *table)
+{
+    int material_index = 0;
+    solid_material_t *material = NULL;
+
+    for (material_index = 0; material_index < table->materials_used; material_index++)
+        {
+            material = &table->materials[material_index];
+            /* the last color found gets the id 0 (numbering of the previous list based implementation) */
+            material->id = table->materials_used - 1 - material_index;
+            snprintf(material->name, sizeof(material->name), "%s_%d", "material", material->id);
+        }
+}
+
+/* read short (2 bytes) from file */
+int solid_read_short(FILE *file, int count, short *s)
+{
+    while(count--)
+        {
+            unsigned char buf[2];
+            if (fread(&buf, 2, 1, file) != 1)
+                {
+                    return 0;
+                }
+            *s = (short) ((buf[0] << 8) | buf[1]);
+            s++;
+        }
+    return 1;
+}
+
+/* store a short (2 bytes, big endian) in memory */
+void solid_store_short(unsigned char *buf, short s)
+{
+    buf[0] = (unsigned char) ((s >> 8) & 0xff);
+    buf[1] = (unsigned char) (s & 0xff);
+}
+
+/* load a short (2 bytes, big endian) from memory */
+short solid_load_short(const unsigned char *buf)
+{
+    return (short) ((buf[0] << 8) | buf[1]);
+}
+
+/* write short (2 bytes) to file */
+int solid_write_short(FILE *file, int count, const short *s)
+{
+    unsigned char buf[512];
+    int chunk = 0;
+    int index = 0;
+
+    /* encode a chunk of values at a time and write it at once */
+    while (count > 0)
+        {
+            chunk = (count < 256) ? count : 256;
+            for (index = 0; index < chunk; index++)
+                solid_store_short(buf + index * 2, s[index]);
+            if (fwrite(buf, 2, chunk, file) != (size_t) chunk)
+                return 0;
+            s += chunk;
+            count -= chunk;
+        }
+    return 1;
+}
+
+/* read int (4 bytes) from file */
+int solid_read_int(FILE *file, int count, int *s)
+{
+    while(count--)
+        {
+            unsigned char buf[4];
+            if (fread(&buf, 4, 1, file) != 1)
+                {
+                    return 0;
+                }
+            *s = (int) ((buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]));
+            s++;
+        }
+    return 1;
+}
+
+/* store an int (4 bytes, big endian) in memory */
+void solid_store_int(unsigned char *buf, int s)
+{
+    buf[0] = (unsigned char) ((s >> 24) & 0xff);
+    buf[1] = (unsigned char) ((s >> 16) & 0xff);
+    buf[2] = (unsigned char) ((s >> 8) & 0xff);
+    buf[3] = (unsigned char) (s & 0xff);
+}
+
+/* write int (4 bytes) to file */
+int solid_write_int(FILE *file, int count, const int *s)
+{
+    unsigned char buf[1024];
+    int chunk = 0;
+    int index = 0;
+
+    /* encode a chunk of values at a time and write it at once */
+    while (count > 0)
+        {
+            chunk = (count < 256) ? count : 256;
+            for (index = 0; index < chunk; index++)
+                solid_store_int(buf + index * 4, s[index]);
+            if (fwrite(buf, 4, chunk, file) != (size_t) chunk)
+                return 0;
+            s += chunk;
+            count -= chunk;
+        }
+    return 1;
+}
+
+/* union between int and float (used here to convert int to float) */
+union intfloat
+{
+    int i;
+    float f;
+};
+
+/* read float (here 4 bytes specifically to the solid file format) from file */
+int solid_read_float(FILE *file, int count, float *f)
+{
+    union intfloat infl;
+    infl.f = 0;
+    while(count--)
+        {
+            solid_read_int(file, 1, &(infl.i));
+            *f = infl.f;
+            f++;
+        }
+    return 1;
+}
+
+/* store a float (4 bytes, big endian) in memory */
+void solid_store_float(unsigned char *buf, float f)
+{
+    union intfloat infl;
+
+    infl.f = f;
+    solid_store_int(buf, infl.i);
+}
+
+/* load a float (4 bytes, big endian) from memory */
+float solid_load_float(const unsigned char *buf)
+{
+    union intfloat infl;
+
+    infl.i = (int) (((unsigned int) buf[0] << 24) | ((unsigned int) buf[1] << 16) | ((unsigned int) buf[2] << 8) | (unsigned int) buf[3]);
+    return infl.f;
+}
+
+/* write float (4 bytes) to file */
+int solid_write_float(FILE *file, int count, const float *f)
+{
+    unsigned char buf[1024];
+    int chunk = 0;
+    int index = 0;
+
+    /* encode a chunk of values at a time and write it at once */
+    while (count > 0)
+        {
+            chunk = (count < 256) ? count : 256;
+            for (index = 0; index < chunk; index++)
+                solid_store_float(buf + index * 4, f[index]);
+            if (fwrite(buf, 4, chunk, file) != (size_t) chunk)
+                return 0;
+            f += chunk;
+            count -= chunk;
+        }
+    return 1;
+}
+
+/* store an unsigned short (2 bytes, little endian as in compact solid files) in memory */
+void solid_store_ushort_le(unsigned char *buf, unsigned short s)
+{
+    buf[0] = (unsigned char) (s & 0xff);
+    buf[1] = (unsigned char) ((s >> 8) & 0xff);
+}
+
+/* load an unsigned short (2 bytes, little endian) from memory */
+unsigned short solid_load_ushort_le(const unsigned char *buf)
+{
+    return (unsigned short) (buf[0] | (buf[1] << 8));
+}
+
+/* store a float (4 bytes, little endian) in memory */
+void solid_store_float_le(unsigned char *buf, float f)
+{
+    union intfloat infl;
+    unsigned int bits = 0;
+
+    infl.f = f;
+    bits = (unsigned int) infl.i;
+    buf[0] = (unsigned char) (bits & 0xff);
+    buf[1] = (unsigned char) ((bits >> 8) & 0xff);
+    buf[2] = (unsigned char) ((bits >> 16) & 0xff);
+    buf[3] = (unsigned char) ((bits >> 24) & 0xff);
+}
+
+/* load a float (4 bytes, little endian) from memory */
+float solid_load_float_le(const unsigned char *buf)
+{
+    union intfloat infl;
+
+    infl.i = (int) ((unsigned int) buf[0] | ((unsigned int) buf[1] << 8) | ((unsigned int) buf[2] << 16) | ((unsigned int) buf[3] << 24));
+    return infl.f;
+}
+
+/* quantize a coordinate of a compact solid file on 16 bits between the bounds of the mesh on its axis */
+unsigned short solid_v2_quantize(float value, float min, float max)
+{
+    double position = 0.0;
+
+    if (!(max > min))
+        return 0;
+
+    position = (value - (double) min) / ((double) max - (double) min) * 65535.0 + 0.5;
+    if (position < 0.0)
+        return 0;
+    if (position > 65535.0)
+        return 65535;
+    return (unsigned short) position;
+}
+
+/* coordinate of a compact solid file back from its 16 bits (the loader and the encoder must agree on it) */
+float solid_v2_dequantize(unsigned short quantized, float min, float max)
+{
+    return min + (float) quantized * ((max - min) / 65535.0f);
+}
+
+/* quantize a color component of a compact solid file on 8 bits */
+unsigned char solid_v2_quantize_color(float component)
+{
+    if (!(component > 0.0f))
+        return 0;
+    if (component >= 1.0f)
+        return 255;
+    return (unsigned char) (component * 255.0f + 0.5f);
+}
+
+/* append the whole content of a file to a buffer (returns 0 on error) */
+int solid_buffer_read_file(solid_buffer_t *buffer, const char *path)
+{
+    mapped_file_t mapped_file;
+    unsigned char *data = NULL;
+
+    if (!mapped_file_open(&mapped_file, path))
+        {
+            report_error("can't load file '%s' !\n", path);
+            return 0;
+        }
+
+    data = solid_buffer_append(buffer, mapped_file.size);
+    if (data != NULL)
+        memcpy(data, mapped_file.data, mapped_file.size);
+    else
+        report_error("Error : can't allocate buffer in function solid_buffer_read_file !\n");
+
+    mapped_file_close(&mapped_file);
+    return data != NULL;
+}
+
+/* write the whole content of a buffer to a file at once */
+int solid_buffer_write_file(const solid_buffer_t *buffer, const char *path)
+{
+    return solid_buffers_write_file(buffer, 1, path);
+}
+
+/* write the content of several buffers one after the other to a file (gathered in as few system calls as possible) */
+int solid_buffers_write_file(const solid_buffer_t *buffers, int buffers_count, const char *path)
+{
+#ifndef _WIN32
+    struct iovec vectors[SOLID_WRITE_MAX_VECTORS];
+    int vectors_count = 0;
+    int buffer_index = 0;
+    size_t written = 0; /* bytes of buffers[buffer_index] already written */
+    ssize_t write_size = 0;
+    int file = -1;
+    int result = 1;
+    int previous_stage = STATS_STAGE_NONE;
+
+    previous_stage = stats_enter_stage(STATS_STAGE_WRITE);
+    file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (file == -1)
+        {
+            report_error("Error : can't open '%s' for writing !\n", path);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+
+    while (result)
+        {
+            /* skip what has been written already */
+            while (buffer_index < buffers_count && written >= buffers[buffer_index].used)
+                {
+                    written -= buffers[buffer_index].used;
+                    buffer_index++;
+                }
+            if (buffer_index >= buffers_count)
+                break;
+
+            vectors_count = 0;
+            while (buffer_index + vectors_count < buffers_count && vectors_count < SOLID_WRITE_MAX_VECTORS)
+                {
+                    vectors[vectors_count].iov_base = buffers[buffer_index + vectors_count].data + (vectors_count == 0 ? written : 0);
+                    vectors[vectors_count].iov_len = buffers[buffer_index + vectors_count].used - (vectors_count == 0 ? written : 0);
+                    vectors_count++;
+                }
+
+            write_size = writev(file, vectors, vectors_count);
+            if (write_size <= 0)
+                {
+                    report_error("Error : can't write '%s' !\n", path);
+                    result = 0;
+                }
+            else
+                {
+                    written += write_size;
+                    STATS_ADD(bytes_written, write_size);
+                }
+        }
+
+    if (close(file) != 0)
+        result = 0;
+
+    stats_enter_stage(previous_stage);
+    return result;
+#else
+    FILE *file = NULL;
+    int buffer_index = 0;
+    int result = 1;
+    int previous_stage = STATS_STAGE_NONE;
+
+    previous_stage = stats_enter_stage(STATS_STAGE_WRITE);
+    file = fopen(path, "wb");
+    if (file == NULL)
+        {
+            report_error("Error : can't open '%s' for writing !\n", path);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+
+    for (buffer_index = 0; result && buffer_index < buffers_count; buffer_index++)
+        {
+            if (buffers[buffer_index].used > 0 && fwrite(buffers[buffer_index].data, buffers[buffer_index].used, 1, file) != 1)
+                {
+                    report_error("Error : can't write '%s' !\n", path);
+                    result = 0;
+                }
+            else
+                {
+                    STATS_ADD(bytes_written, buffers[buffer_index].used);
+                }
+        }
+
+    if (fclose(file) != 0)
+        result = 0;
+
+    stats_enter_stage(previous_stage);
+    return result;
+#endif
+}
+
+/* copy "count" 32 bits words from src to dst swapping their bytes (big endian <-> little endian) */
+void solid_bswap32_copy(unsigned char *dst, const unsigned char *src, size_t count)
+{
+    size_t index = 0;
+
+#if defined(__AVX2__)
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    for (; index + 8 <= count; index += 8)
+        {
+            __m256i words = _mm256_loadu_si256((const __m256i *) (src + index * 4));
+            _mm256_storeu_si256((__m256i *) (dst + index * 4), _mm256_shuffle_epi8(words, mask));
+        }
+#elif defined(__SSSE3__)
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    for (; index + 4 <= count; index += 4)
+        {
+            __m128i words = _mm_loadu_si128((const __m128i *) (src + index * 4));
+            _mm_storeu_si128((__m128i *) (dst + index * 4), _mm_shuffle_epi8(words, mask));
+        }
+#elif defined(__SSE2__)
+    for (; index + 4 <= count; index += 4)
+        {
+            __m128i words = _mm_loadu_si128((const __m128i *) (src + index * 4));
+            /* swap the bytes of each 16 bits half then swap the halves */
+            words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+            words = _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, 0xb1), 0xb1);
+            _mm_storeu_si128((__m128i *) (dst + index * 4), words);
+        }
+#endif
+
+    /* scalar fallback (and remaining words) */
+    for (; index < count; index++)
+        {
+            unsigned char b0 = src[index * 4];
+            unsigned char b1 = src[index * 4 + 1];
+            unsigned char b2 = src[index * 4 + 2];
+            unsigned char b3 = src[index * 4 + 3];
+            dst[index * 4] = b3;
+            dst[index * 4 + 1] = b2;
+            dst[index * 4 + 2] = b1;
+            dst[index * 4 + 3] = b0;
+        }
+}
+
+/* copy "count" 16 bits words from src to dst swapping their bytes (big endian <-> little endian) */
+void solid_bswap16_copy(unsigned char *dst, const unsigned char *src, size_t count)
+{
+    size_t index = 0;
+
+#if defined(__AVX2__)
+    for (; index + 16 <= count; index += 16)
+        {
+            __m256i words = _mm256_loadu_si256((const __m256i *) (src + index * 2));
+            words = _mm256_or_si256(_mm256_slli_epi16(words, 8), _mm256_srli_epi16(words, 8));
+            _mm256_storeu_si256((__m256i *) (dst + index * 2), words);
+        }
+#elif defined(__SSE2__)
+    for (; index + 8 <= count; index += 8)
+        {
+            __m128i words = _mm_loadu_si128((const __m128i *) (src + index * 2));
+            words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+            _mm_storeu_si128((__m128i *) (dst + index * 2), words);
+        }
+#endif
+
+    /* scalar fallback (and remaining words) */
+    for (; index < count; index++)
+        {
+            unsigned char b0 = src[index * 2];
+            dst[index * 2] = src[index * 2 + 1];
+            dst[index * 2 + 1] = b0;
+        }
+}
+
+/* read XYZ from file */
+int solid_read_XYZ(FILE *file, int count, solid_XYZ_t *xyz)
+{
+    while(count--)
+        {
+            solid_read_float(file, 1, &(xyz->x));
+            solid_read_float(file, 1, &(xyz->y));
+            solid_read_float(file, 1, &(xyz->z));
+            xyz++;
+        }
+    return 1;
+}
+
+/* read solid_textured_triangle from file */
+int solid_read_textured_triangle(FILE *file, int count, solid_textured_triangle_t *solid_textured_triangle)
+{
+    while(count--)
+        {
+            short pad;
+            solid_read_short(file, 3, solid_textured_triangle->vertex);
+            solid_read_short(file, 1, &pad);
+            solid_read_float(file, 1, &(solid_textured_triangle->r));
+            solid_read_float(file, 1, &(solid_textured_triangle->g));
+            solid_read_float(file, 1, &(solid_textured_triangle->b));
+            solid_textured_triangle++;
+        }
+    return 1;
+}
+
+/* create a new solid mesh in memory (in the arena of the current thread if it has one) */
+solid_mesh_t *solid_mesh_create(char *filename, short vertex_count, short triangle_count)
+{
+    solid_mesh_t *solid_mesh = NULL;
+    solid_arena_t *arena = solid_arena_current();
+
+    /* allocate memory for the solid mesh structure */
+    solid_mesh = (solid_mesh_t *) memory_alloc(arena, sizeof(solid_mesh_t));
+    if (solid_mesh == NULL)
+        {
+            report_error("Error : can't allocate solid mesh in function create_solid_mesh !\n");
+            return NULL;
+        }
+
+    /* set filename */
+    strncpy(solid_mesh->filename, filename, 1024);
+
+    /* the vertices and triangles go in the same arena */
+    solid_mesh->arena = arena;
+
+    /* set vertex and triangle count */
+    solid_mesh->vertex_count = vertex_count;
+    solid_mesh->triangle_count = triangle_count;
+
+    /* allocate memory for the vertices of the solid mesh */
+    solid_mesh->vertices = (solid_XYZ_t *) memory_alloc(arena, sizeof(solid_XYZ_t) * (vertex_count > 0 ? vertex_count : 1));
+    if (solid_mesh->vertices == NULL)
+        {
+            report_error("Error : can't allocate solid mesh vertices in function create_solid_mesh !\n");
+            memory_free(arena, solid_mesh);
+            return NULL;
+        }
+
+    /* allocate memory for the triangles of the solid mesh */
+    solid_mesh->triangles = (solid_textured_triangle_t *) memory_alloc(arena, sizeof(solid_textured_triangle_t) * (triangle_count > 0 ? triangle_count : 1));
+    if (solid_mesh->triangles == NULL)
+        {
+            report_error("Error : can't allocate solid mesh triangles in function create_solid_mesh !\n");
+            memory_free(arena, solid_mesh->vertices);
+            memory_free(arena, solid_mesh);
+            return NULL;
+        }
+
+    /* return the newly created solid mesh */
+    return solid_mesh;
+}
+
+/* free a solid mesh from memory */
+void solid_mesh_free(solid_mesh_t *solid_mesh)
+{
+    if (solid_mesh == NULL)
+        return;
+
+    if (solid_mesh->vertices != NULL)
+        memory_free(solid_mesh->arena, solid_mesh->vertices);
+
+    if (solid_mesh->triangles != NULL)
+        memory_free(solid_mesh->arena, solid_mesh->triangles);
+
+    memory_free(solid_mesh->arena, solid_mesh);
+}
+
+/* decode "count" vertex records of a solid file (3 big endian floats each) */
+void solid_decode_vertices(solid_XYZ_t *vertices, const unsigned char *data, int count)
+{
+    int vertex_index = 0;
+
+    /* the in memory records match the file records, only the byte order may differ */
+#if defined(SOLID_HOST_LITTLE_ENDIAN)
+    if (sizeof(solid_XYZ_t) == 12)
+        {
+            solid_bswap32_copy((unsigned char *) vertices, data, (size_t) count * 3);
+            return;
+        }
+#elif defined(SOLID_HOST_BIG_ENDIAN)
+    if (sizeof(solid_XYZ_t) == 12)
+        {
+            memcpy(vertices, data, (size_t) count * 12);
+            return;
+        }
+#endif
+
+    /* portable fallback */
+    for (vertex_index = 0; vertex_index < count; vertex_index++)
+        {
+            vertices[vertex_index].x = solid_load_float(data + vertex_index * 12);
+            vertices[vertex_index].y = solid_load_float(data + vertex_index * 12 + 4);
+            vertices[vertex_index].z = solid_load_float(data + vertex_index * 12 + 8);
+        }
+}
+
+/* decode "count" triangle records of a solid file (3 big endian shorts, 2 bytes of padding and 3 big endian floats each) */
+void solid_decode_triangles(solid_textured_triangle_t *triangles, const unsigned char *data, int count)
+{
+#if defined(SOLID_HOST_LITTLE_ENDIAN)
+    unsigned char *triangle = NULL;
+    unsigned char half[2];
+    int component = 0;
+#endif
+    int triangle_index = 0;
+
+    /* the in memory records match the file records, only the byte order may differ */
+#if defined(SOLID_HOST_LITTLE_ENDIAN)
+    if (sizeof(solid_textured_triangle_t) == 20 && offsetof(solid_textured_triangle_t, r) == 8)
+        {
+            /* swap every 16 bits word, then the halves of the 3 color floats */
+            solid_bswap16_copy((unsigned char *) triangles, data, (size_t) count * 10);
+            triangle = (unsigned char *) triangles;
+            for (triangle_index = 0; triangle_index < count; triangle_index++)
+                {
+                    for (component = 8; component < 20; component += 4)
+                        {
+                            memcpy(half, triangle + component, 2);
+                            memcpy(triangle + component, triangle + component + 2, 2);
+                            memcpy(triangle + component + 2, half, 2);
+                        }
+                    triangle += 20;
+                }
+            return;
+        }
+#elif defined(SOLID_HOST_BIG_ENDIAN)
+    if (sizeof(solid_textured_triangle_t) == 20 && offsetof(solid_textured_triangle_t, r) == 8)
+        {
+            memcpy(triangles, data, (size_t) count * 20);
+            return;
+        }
+#endif
+
+    /* portable fallback */
+    for (triangle_index = 0; triangle_index < count; triangle_index++)
+        {
+            triangles[triangle_index].vertex[0] = solid_load_short(data + triangle_index * 20);
+            triangles[triangle_index].vertex[1] = solid_load_short(data + triangle_index * 20 + 2);
+            triangles[triangle_index].vertex[2] = solid_load_short(data + triangle_index * 20 + 4);
+            triangles[triangle_index].r = solid_load_float(data + triangle_index * 20 + 8);
+            triangles[triangle_index].g = solid_load_float(data + triangle_index * 20 + 12);
+            triangles[triangle_index].b = solid_load_float(data + triangle_index * 20 + 16);
+        }
+}
+
+/* decode a solid file held in memory (returns NULL if the data is not a valid solid file) */
+solid_mesh_t * solid_mesh_parse(char *filename, const unsigned char *data, size_t size)
+{
+    solid_mesh_t *solid_mesh = NULL;
+    short vertex_count = 0;
+    short triangle_count = 0;
+    const unsigned char *vertices_data = NULL;
+    const unsigned char *triangles_data = NULL;
+
+    if (size < 4)
+        {
+            report_error("Error : '%s' is too small to be a solid file !\n", filename);
+            return NULL;
+        }
+
+    /* a big endian solid file would need 21324 vertices to start the same way, and more bytes than the header gives */
+    if (memcmp(data, SOLID_V2_MAGIC, 4) == 0)
+        return solid_mesh_parse_v2(filename, data, size);
+
+    vertex_count = (short) ((data[0] << 8) | data[1]);
+    triangle_count = (short) ((data[2] << 8) | data[3]);
+
+    if (vertex_count < 0 || triangle_count < 0 || size < 4 + (size_t) vertex_count * 12 + (size_t) triangle_count * 20)
+        {
+            report_error("Error : '%s' is truncated or corrupted (%d vertices, %d triangles) !\n", filename, vertex_count, triangle_count);
+            return NULL;
+        }
+
+    solid_mesh = solid_mesh_create(filename, vertex_count, triangle_count);
+    if (solid_mesh == NULL)
+        return NULL;
+
+    vertices_data = data + 4;
+    triangles_data = vertices_data + (size_t) vertex_count * 12;
+    solid_decode_vertices(solid_mesh->vertices, vertices_data, vertex_count);
+    solid_decode_triangles(solid_mesh->triangles, triangles_data, triangle_count);
+
+    return solid_mesh;
+}
+
+/* decode a compact solid file held in memory in a single pass into a solid mesh (self-contained reference loader, returns NULL on error) */
+solid_mesh_t * solid_mesh_parse_v2(char *filename, const unsigned char *data, size_t size)
+{
+    solid_mesh_t *solid_mesh = NULL;
+    const unsigned char *record = NULL;
+    const unsigned char *colors = NULL;
+    const unsigned char *color = NULL;
+    float min[3];
+    float max[3];
+    int header_size = 0;
+    int vertex_count = 0;
+    int triangle_count = 0;
+    int color_count = 0;
+    int index = 0;
+    int axis = 0;
+
+    if (size < SOLID_V2_HEADER_SIZE || memcmp(data, SOLID_V2_MAGIC, 4) != 0)
+        {
+            report_error("Error : '%s' is not a compact solid file !\n", filename);
+            return NULL;
+        }
+    if (solid_load_ushort_le(data + 4) != SOLID_V2_VERSION)
+        {
+            report_error("Error : '%s' is a compact solid file of version %d, only version %d is known !\n", filename, solid_load_ushort_le(data + 4), SOLID_V2_VERSION);
+            return NULL;
+        }
+
+    /* later versions may add fields at the end of the header */
+    header_size = solid_load_ushort_le(data + 6);
+    vertex_count = solid_load_ushort_le(data + 8);
+    triangle_count = solid_load_ushort_le(data + 10);
+    color_count = solid_load_ushort_le(data + 12);
+    for (axis = 0; axis < 3; axis++)
+        {
+            min[axis] = solid_load_float_le(data + 16 + axis * 4);
+            max[axis] = solid_load_float_le(data + 28 + axis * 4);
+        }
+
+    if (header_size < SOLID_V2_HEADER_SIZE || vertex_count > 32767 || triangle_count > 32767 || color_count > SOLID_V2_MAX_COLORS
+            || size < (size_t) header_size + (size_t) vertex_count * SOLID_V2_VERTEX_SIZE + (size_t) color_count * SOLID_V2_COLOR_SIZE + (size_t) triangle_count * SOLID_V2_TRIANGLE_SIZE)
+        {
+            report_error("Error : '%s' is truncated or corrupted (%d vertices, %d triangles, %d colors) !\n", filename, vertex_count, triangle_count, color_count);
+            return NULL;
+        }
+
+    solid_mesh = solid_mesh_create(filename, (short) vertex_count, (short) triangle_count);
+    if (solid_mesh == NULL)
+        return NULL;
+
+    record = data + header_size;
+    for (index = 0; index < vertex_count; index++)
+        {
+            solid_mesh->vertices[index].x = solid_v2_dequantize(solid_load_ushort_le(record), min[0], max[0]);
+            solid_mesh->vertices[index].y = solid_v2_dequantize(solid_load_ushort_le(record + 2), min[1], max[1]);
+            solid_mesh->vertices[index].z = solid_v2_dequantize(solid_load_ushort_le(record + 4), min[2], max[2]);
+            record += SOLID_V2_VERTEX_SIZE;
+        }
+
+    colors = record;
+    record += (size_t) color_count * SOLID_V2_COLOR_SIZE;
+    for (index = 0; index < triangle_count; index++)
+        {
+            if (record[6] >= color_count)
+                {
+                    report_error("Error : '%s' is corrupted (color %d of triangle %d out of %d colors) !\n", filename, record[6], index, color_count);
+                    solid_mesh_free(solid_mesh);
+                    return NULL;
+                }
+            solid_mesh->triangles[index].vertex[0] = (short) solid_load_ushort_le(record);
+            solid_mesh->triangles[index].vertex[1] = (short) solid_load_ushort_le(record + 2);
+            solid_mesh->triangles[index].vertex[2] = (short) solid_load_ushort_le(record + 4);
+            color = colors + record[6] * SOLID_V2_COLOR_SIZE;
+            solid_mesh->triangles[index].r = color[0] / 255.0f;
+            solid_mesh->triangles[index].g = color[1] / 255.0f;
+            solid_mesh->triangles[index].b = color[2] / 255.0f;
+            record += SOLID_V2_TRIANGLE_SIZE;
+        }
+
+    return solid_mesh;
+}
+
+/* load a solid file (read in a single block or mapped) */
+solid_mesh_t * solid_mesh_load(char *path)
+{
+    mapped_file_t mapped_file;
+    solid_mesh_t *solid_mesh = NULL;
+    int previous_stage = STATS_STAGE_NONE;
+
+    if (!mapped_file_open(&mapped_file, path))
+        {
+            report_error("can't load file '%s' !\n", path);
+            return NULL;
+        }
+
+    previous_stage = stats_enter_stage(STATS_STAGE_PARSE);
+    solid_mesh = solid_mesh_parse(path, (const unsigned char *) mapped_file.data, mapped_file.size);
+    stats_enter_stage(previous_stage);
+
+    mapped_file_close(&mapped_file);
+    return solid_mesh;
+}
+
+/* compute the materials of a solid mesh and the material id of each of its triangles (returns 0 on error) */
+int solid_mesh_material_ids(const solid_mesh_t *solid_mesh, solid_material_table_t **material_table, int **triangle_material_ids)
+{
+    int triangle_index = 0;
+    int *ids = NULL;
+    solid_material_table_t *table = NULL;
+    int previous_stage = STATS_STAGE_NONE;
+
+    table = solid_material_table_create();
+    if (table == NULL)
+        return 0;
+
+    /* material id of each triangle, filled by the first pass and read back during the export */
+    ids = (int *) memory_alloc(table->arena, sizeof(int) * (solid_mesh->triangle_count > 0 ? solid_mesh->triangle_count : 1));
+    if (ids == NULL)
+        {
+            report_error("Error : can't allocate triangle materials in function solid_mesh_material_ids !\n");
+            solid_material_table_free(table);
+            return 0;
+        }
+
+    previous_stage = stats_enter_stage(STATS_STAGE_DEDUP);
+
+    /* compute all materials (colors only) */
+    for(triangle_index=0; triangle_index<solid_mesh->triangle_count; triangle_index++)
+        {
+            ids[triangle_index] = solid_material_table_get_or_insert(table,
+                                  solid_mesh->triangles[triangle_index].r,
+                                  solid_mesh->triangles[triangle_index].g,
+                                  solid_mesh->triangles[triangle_index].b);
+        }
+    solid_material_table_assign_unique_id_and_name(table);
+    for(triangle_index=0; triangle_index<solid_mesh->triangle_count; triangle_index++)
+        {
+            if (ids[triangle_index] >= 0)
+                ids[triangle_index] = table->materials[ids[triangle_index]].id;
+        }
+    report_info("%lu material(s) declared\n", (unsigned long) table->materials_used);
+    stats_enter_stage(previous_stage);
+
+    *material_table = table;
+    *triangle_material_ids = ids;
+    return 1;
+}
+
+/* init empty normals and bounds */
+void solid_mesh_geometry_init(solid_mesh_geometry_t *geometry)
+{
+    memset(geometry, 0, sizeof(solid_mesh_geometry_t));
+}
+
+/* free the normals of a mesh and empty its bounds */
+void solid_mesh_geometry_free(solid_mesh_geometry_t *geometry)
+{
+    if (geometry->vertex_normals != NULL)
+        memory_free(geometry->arena, geometry->vertex_normals);
+    if (geometry->face_normals != NULL)
+        memory_free(geometry->arena, geometry->face_normals);
+    solid_mesh_geometry_init(geometry);
+}
+
+/* normals of the triangles "first" to "first + count" (count <= SOLID_GEOMETRY_BLOCK_SIZE) of a solid mesh : the cross products
+   (b - a) x (c - a), twice as long as the area of each triangle, and their unit vectors (0 for degenerate triangles and for
+   triangles using vertices out of range, "valid" tells the latter apart) */
+void solid_mesh_triangle_normals(const solid_mesh_t *solid_mesh, int first, int count, float cross[3][SOLID_GEOMETRY_BLOCK_SIZE], float unit[3][SOLID_GEOMETRY_BLOCK_SIZE], char *valid)
+{
+    float corners[9][SOLID_GEOMETRY_BLOCK_SIZE];
+    const solid_textured_triangle_t *triangle = NULL;
+    const solid_XYZ_t *vertex = NULL;
+    float edges[6];
+    float length = 0.0f;
+    int index = 0;
+    int corner = 0;
+
+    /* the corners are gathered in separate x, y and z arrays, the arithmetic is then done 4 triangles at a time */
+    for (index = 0; index < count; index++)
+        {
+            triangle = &solid_mesh->triangles[first + index];
+            valid[index] = 1;
+            for (corner = 0; corner < 3; corner++)
+                {
+                    if (triangle->vertex[corner] < 0 || triangle->vertex[corner] >= solid_mesh->vertex_count)
+                        valid[index] = 0;
+                }
+            for (corner = 0; corner < 3; corner++)
+                {
+                    vertex = &solid_mesh->vertices[valid[index] ? triangle->vertex[corner] : 0];
+                    corners[corner * 3][index] = valid[index] ? vertex->x : 0.0f;
+                    corners[corner * 3 + 1][index] = valid[index] ? vertex->y : 0.0f;
+                    corners[corner * 3 + 2][index] = valid[index] ? vertex->z : 0.0f;
+                }
+        }
+
+    index = 0;
+#if defined(__SSE2__)
+    for (; index + 4 <= count; index += 4)
+        {
+            __m128 ab_x = _mm_sub_ps(_mm_loadu_ps(&corners[3][index]), _mm_loadu_ps(&corners[0][index]));
+            __m128 ab_y = _mm_sub_ps(_mm_loadu_ps(&corners[4][index]), _mm_loadu_ps(&corners[1][index]));
+            __m128 ab_z = _mm_sub_ps(_mm_loadu_ps(&corners[5][index]), _mm_loadu_ps(&corners[2][index]));
+            __m128 ac_x = _mm_sub_ps(_mm_loadu_ps(&corners[6][index]), _mm_loadu_ps(&corners[0][index]));
+            __m128 ac_y = _mm_sub_ps(_mm_loadu_ps(&corners[7][index]), _mm_loadu_ps(&corners[1][index]));
+            __m128 ac_z = _mm_sub_ps(_mm_loadu_ps(&corners[8][index]), _mm_loadu_ps(&corners[2][index]));
+            __m128 normal_x = _mm_sub_ps(_mm_mul_ps(ab_y, ac_z), _mm_mul_ps(ab_z, ac_y));
+            __m128 normal_y = _mm_sub_ps(_mm_mul_ps(ab_z, ac_x), _mm_mul_ps(ab_x, ac_z));
+            __m128 normal_z = _mm_sub_ps(_mm_mul_ps(ab_x, ac_y), _mm_mul_ps(ab_y, ac_x));
+            __m128 lengths = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normal_x, normal_x), _mm_mul_ps(normal_y, normal_y)), _mm_mul_ps(normal_z, normal_z)));
+            /* degenerate triangles divide by 0, the mask zeroes their lanes */
+            __m128 mask = _mm_cmpgt_ps(lengths, _mm_setzero_ps());
+
+            _mm_storeu_ps(&cross[0][index], normal_x);
+            _mm_storeu_ps(&cross[1][index], normal_y);
+            _mm_storeu_ps(&cross[2][index], normal_z);
+            _mm_storeu_ps(&unit[0][index], _mm_and_ps(mask, _mm_div_ps(normal_x, lengths)));
+            _mm_storeu_ps(&unit[1][index], _mm_and_ps(mask, _mm_div_ps(normal_y, lengths)));
+            _mm_storeu_ps(&unit[2][index], _mm_and_ps(mask, _mm_div_ps(normal_z, lengths)));
+        }
+#endif
+
+    /* scalar fallback (and remaining triangles), same operations in the same order */
+    for (; index < count; index++)
+        {
+            for (corner = 0; corner < 3; corner++)
+                {
+                    edges[corner] = corners[3 + corner][index] - corners[corner][index];
+                    edges[3 + corner] = corners[6 + corner][index] - corners[corner][index];
+                }
+            cross[0][index] = edges[1] * edges[5] - edges[2] * edges[4];
+            cross[1][index] = edges[2] * edges[3] - edges[0] * edges[5];
+            cross[2][index] = edges[0] * edges[4] - edges[1] * edges[3];
+            length = sqrtf(cross[0][index] * cross[0][index] + cross[1][index] * cross[1][index] + cross[2][index] * cross[2][index]);
+            for (corner = 0; corner < 3; corner++)
+                unit[corner][index] = (length > 0.0f) ? cross[corner][index] / length : 0.0f;
+        }
+}
+
+/* compute the face normals, the vertex normals (weighted by the area of the triangles) and the bounds of a solid mesh in a single pass over
+   its triangles and two over its vertices (the arrays go in the arena of the current thread if it has one, returns 0 on error) */
+int solid_mesh_geometry_compute(solid_mesh_geometry_t *geometry, const solid_mesh_t *solid_mesh)
+{
+    float cross[3][SOLID_GEOMETRY_BLOCK_SIZE];
+    float unit[3][SOLID_GEOMETRY_BLOCK_SIZE];
+    char valid[SOLID_GEOMETRY_BLOCK_SIZE];
+    solid_arena_t *arena = solid_arena_current();
+    const solid_XYZ_t *vertex = NULL;
+    solid_XYZ_t *normal = NULL;
+    float length = 0.0f;
+    float distance = 0.0f;
+    float radius = 0.0f;
+    int first = 0;
+    int count = 0;
+    int index = 0;
+    int corner = 0;
+
+    solid_mesh_geometry_init(geometry);
+    if (solid_mesh == NULL)
+        {
+            report_error("Error : solid mesh is NULL in function solid_mesh_geometry_compute !\n");
+            return 0;
+        }
+
+    geometry->arena = arena;
+    geometry->vertex_count = (solid_mesh->vertex_count > 0) ? solid_mesh->vertex_count : 0;
+    geometry->triangle_count = (solid_mesh->triangle_count > 0) ? solid_mesh->triangle_count : 0;
+    geometry->vertex_normals = (solid_XYZ_t *) memory_calloc(arena, geometry->vertex_count > 0 ? geometry->vertex_count : 1, sizeof(solid_XYZ_t));
+    geometry->face_normals = (solid_XYZ_t *) memory_alloc(arena, sizeof(solid_XYZ_t) * (geometry->triangle_count > 0 ? geometry->triangle_count : 1));
+    if (geometry->vertex_normals == NULL || geometry->face_normals == NULL)
+        {
+            report_error("Error : can't allocate normals in function solid_mesh_geometry_compute !\n");
+            solid_mesh_geometry_free(geometry);
+            return 0;
+        }
+
+    /* the triangles block after block : face normals, and their cross products added to the normals of their corners */
+    for (first = 0; first < geometry->triangle_count; first += count)
+        {
+            count = (geometry->triangle_count - first < SOLID_GEOMETRY_BLOCK_SIZE) ? geometry->triangle_count - first : SOLID_GEOMETRY_BLOCK_SIZE;
+            solid_mesh_triangle_normals(solid_mesh, first, count, cross, unit, valid);
+            for (index = 0; index < count; index++)
+                {
+                    geometry->face_normals[first + index].x = unit[0][index];
+                    geometry->face_normals[first + index].y = unit[1][index];
+                    geometry->face_normals[first + index].z = unit[2][index];
+                    if (!valid[index])
+                        continue;
+                    for (corner = 0; corner < 3; corner++)
+                        {
+                            normal = &geometry->vertex_normals[solid_mesh->triangles[first + index].vertex[corner]];
+                            normal->x += cross[0][index];
+                            normal->y += cross[1][index];
+                            normal->z += cross[2][index];
+                        }
+                }
+        }
+
+    /* the vertices : unit normals and the box */
+    for (index = 0; index < geometry->vertex_count; index++)
+        {
+            normal = &geometry->vertex_normals[index];
+            length = sqrtf(normal->x * normal->x + normal->y * normal->y + normal->z * normal->z);
+            if (length > 0.0f)
+                {
+                    normal->x /= length;
+                    normal->y /= length;
+                    normal->z /= length;
+                }
+
+            vertex = &solid_mesh->vertices[index];
+            if (index == 0 || vertex->x < geometry->bounds_min.x)
+                geometry->bounds_min.x = vertex->x;
+            if (index == 0 || vertex->y < geometry->bounds_min.y)
+                geometry->bounds_min.y = vertex->y;
+            if (index == 0 || vertex->z < geometry->bounds_min.z)
+                geometry->bounds_min.z = vertex->z;
+            if (index == 0 || vertex->x > geometry->bounds_max.x)
+                geometry->bounds_max.x = vertex->x;
+            if (index == 0 || vertex->y > geometry->bounds_max.y)
+                geometry->bounds_max.y = vertex->y;
+            if (index == 0 || vertex->z > geometry->bounds_max.z)
+                geometry->bounds_max.z = vertex->z;
+        }
+
+    /* the sphere around the center of the box (not the smallest one, but at most sqrt(3) times as big) */
+    geometry->sphere_center.x = geometry->bounds_min.x + (geometry->bounds_max.x - geometry->bounds_min.x) * 0.5f;
+    geometry->sphere_center.y = geometry->bounds_min.y + (geometry->bounds_max.y - geometry->bounds_min.y) * 0.5f;
+    geometry->sphere_center.z = geometry->bounds_min.z + (geometry->bounds_max.z - geometry->bounds_min.z) * 0.5f;
+    for (index = 0; index < geometry->vertex_count; index++)
+        {
+            vertex = &solid_mesh->vertices[index];
+            distance = (vertex->x - geometry->sphere_center.x) * (vertex->x - geometry->sphere_center.x)
+                       + (vertex->y - geometry->sphere_center.y) * (vertex->y - geometry->sphere_center.y)
+                       + (vertex->z - geometry->sphere_center.z) * (vertex->z - geometry->sphere_center.z);
+            if (distance > radius)
+                radius = distance;
+        }
+    geometry->sphere_radius = sqrtf(radius);
+
+    return 1;
+}
+
+/* compute the normals and bounds of a solid mesh timed as the normals stage (returns 0 on error) */
+int solid_mesh_geometry_compute_staged(solid_mesh_geometry_t *geometry, const solid_mesh_t *solid_mesh)
+{
+    int previous_stage = STATS_STAGE_NONE;
+    int result = 0;
+
+    previous_stage = stats_enter_stage(STATS_STAGE_NORMALS);
+    result = solid_mesh_geometry_compute(geometry, solid_mesh);
+    stats_enter_stage(previous_stage);
+
+    return result;
+}
+
+/* append a line made of a keyword and "count" floats to a buffer (returns 0 on error) */
+int solid_buffer_append_floats(solid_buffer_t *buffer, const char *keyword, const float *values, int count, int float_precision)
+{
+    size_t keyword_length = strlen(keyword);
+    char *line = NULL;
+    char *cursor = NULL;
+    int index = 0;
+
+    line = (char *) solid_buffer_reserve(buffer, keyword_length + (size_t) count * (TEXT_FLOAT_MAX_LENGTH + 1) + 1);
+    if (line == NULL)
+        return 0;
+    memcpy(line, keyword, keyword_length);
+    cursor = line + keyword_length;
+    for (index = 0; index < count; index++)
+        {
+            *cursor++ = ' ';
+            cursor = text_format_float(cursor, values[index], float_precision);
+        }
+    *cursor++ = '\n';
+    buffer->used += cursor - line;
+
+    return 1;
+}
+
+/* format the bounds and normals of a solid mesh as a SOLID_GEOMETRY_EXTENSION file : a "box" line (minimum and maximum), a "sphere" line (center
+   and radius), then a "vn" line per vertex and a "fn" line per triangle in the coordinates and order of the solid file (returns 0 on error) */
+int solid_mesh_geometry_format(const solid_mesh_geometry_t *geometry, const char *solid_name, int float_precision, solid_buffer_t *buffer)
+{
+    float values[6];
+    int index = 0;
+    int result = 1;
+
+    result &= solid_buffer_printf(buffer, "# bounds and normals of solid file '%s' (%d vertices, %d triangles)\n", solid_name, geometry->vertex_count, geometry->triangle_count);
+
+    values[0] = geometry->bounds_min.x;
+    values[1] = geometry->bounds_min.y;
+    values[2] = geometry->bounds_min.z;
+    values[3] = geometry->bounds_max.x;
+    values[4] = geometry->bounds_max.y;
+    values[5] = geometry->bounds_max.z;
+    result = result && solid_buffer_append_floats(buffer, "box", values, 6, float_precision);
+    values[0] = geometry->sphere_center.x;
+    values[1] = geometry->sphere_center.y;
+    values[2] = geometry->sphere_center.z;
+    values[3] = geometry->sphere_radius;
+    result = result && solid_buffer_append_floats(buffer, "sphere", values, 4, float_precision);
+
+    for (index = 0; result && index < geometry->vertex_count; index++)
+        {
+            values[0] = geometry->vertex_normals[index].x;
+            values[1] = geometry->vertex_normals[index].y;
+            values[2] = geometry->vertex_normals[index].z;
+            result = solid_buffer_append_floats(buffer, "vn", values, 3, float_precision);
+        }
+    for (index = 0; result && index < geometry->triangle_count; index++)
+        {
+            values[0] = geometry->face_normals[index].x;
+            values[1] = geometry->face_normals[index].y;
+            values[2] = geometry->face_normals[index].z;
+            result = solid_buffer_append_floats(buffer, "fn", values, 3, float_precision);
+        }
+
+    return result;
+}
+
+/* write the SOLID_GEOMETRY_EXTENSION file of a solid file held in a buffer : the file is decoded again so that the bounds and normals are
+   those of what is read from it (quantized positions of compact files included, options may be NULL, returns 0 on error) */
+int solid_buffer_write_geometry_file(const solid_buffer_t *solid_buffer, char *solid_file_path, const conversion_options_t *options)
+{
+    char geometry_file_path[1024 + sizeof(SOLID_GEOMETRY_EXTENSION)];
+    solid_mesh_t *solid_mesh = NULL;
+    solid_mesh_geometry_t geometry;
+    solid_buffer_t buffer;
+    int previous_stage = STATS_STAGE_NONE;
+    int result = 0;
+
+    snprintf(geometry_file_path, sizeof(geometry_file_path), "%s" SOLID_GEOMETRY_EXTENSION, solid_file_path);
+    solid_mesh_geometry_init(&geometry);
+    solid_buffer_init(&buffer);
+
+    previous_stage = stats_enter_stage(STATS_STAGE_NORMALS);
+    solid_mesh = solid_mesh_parse(solid_file_path, solid_buffer->data, solid_buffer->used);
+    result = solid_mesh != NULL && solid_mesh_geometry_compute(&geometry, solid_mesh);
+    stats_enter_stage(STATS_STAGE_FORMAT);
+    result = result && solid_mesh_geometry_format(&geometry, path_relative_to_file(solid_file_path, geometry_file_path),
+                                                  (options != NULL) ? options->float_precision : -1, &buffer);
+    stats_enter_stage(previous_stage);
+    if (solid_mesh != NULL && !result)
+        report_error("Error : can't compute the bounds and normals of '%s' !\n", solid_file_path);
+    result = result && solid_buffer_write_file(&buffer, geometry_file_path);
+
+    solid_buffer_free(&buffer);
+    solid_mesh_geometry_free(&geometry);
+    solid_mesh_free(solid_mesh);
+    return result;
+}
+
+/* format the bounds of a solid mesh as obj comments, in the coordinates of the obj file (returns 0 on error) */
+int solid_mesh_geometry_format_obj_bounds(const solid_mesh_geometry_t *geometry, int float_precision, solid_buffer_t *buffer)
+{
+    float values[6];
+
+    /* Up vector must be swapped for blender, as the vertices are : the box is mirrored on that axis */
+    values[0] = geometry->bounds_min.x;
+    values[1] = -1 * geometry->bounds_max.z;
+    values[2] = geometry->bounds_min.y;
+    values[3] = geometry->bounds_max.x;
+    values[4] = -1 * geometry->bounds_min.z;
+    values[5] = geometry->bounds_max.y;
+    if (!solid_buffer_append_floats(buffer, "# bounding box (min, max)", values, 6, float_precision))
+        return 0;
+    values[0] = geometry->sphere_center.x;
+    values[1] = -1 * geometry->sphere_center.z;
+    values[2] = geometry->sphere_center.y;
+    values[3] = geometry->sphere_radius;
+    return solid_buffer_append_floats(buffer, "# bounding sphere (center, radius)", values, 4, float_precision);
+}
+
+/* format the vertices "first" to "last" (excluded) of a solid mesh as obj "v" lines (returns 0 on error) */
+int solid_mesh_format_obj_vertices(const solid_mesh_t *solid_mesh, int first, int last, int float_precision, solid_buffer_t *buffer)
+{
+    int vertex_index = 0;
+    char *line = NULL;
+    char *cursor = NULL;
+
+    /* floats and integers are formatted by hand, printf is far too slow for big meshes */
+    for(vertex_index=first; vertex_index<last; vertex_index++)
+        {
+            line = (char *) solid_buffer_reserve(buffer, 2 + 3 * (TEXT_FLOAT_MAX_LENGTH + 1) + 5);
+            if (line == NULL)
+                return 0;
+            cursor = line;
+            *cursor++ = 'v';
+            *cursor++ = ' ';
+            cursor = text_format_float(cursor, solid_mesh->vertices[vertex_index].x, float_precision);
+            *cursor++ = ' ';
+            /* Up vector must be swapped for blender (blender uses Z as the up vector) */
+            cursor = text_format_float(cursor, -1 * solid_mesh->vertices[vertex_index].z, float_precision);
+            *cursor++ = ' ';
+            cursor = text_format_float(cursor, solid_mesh->vertices[vertex_index].y, float_precision);
+            memcpy(cursor, " 1.0\n", 5);
+            cursor += 5;
+            buffer->used += cursor - line;
+        }
+
+    return 1;
+}
+
+/* format the normals of the vertices "first" to "last" (excluded) of a solid mesh as obj "vn" lines (returns 0 on error) */
+int solid_mesh_format_obj_normals(const solid_XYZ_t *vertex_normals, int first, int last, int float_precision, solid_buffer_t *buffer)
+{
+    int vertex_index = 0;
+    char *line = NULL;
+    char *cursor = NULL;
+
+    for(vertex_index=first; vertex_index<last; vertex_index++)
+        {
+            line = (char *) solid_buffer_reserve(buffer, 3 + 3 * (TEXT_FLOAT_MAX_LENGTH + 1) + 1);
+            if (line == NULL)
+                return 0;
+            cursor = line;
+            memcpy(cursor, "vn ", 3);
+            cursor = text_format_float(cursor + 3, vertex_normals[vertex_index].x, float_precision);
+            *cursor++ = ' ';
+            /* swapped as the vertices are */
+            cursor = text_format_float(cursor, -1 * vertex_normals[vertex_index].z, float_precision);
+            *cursor++ = ' ';
+            cursor = text_format_float(cursor, vertex_normals[vertex_index].y, float_precision);
+            *cursor++ = '\n';
+            buffer->used += cursor - line;
+        }
+
+    return 1;
+}
+
+/* format the triangles "first" to "last" (excluded) of a solid mesh as obj "f" lines (using the normals of their vertices if "with_normals"), with
+   a usemtl line when the material differs from the previous one ("previous_material_id" is the one in use before "first", returns 0 on error) */
+int solid_mesh_format_obj_triangles(const solid_mesh_t *solid_mesh, const int *triangle_material_ids, int first, int last, int previous_material_id, int with_normals, solid_buffer_t *buffer)
+{
+    int triangle_index = 0;
+    int corner_index = 0;
+    char *line = NULL;
+    char *cursor = NULL;
+
+    for(triangle_index=first; triangle_index<last; triangle_index++)
+        {
+            line = (char *) solid_buffer_reserve(buffer, 16 + 11 + 1 + 1 + 3 * 13 + 1);
+            if (line == NULL)
+                return 0;
+            cursor = line;
+            if (triangle_material_ids[triangle_index] >= 0 && triangle_material_ids[triangle_index] != previous_material_id)
+                {
+                    memcpy(cursor, "usemtl material_", 16);
+                    cursor = text_format_int(cursor + 16, triangle_material_ids[triangle_index]);
+                    *cursor++ = '\n';
+                    previous_material_id = triangle_material_ids[triangle_index];
+                }
+            /* indexes are written as unsigned shorts, as the "%hu" format did */
+            *cursor++ = 'f';
+            for (corner_index = 0; corner_index < 3; corner_index++)
+                {
+                    *cursor++ = ' ';
+                    cursor = text_format_uint(cursor, (unsigned short) (solid_mesh->triangles[triangle_index].vertex[corner_index] + 1));
+                    /* a normal per vertex, with the same index */
+                    if (with_normals)
+                        {
+                            *cursor++ = '/';
+                            *cursor++ = '/';
+                            cursor = text_format_uint(cursor, (unsigned short) (solid_mesh->triangles[triangle_index].vertex[corner_index] + 1));
+                        }
+                }
+            *cursor++ = '\n';
+            buffer->used += cursor - line;
+        }
+
+    return 1;
+}
+
+/* format the mtl file of a solid mesh from its material table (returns 0 on error) */
+int solid_mesh_format_mtl(const solid_mesh_t *solid_mesh, const char *obj_name, const solid_material_table_t *material_table, int float_precision, solid_buffer_t *material_buffer)
+{
+    int material_index = 0;
+    const solid_material_t *material = NULL;
+    char *line = NULL;
+    char *cursor = NULL;
+    int result = 1;
+
+    /* header */
+    result &= solid_buffer_printf(material_buffer, "# material file for Blackshade's solid mesh file '%s' converted to obj '%s'\n", solid_mesh->filename, obj_name);
+
+    /* export materials (by increasing id) */
+    for (material_index = material_table->materials_used - 1; result && material_index >= 0; material_index--)
+        {
+            material = &material_table->materials[material_index];
+
+            result &= solid_buffer_printf(material_buffer, "\nnewmtl %s\n", material->name);
+            /* ambient color */
+            result &= solid_buffer_printf(material_buffer, "Ka 1.0 1.0 1.0\n");
+            /* diffuse color */
+            line = (char *) solid_buffer_reserve(material_buffer, 3 + 3 * (TEXT_FLOAT_MAX_LENGTH + 1) + 1);
+            if (line == NULL)
+                return 0;
+            cursor = line;
+            memcpy(cursor, "Kd ", 3);
+            cursor = text_format_float(cursor + 3, material->r, float_precision);
+            *cursor++ = ' ';
+            cursor = text_format_float(cursor, material->g, float_precision);
+            *cursor++ = ' ';
+            cursor = text_format_float(cursor, material->b, float_precision);
+            *cursor++ = '\n';
+            material_buffer->used += cursor - line;
+
+            /* specular color */
+            result &= solid_buffer_printf(material_buffer, "Ks 0.0 0.0 0.0\n");
+            result &= solid_buffer_printf(material_buffer, "Ns 0.0\n");
+        }
+
+    return result;
+}
+
+/* format an obj file and its mtl file into buffers ("material_name" is written as mtllib, options may be NULL, returns 0 on error) */
+int solid_mesh_serialize_obj(solid_mesh_t *solid_mesh, const char *obj_name, const char *material_name, const conversion_options_t *options, solid_buffer_t *obj_buffer, solid_buffer_t *material_buffer)
+{
+    conversion_options_t default_options;
+    solid_material_table_t *material_table = NULL;
+    solid_mesh_geometry_t geometry;
+    int *triangle_material_ids = NULL;
+    int result = 1;
+
+    if (solid_mesh == NULL)
+        {
+            report_error("Error : solid mesh is NULL in function solid_mesh_serialize_obj !\n");
+            return 0;
+        }
+
+    if (options == NULL)
+        {
+            conversion_options_init(&default_options);
+            options = &default_options;
+        }
+
+    solid_mesh_geometry_init(&geometry);
+    if (options->compute_normals && !solid_mesh_geometry_compute_staged(&geometry, solid_mesh))
+        return 0;
+
+    if (!solid_mesh_material_ids(solid_mesh, &material_table, &triangle_material_ids))
+        {
+            solid_mesh_geometry_free(&geometry);
+            return 0;
+        }
+
+    /* OBJ file */
+
+    /* header */
+    result &= solid_buffer_printf(obj_buffer, "# exported from Blackshade's solid mesh file '%s'\n", solid_mesh->filename);
+    if (options->compute_normals)
+        result = result && solid_mesh_geometry_format_obj_bounds(&geometry, options->float_precision, obj_buffer);
+
+    /* material file */
+    result &= solid_buffer_printf(obj_buffer, "mtllib %s\n", material_name);
+
+    /* export vertices, normals and triangles */
+    result = result
+             && solid_mesh_format_obj_vertices(solid_mesh, 0, solid_mesh->vertex_count, options->float_precision, obj_buffer)
+             && (!options->compute_normals || solid_mesh_format_obj_normals(geometry.vertex_normals, 0, geometry.vertex_count, options->float_precision, obj_buffer))
+             && solid_mesh_format_obj_triangles(solid_mesh, triangle_material_ids, 0, solid_mesh->triangle_count, -1, options->compute_normals, obj_buffer);
+
+    /* MTL file */
+    result = result && solid_mesh_format_mtl(solid_mesh, obj_name, material_table, options->float_precision, material_buffer);
+
+    if (!result)
+        report_error("Error : can't allocate obj buffers in function solid_mesh_serialize_obj !\n");
+
+    /* free data */
+    memory_free(material_table->arena, triangle_material_ids);
+    solid_material_table_free(material_table);
+    solid_mesh_geometry_free(&geometry);
+
+    return result;
+}
+
+/* format a range of vertices, normals or triangles of a solid mesh (thread entry point of solid_mesh_serialize_obj_parts) */
+void * obj_format_job_run(void *data)
+{
+    obj_format_job_t *job = (obj_format_job_t *) data;
+
+    if (job->triangle_material_ids != NULL)
+        job->result = solid_mesh_format_obj_triangles(job->solid_mesh, job->triangle_material_ids, job->first, job->last, job->previous_material_id, job->vertex_normals != NULL, &job->buffer);
+    else if (job->vertex_normals != NULL)
+        job->result = solid_mesh_format_obj_normals(job->vertex_normals, job->first, job->last, job->float_precision, &job->buffer);
+    else
+        job->result = solid_mesh_format_obj_vertices(job->solid_mesh, job->first, job->last, job->float_precision, &job->buffer);
+
+    return NULL;
+}
+
+/* format an obj file as 1 + 3 * ranges_count buffers to be written in order (the header, then ranges of vertices, of normals (empty
+   without normals) and of triangles formatted on threads) and its mtl file ("obj_parts" holds that many initialized buffers, returns 0 on error) */
+int solid_mesh_serialize_obj_parts(solid_mesh_t *solid_mesh, const char *obj_name, const char *material_name, const conversion_options_t *options, int ranges_count, solid_buffer_t *obj_parts, solid_buffer_t *material_buffer)
+{
+    conversion_options_t default_options;
+    solid_material_table_t *material_table = NULL;
+    solid_mesh_geometry_t geometry;
+    int *triangle_material_ids = NULL;
+    obj_format_job_t *jobs = NULL;
+    obj_format_job_t *job = NULL;
+    int jobs_count = 0;
+    int job_index = 0;
+    int range_index = 0;
+    int triangle_index = 0;
+    int previous_material_id = -1;
+    int result = 1;
+
+    if (solid_mesh == NULL)
+        {
+            report_error("Error : solid mesh is NULL in function solid_mesh_serialize_obj_parts !\n");
+            return 0;
+        }
+
+    if (options == NULL)
+        {
+            conversion_options_init(&default_options);
+            options = &default_options;
+        }
+
+    jobs = (obj_format_job_t *) calloc(3 * ranges_count, sizeof(obj_format_job_t));
+    if (jobs == NULL)
+        {
+            report_error("Error : can't allocate jobs in function solid_mesh_serialize_obj_parts !\n");
+            return 0;
+        }
+
+    solid_mesh_geometry_init(&geometry);
+    if (options->compute_normals && !solid_mesh_geometry_compute_staged(&geometry, solid_mesh))
+        {
+            free(jobs);
+            return 0;
+        }
+
+    if (!solid_mesh_material_ids(solid_mesh, &material_table, &triangle_material_ids))
+        {
+            solid_mesh_geometry_free(&geometry);
+            free(jobs);
+            return 0;
+        }
+
+    /* header */
+    result &= solid_buffer_printf(&obj_parts[0], "# exported from Blackshade's solid mesh file '%s'\n", solid_mesh->filename);
+    if (options->compute_normals)
+        result = result && solid_mesh_geometry_format_obj_bounds(&geometry, options->float_precision, &obj_parts[0]);
+    result &= solid_buffer_printf(&obj_parts[0], "mtllib %s\n", material_name);
+
+    /* vertex ranges first, then normal ranges and triangle ranges, in file order */
+    for (range_index = 0; range_index < ranges_count; range_index++)
+        {
+            job = &jobs[range_index];
+            job->solid_mesh = solid_mesh;
+            job->first = (int) ((long) solid_mesh->vertex_count * range_index / ranges_count);
+            job->last = (int) ((long) solid_mesh->vertex_count * (range_index + 1) / ranges_count);
+            job->float_precision = options->float_precision;
+            job->buffer = obj_parts[1 + range_index];
+
+            /* same vertices, nothing to format without normals */
+            job = &jobs[ranges_count + range_index];
+            *job = jobs[range_index];
+            job->vertex_normals = geometry.vertex_normals;
+            if (!options->compute_normals)
+                job->last = job->first;
+            job->buffer = obj_parts[1 + ranges_count + range_index];
+
+            job = &jobs[2 * ranges_count + range_index];
+            job->solid_mesh = solid_mesh;
+            job->triangle_material_ids = triangle_material_ids;
+            job->vertex_normals = options->compute_normals ? geometry.vertex_normals : NULL;
+            job->first = (int) ((long) solid_mesh->triangle_count * range_index / ranges_count);
+            job->last = (int) ((long) solid_mesh->triangle_count * (range_index + 1) / ranges_count);
+            job->buffer = obj_parts[1 + 2 * ranges_count + range_index];
+
+            /* usemtl state at the start of the range : the last material written before it */
+            job->previous_material_id = previous_material_id;
+            for (triangle_index = job->first; triangle_index < job->last; triangle_index++)
+                {
+                    if (triangle_material_ids[triangle_index] >= 0)
+                        previous_material_id = triangle_material_ids[triangle_index];
+                }
+        }
+
+    /* empty ranges (all the normal ones without normals) leave their buffer empty, the others are run on ranges_count threads */
+    for (range_index = 0; range_index < 3 * ranges_count; range_index++)
+        {
+            if (jobs[range_index].first < jobs[range_index].last)
+                {
+                    jobs[jobs_count] = jobs[range_index];
+                    jobs[jobs_count].part_index = 1 + range_index;
+                    jobs_count++;
+                }
+        }
+    threads_run_jobs(obj_format_job_run, jobs, sizeof(obj_format_job_t), jobs_count, ranges_count);
+
+    /* buffers go back to the caller */
+    for (job_index = 0; job_index < jobs_count; job_index++)
+        {
+            obj_parts[jobs[job_index].part_index] = jobs[job_index].buffer;
+            result &= jobs[job_index].result;
+        }
+
+    /* MTL file */
+    result = result && solid_mesh_format_mtl(solid_mesh, obj_name, material_table, options->float_precision, material_buffer);
+
+    if (!result)
+        report_error("Error : can't allocate obj buffers in function solid_mesh_serialize_obj_parts !\n");
+
+    /* free data */
+    free(jobs);
+    memory_free(material_table->arena, triangle_material_ids);
+    solid_material_table_free(material_table);
+    solid_mesh_geometry_free(&geometry);
+
+    return result;
+}
+
+/* convert a solid mesh to an obj one (options may be NULL, returns 0 on error) */
+int solid_mesh_convert_to_obj(solid_mesh_t *solid_mesh, char *output_file_path, char *output_material_file_path, const conversion_options_t *options)
+{
+    solid_buffer_t *obj_parts = NULL;
+    solid_buffer_t material_buffer;
+    int ranges_count = 1;
+    int parts_count = 0;
+    int part_index = 0;
+    int previous_stage = STATS_STAGE_NONE;
+    int result = 0;
+
+    if (solid_mesh == NULL)
+        {
+            report_error("Error : solid mesh is NULL in function solid_mesh_convert_to_obj !\n");
+            return 0;
+        }
+
+    /* small meshes are not worth the threads */
+    if (options != NULL)
+        ranges_count = options->threads_count;
+    if (ranges_count > (solid_mesh->vertex_count + solid_mesh->triangle_count) / OBJ_FORMAT_MIN_RANGE_SIZE)
+        ranges_count = (solid_mesh->vertex_count + solid_mesh->triangle_count) / OBJ_FORMAT_MIN_RANGE_SIZE;
+    if (ranges_count < 1)
+        ranges_count = 1;
+
+    parts_count = (ranges_count > 1) ? 1 + 3 * ranges_count : 1;
+    obj_parts = (solid_buffer_t *) malloc(sizeof(solid_buffer_t) * parts_count);
+    if (obj_parts == NULL)
+        {
+            report_error("Error : can't allocate obj buffers in function solid_mesh_convert_to_obj !\n");
+            return 0;
+        }
+    for (part_index = 0; part_index < parts_count; part_index++)
+        solid_buffer_init(&obj_parts[part_index]);
+    solid_buffer_init(&material_buffer);
+
+    /* obj readers look for the material file next to the obj file */
+    previous_stage = stats_enter_stage(STATS_STAGE_FORMAT);
+    if (ranges_count > 1)
+        result = solid_mesh_serialize_obj_parts(solid_mesh, output_file_path, path_relative_to_file(output_material_file_path, output_file_path), options, ranges_count, obj_parts, &material_buffer);
+    else
+        result = solid_mesh_serialize_obj(solid_mesh, output_file_path, path_relative_to_file(output_material_file_path, output_file_path), options, obj_parts, &material_buffer);
+    stats_enter_stage(previous_stage);
+    result = result
+             && solid_buffers_write_file(obj_parts, parts_count, output_file_path)
+             && solid_buffer_write_file(&material_buffer, output_material_file_path);
+
+    for (part_index = 0; part_index < parts_count; part_index++)
+        solid_buffer_free(&obj_parts[part_index]);
+    free(obj_parts);
+    solid_buffer_free(&material_buffer);
+
+    return result;
+}
+
+/* write the content of a buffer to an open file and empty it (returns 0 on error) */
+int solid_buffer_write_stream(solid_buffer_t *buffer, FILE *file, const char *path)
+{
+    int previous_stage = STATS_STAGE_NONE;
+
+    previous_stage = stats_enter_stage(STATS_STAGE_WRITE);
+    if (buffer->used > 0 && fwrite(buffer->data, buffer->used, 1, file) != 1)
+        {
+            report_error("Error : can't write '%s' !\n", path);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+    STATS_ADD(bytes_written, buffer->used);
+    buffer->used = 0;
+    stats_enter_stage(previous_stage);
+    return 1;
+}
+
+/* read "count" records of "record_size" bytes at "offset" in an open solid file (returns 0 on error) */
+int solid_file_read_records(FILE *file, const char *path, long offset, unsigned char *records, size_t record_size, int count)
+{
+    int previous_stage = STATS_STAGE_NONE;
+
+    previous_stage = stats_enter_stage(STATS_STAGE_READ);
+    if (fseek(file, offset, SEEK_SET) != 0 || fread(records, record_size, count, file) != (size_t) count)
+        {
+            report_error("Error : can't read '%s' !\n", path);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+    STATS_ADD(bytes_read, record_size * count);
+    stats_enter_stage(previous_stage);
+    return 1;
+}
+
+/* convert a solid file to an obj file reading and writing "window_size" vertices or triangles at a time, the triangles being
+   read twice (colors first, then faces) : the memory used depends on the window and on the number of colors only (options may be NULL, returns 0 on error) */
+int solid_file_stream_to_obj(char *solid_file_path, char *obj_file_path, char *obj_material_file_path, const conversion_options_t *options, int window_size)
+{
+    conversion_options_t default_options;
+    solid_mesh_t *solid_mesh = NULL;
+    solid_mesh_t window;
+    solid_material_table_t *material_table = NULL;
+    solid_buffer_t buffer;
+    unsigned char *records = NULL;
+    int *triangle_material_ids = NULL;
+    FILE *solid_file = NULL;
+    FILE *obj_file = NULL;
+    unsigned char header[4];
+    short vertex_count = 0;
+    short triangle_count = 0;
+    long file_size = 0;
+    long triangles_offset = 0;
+    int first = 0;
+    int count = 0;
+    int index = 0;
+    int material_index = 0;
+    int previous_material_id = -1;
+    int pass = 0;
+    int previous_stage = STATS_STAGE_NONE;
+    int result = 1;
+
+    if (options == NULL)
+        {
+            conversion_options_init(&default_options);
+            options = &default_options;
+        }
+    if (window_size < 1 || window_size > 32767)
+        window_size = SOLID_STREAM_WINDOW_SIZE;
+
+    memset(&window, 0, sizeof(solid_mesh_t));
+    strncpy(window.filename, solid_file_path, sizeof(window.filename) - 1);
+    solid_buffer_init(&buffer);
+
+    previous_stage = stats_enter_stage(STATS_STAGE_OPEN);
+    solid_file = fopen(solid_file_path, "rb");
+    if (solid_file == NULL)
+        {
+            report_error("can't load file '%s' !\n", solid_file_path);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+
+    /* the header and the size of the file, to refuse truncated files before writing anything */
+    if (fread(header, 4, 1, solid_file) != 1)
+        {
+            report_error("Error : '%s' is too small to be a solid file !\n", solid_file_path);
+            fclose(solid_file);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+
+    /* compact solid files are small and can't be read in place, they are loaded whole */
+    if (memcmp(header, SOLID_V2_MAGIC, 4) == 0)
+        {
+            fclose(solid_file);
+            stats_enter_stage(previous_stage);
+            solid_mesh = solid_mesh_load(solid_file_path);
+            if (solid_mesh == NULL)
+                return 0;
+            result = solid_mesh_convert_to_obj(solid_mesh, obj_file_path, obj_material_file_path, options);
+            solid_mesh_free(solid_mesh);
+            return result;
+        }
+
+    vertex_count = (short) ((header[0] << 8) | header[1]);
+    triangle_count = (short) ((header[2] << 8) | header[3]);
+    if (fseek(solid_file, 0, SEEK_END) == 0)
+        file_size = ftell(solid_file);
+    if (vertex_count < 0 || triangle_count < 0 || file_size < 4 + (long) vertex_count * 12 + (long) triangle_count * 20)
+        {
+            report_error("Error : '%s' is truncated or corrupted (%d vertices, %d triangles) !\n", solid_file_path, vertex_count, triangle_count);
+            fclose(solid_file);
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+    report_info("%d vertices to read\n", vertex_count);
+    report_info("%d triangles to read\n", triangle_count);
+    report_info("creating obj file...\n");
+    triangles_offset = 4 + (long) vertex_count * 12;
+
+    records = (unsigned char *) malloc((size_t) window_size * 20);
+    window.vertices = (solid_XYZ_t *) malloc(sizeof(solid_XYZ_t) * window_size);
+    window.triangles = (solid_textured_triangle_t *) malloc(sizeof(solid_textured_triangle_t) * window_size);
+    triangle_material_ids = (int *) malloc(sizeof(int) * window_size);
+    material_table = solid_material_table_create();
+    if (records == NULL || window.vertices == NULL || window.triangles == NULL || triangle_material_ids == NULL || material_table == NULL)
+        {
+            report_error("Error : can't allocate windows in function solid_file_stream_to_obj !\n");
+            result = 0;
+        }
+
+    /* first pass over the triangles : the colors (material ids depend on all of them) */
+    stats_enter_stage(STATS_STAGE_DEDUP);
+    for (first = 0; result && first < triangle_count; first += count)
+        {
+            count = (triangle_count - first < window_size) ? triangle_count - first : window_size;
+            result = solid_file_read_records(solid_file, solid_file_path, triangles_offset + (long) first * 20, records, 20, count);
+            if (!result)
+                break;
+            stats_enter_stage(STATS_STAGE_PARSE);
+            solid_decode_triangles(window.triangles, records, count);
+            stats_enter_stage(STATS_STAGE_DEDUP);
+            for (index = 0; result && index < count; index++)
+                result = solid_material_table_get_or_insert(material_table, window.triangles[index].r, window.triangles[index].g, window.triangles[index].b) >= 0;
+        }
+    if (result)
+        {
+            solid_material_table_assign_unique_id_and_name(material_table);
+            report_info("%lu material(s) declared\n", (unsigned long) material_table->materials_used);
+
+            stats_enter_stage(STATS_STAGE_OPEN);
+            obj_file = fopen(obj_file_path, "wb");
+            if (obj_file == NULL)
+                {
+                    report_error("Error : can't open '%s' for writing !\n", obj_file_path);
+                    result = 0;
+                }
+        }
+
+    /* header, then vertices and faces window after window (the second pass over the triangles) */
+    stats_enter_stage(STATS_STAGE_FORMAT);
+    if (result)
+        {
+            result &= solid_buffer_printf(&buffer, "# exported from Blackshade's solid mesh file '%s'\n", window.filename);
+            result &= solid_buffer_printf(&buffer, "mtllib %s\n", path_relative_to_file(obj_material_file_path, obj_file_path));
+            result = result && solid_buffer_write_stream(&buffer, obj_file, obj_file_path);
+        }
+    for (pass = 0; pass < 2; pass++)
+        {
+            for (first = 0; result && first < (pass == 0 ? vertex_count : triangle_count); first += count)
+                {
+                    if (pass == 0)
+                        {
+                            count = (vertex_count - first < window_size) ? vertex_count - first : window_size;
+                            result = solid_file_read_records(solid_file, solid_file_path, 4 + (long) first * 12, records, 12, count);
+                            if (!result)
+                                break;
+                            stats_enter_stage(STATS_STAGE_PARSE);
+                            solid_decode_vertices(window.vertices, records, count);
+                            stats_enter_stage(STATS_STAGE_FORMAT);
+                            window.vertex_count = (short) count;
+                            result = solid_mesh_format_obj_vertices(&window, 0, count, options->float_precision, &buffer);
+                        }
+                    else
+                        {
+                            count = (triangle_count - first < window_size) ? triangle_count - first : window_size;
+                            result = solid_file_read_records(solid_file, solid_file_path, triangles_offset + (long) first * 20, records, 20, count);
+                            if (!result)
+                                break;
+                            stats_enter_stage(STATS_STAGE_PARSE);
+                            solid_decode_triangles(window.triangles, records, count);
+                            stats_enter_stage(STATS_STAGE_FORMAT);
+                            window.triangle_count = (short) count;
+                            for (index = 0; index < count; index++)
+                                {
+                                    material_index = solid_material_table_get_or_insert(material_table, window.triangles[index].r, window.triangles[index].g, window.triangles[index].b);
+                                    triangle_material_ids[index] = (material_index >= 0) ? material_table->materials[material_index].id : -1;
+                                }
+                            result = solid_mesh_format_obj_triangles(&window, triangle_material_ids, 0, count, previous_material_id, 0, &buffer);
+                            for (index = 0; index < count; index++)
+                                {
+                                    if (triangle_material_ids[index] >= 0)
+                                        previous_material_id = triangle_material_ids[index];
+                                }
+                        }
+                    result = result && solid_buffer_write_stream(&buffer, obj_file, obj_file_path);
+                }
+        }
+    stats_enter_stage(STATS_STAGE_WRITE);
+    if (obj_file != NULL && fclose(obj_file) != 0)
+        {
+            report_error("Error : can't write '%s' !\n", obj_file_path);
+            result = 0;
+        }
+
+    /* MTL file */
+    stats_enter_stage(STATS_STAGE_FORMAT);
+    if (result)
+        {
+            buffer.used = 0;
+            result = solid_mesh_format_mtl(&window, obj_file_path, material_table, options->float_precision, &buffer)
+                     && solid_buffer_write_file(&buffer, obj_material_file_path);
+        }
+    report_info("...done !\n");
+
+    /* free data */
+    fclose(solid_file);
+    free(records);
+    free(window.vertices);
+    free(window.triangles);
+    free(triangle_material_ids);
+    if (material_table != NULL)
+        solid_material_table_free(material_table);
+    solid_buffer_free(&buffer);
+    stats_enter_stage(previous_stage);
+
+    return result;
+}
+
+/* cell of the welding grid holding a coordinate (cells are "epsilon" wide, exact duplicates are looked for by bit pattern when it is 0) */
+int64_t obj_weld_cell(float coordinate, float epsilon)
+{
+    union
+    {
+        float f;
+        uint32_t u;
+    } bits;
+    double cell = 0.0;
+    int64_t index = 0;
+
+    if (epsilon <= 0.0f)
+        {
+            /* -0.0 and 0.0 are the same position */
+            bits.f = (coordinate == 0.0f) ? 0.0f : coordinate;
+            return (int64_t) bits.u;
+        }
+
+    /* cells are a bit wider than epsilon, so that rounding never puts two close vertices more than one cell apart */
+    cell = (double) coordinate / ((double) epsilon * 1.000001);
+    if (cell != cell)
+        return 0;
+    if (cell > 4e18)
+        cell = 4e18;
+    else if (cell < -4e18)
+        cell = -4e18;
+
+    /* floor without the math library */
+    index = (int64_t) cell;
+    if ((double) index > cell)
+        index--;
+
+    return index;
+}
+
+/* hash the coordinates of a cell of the welding grid */
+unsigned int obj_weld_cell_hash(int64_t x, int64_t y, int64_t z)
+{
+    uint64_t hash = 0;
+
+    hash = (uint64_t) x * UINT64_C(0x9E3779B97F4A7C15);
+    hash ^= (uint64_t) y * UINT64_C(0xC2B2AE3D27D4EB4F);
+    hash ^= (uint64_t) z * UINT64_C(0x165667B19E3779F9);
+    hash ^= hash >> 32;
+
+    return (unsigned int) hash;
+}
+
+/* true if the corners of a face use at least 3 different vertices */
+int obj_face_has_three_vertices(const int *corner_vertices, int corner_count)
+{
+    int corner_index = 0;
+    int second = 0;
+
+    for (corner_index = 1; corner_index < corner_count && corner_vertices[corner_index] == corner_vertices[0]; corner_index++)
+        ;
+    if (corner_index >= corner_count)
+        return 0;
+
+    second = corner_vertices[corner_index];
+    for (corner_index++; corner_index < corner_count; corner_index++)
+        {
+            if (corner_vertices[corner_index] != corner_vertices[0] && corner_vertices[corner_index] != second)
+                return 1;
+        }
+    return 0;
+}
+
+/* merge the vertices closer than "epsilon" (0 merges exact duplicates only) and remap the faces, the first vertex of a group is kept
+   (vertices are hashed in a grid of cells "epsilon" wide, so only the neighbouring cells are searched, returns the number of vertices removed or -1 on error) */
+int obj_mesh_weld_vertices(obj_mesh_t *obj_mesh, float epsilon)
+{
+    int *slots = NULL;
+    int *next = NULL;
+    int *remap = NULL;
+    int slots_count = 16;
+    int vertices_count = 0;
+    int vertex_index = 0;
+    int kept_count = 0;
+    int candidate = 0;
+    int match = 0;
+    int corner_index = 0;
+    int corner_vertex = 0;
+    int face_index = 0;
+    int first_corner = 0;
+    int corner_count = 0;
+    int faces_kept = 0;
+    int corners_kept = 0;
+    int had_three_vertices = 0;
+    int has_three_vertices = 0;
+    int kept_index = 0;
+    int range = 0;
+    int dx = 0;
+    int dy = 0;
+    int dz = 0;
+    int64_t cell_x = 0;
+    int64_t cell_y = 0;
+    int64_t cell_z = 0;
+    double distance_x = 0.0;
+    double distance_y = 0.0;
+    double distance_z = 0.0;
+    double max_distance = 0.0;
+    obj_vertex_t *vertex = NULL;
+    obj_vertex_t *other = NULL;
+    unsigned int slot = 0;
+
+    if (obj_mesh == NULL)
+        return -1;
+
+    vertices_count = obj_mesh->vertices_used;
+    while (slots_count < vertices_count * 2)
+        slots_count *= 2;
+
+    slots = (int *) malloc(sizeof(int) * slots_count);
+    next = (int *) malloc(sizeof(int) * (vertices_count > 0 ? vertices_count : 1));
+    remap = (int *) malloc(sizeof(int) * (vertices_count > 0 ? vertices_count : 1));
+    if (slots == NULL || next == NULL || remap == NULL)
+        {
+            report_error("Error : can't allocate welding grid in function obj_mesh_weld_vertices !\n");
+            free(slots);
+            free(next);
+            free(remap);
+            return -1;
+        }
+    memset(slots, -1, sizeof(int) * slots_count);
+
+    /* a vertex closer than epsilon may lie in any of the 26 cells around its own one */
+    range = (epsilon > 0.0f) ? 1 : 0;
+    max_distance = (epsilon > 0.0f) ? (double) epsilon * epsilon : 0.0;
+
+    for (vertex_index = 0; vertex_index < vertices_count; vertex_index++)
+        {
+            vertex = &obj_mesh->vertices[vertex_index];
+            cell_x = obj_weld_cell(vertex->x, epsilon);
+            cell_y = obj_weld_cell(vertex->y, epsilon);
+            cell_z = obj_weld_cell(vertex->z, epsilon);
+
+            /* look for a vertex already kept near this one (the chains of the slots only hold kept vertices) */
+            match = -1;
+            for (dx = -range; match == -1 && dx <= range; dx++)
+                for (dy = -range; match == -1 && dy <= range; dy++)
+                    for (dz = -range; match == -1 && dz <= range; dz++)
+                        {
+                            slot = obj_weld_cell_hash(cell_x + dx, cell_y + dy, cell_z + dz) & (slots_count - 1);
+                            for (candidate = slots[slot]; candidate != -1; candidate = next[candidate])
+                                {
+                                    other = &obj_mesh->vertices[candidate];
+                                    distance_x = (double) other->x - vertex->x;
+                                    distance_y = (double) other->y - vertex->y;
+                                    distance_z = (double) other->z - vertex->z;
+                                    if (distance_x * distance_x + distance_y * distance_y + distance_z * distance_z <= max_distance)
+                                        {
+                                            match = candidate;
+                                            break;
+                                        }
+                                }
+                        }
+
+            if (match != -1)
+                {
+                    remap[vertex_index] = match;
+                }
+            else
+                {
+                    /* kept vertices are packed at the start of the array */
+                    obj_mesh->vertices[kept_count] = *vertex;
+                    remap[vertex_index] = kept_count;
+                    slot = obj_weld_cell_hash(cell_x, cell_y, cell_z) & (slots_count - 1);
+                    next[kept_count] = slots[slot];
+                    slots[slot] = kept_count;
+                    kept_count++;
+                }
+        }
+
+    /* corners refer to the kept vertices (indexes out of range are left as they are), the faces whose corners have been merged down to
+       fewer than 3 vertices are dropped, the corners merged with an earlier one of their face too (their fans would hold degenerate triangles),
+       and the rest is packed at the start of the arrays */
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            first_corner = obj_mesh->face_offsets[face_index];
+            corner_count = obj_mesh->face_offsets[face_index + 1] - first_corner;
+            had_three_vertices = obj_face_has_three_vertices(obj_mesh->corner_vertices + first_corner, corner_count);
+            for (corner_index = first_corner; corner_index < first_corner + corner_count; corner_index++)
+                {
+                    corner_vertex = obj_mesh->corner_vertices[corner_index];
+                    if (corner_vertex >= 1 && corner_vertex <= vertices_count)
+                        obj_mesh->corner_vertices[corner_index] = remap[corner_vertex - 1] + 1;
+                }
+            has_three_vertices = obj_face_has_three_vertices(obj_mesh->corner_vertices + first_corner, corner_count);
+            if (had_three_vertices && !has_three_vertices)
+                continue;
+
+            obj_mesh->face_offsets[faces_kept] = corners_kept;
+            obj_mesh->face_materials[faces_kept] = obj_mesh->face_materials[face_index];
+            for (corner_index = first_corner; corner_index < first_corner + corner_count; corner_index++)
+                {
+                    /* faces using 3 vertices or more keep at least 3 corners (faces that were already degenerate are left as they are) */
+                    corner_vertex = obj_mesh->corner_vertices[corner_index];
+                    for (kept_index = obj_mesh->face_offsets[faces_kept]; has_three_vertices && kept_index < corners_kept; kept_index++)
+                        {
+                            if (obj_mesh->corner_vertices[kept_index] == corner_vertex)
+                                break;
+                        }
+                    if (has_three_vertices && kept_index < corners_kept)
+                        continue;
+
+                    obj_mesh->corner_vertices[corners_kept] = corner_vertex;
+                    if (obj_mesh->corner_textures != NULL)
+                        obj_mesh->corner_textures[corners_kept] = obj_mesh->corner_textures[corner_index];
+                    if (obj_mesh->corner_normals != NULL)
+                        obj_mesh->corner_normals[corners_kept] = obj_mesh->corner_normals[corner_index];
+                    corners_kept++;
+                }
+            faces_kept++;
+        }
+    if (faces_kept < obj_mesh->faces_used)
+        report_info("welding dropped %d faces left with fewer than 3 vertices\n", obj_mesh->faces_used - faces_kept);
+    if (obj_mesh->face_offsets != NULL)
+        obj_mesh->face_offsets[faces_kept] = corners_kept;
+    obj_mesh->faces_used = faces_kept;
+    obj_mesh->corners_used = corners_kept;
+    obj_mesh->vertices_used = kept_count;
+
+    free(slots);
+    free(next);
+    free(remap);
+
+    return vertices_count - kept_count;
+}
+
+/* split the faces of a obj mesh with more than 3 corners in fans of triangles, as they are written in solid files (returns 0 on error) */
+int obj_mesh_triangulate(obj_mesh_t *obj_mesh)
+{
+    int *face_offsets = NULL;
+    int *face_materials = NULL;
+    int *corner_vertices = NULL;
+    int *corner_textures = NULL;
+    int *corner_normals = NULL;
+    int triangles_count = 0;
+    int triangle_index = 0;
+    int face_index = 0;
+    int first_corner = 0;
+    int corner_count = 0;
+    int corner_index = 0;
+    int fan_corners[3];
+    int index = 0;
+
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        triangles_count += obj_face_corner_count(obj_mesh, face_index) - 2;
+
+    /* nothing to do if all the faces are triangles already */
+    if (triangles_count == obj_mesh->faces_used)
+        return 1;
+
+    face_offsets = (int *) memory_alloc(obj_mesh->arena, sizeof(int) * (triangles_count + 1));
+    face_materials = (int *) memory_alloc(obj_mesh->arena, sizeof(int) * (triangles_count > 0 ? triangles_count : 1));
+    corner_vertices = (int *) memory_alloc(obj_mesh->arena, sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    if (obj_mesh->corner_textures != NULL)
+        corner_textures = (int *) memory_alloc(obj_mesh->arena, sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    if (obj_mesh->corner_normals != NULL)
+        corner_normals = (int *) memory_alloc(obj_mesh->arena, sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    if (face_offsets == NULL || face_materials == NULL || corner_vertices == NULL
+            || (obj_mesh->corner_textures != NULL && corner_textures == NULL)
+            || (obj_mesh->corner_normals != NULL && corner_normals == NULL))
+        {
+            report_error("Error : can't allocate triangles in function obj_mesh_triangulate !\n");
+            memory_free(obj_mesh->arena, face_offsets);
+            memory_free(obj_mesh->arena, face_materials);
+            memory_free(obj_mesh->arena, corner_vertices);
+            memory_free(obj_mesh->arena, corner_textures);
+            memory_free(obj_mesh->arena, corner_normals);
+            return 0;
+        }
+
+    /* fans around the first corner of each face */
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            first_corner = obj_mesh->face_offsets[face_index];
+            corner_count = obj_face_corner_count(obj_mesh, face_index);
+            for (corner_index = 1; corner_index + 1 < corner_count; corner_index++)
+                {
+                    fan_corners[0] = first_corner;
+                    fan_corners[1] = first_corner + corner_index;
+                    fan_corners[2] = first_corner + corner_index + 1;
+                    for (index = 0; index < 3; index++)
+                        {
+                            corner_vertices[triangle_index * 3 + index] = obj_mesh->corner_vertices[fan_corners[index]];
+                            if (corner_textures != NULL)
+                                corner_textures[triangle_index * 3 + index] = obj_mesh->corner_textures[fan_corners[index]];
+                            if (corner_normals != NULL)
+                                corner_normals[triangle_index * 3 + index] = obj_mesh->corner_normals[fan_corners[index]];
+                        }
+                    face_offsets[triangle_index] = triangle_index * 3;
+                    face_materials[triangle_index] = obj_mesh->face_materials[face_index];
+                    triangle_index++;
+                }
+        }
+    face_offsets[triangles_count] = triangles_count * 3;
+
+    memory_free(obj_mesh->arena, obj_mesh->face_offsets);
+    memory_free(obj_mesh->arena, obj_mesh->face_materials);
+    memory_free(obj_mesh->arena, obj_mesh->corner_vertices);
+    if (obj_mesh->corner_textures != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->corner_textures);
+    if (obj_mesh->corner_normals != NULL)
+        memory_free(obj_mesh->arena, obj_mesh->corner_normals);
+
+    obj_mesh->face_offsets = face_offsets;
+    obj_mesh->face_materials = face_materials;
+    obj_mesh->faces_used = triangles_count;
+    obj_mesh->faces_allocated = triangles_count;
+    obj_mesh->corner_vertices = corner_vertices;
+    obj_mesh->corner_textures = corner_textures;
+    obj_mesh->corner_normals = corner_normals;
+    obj_mesh->corners_used = triangles_count * 3;
+    obj_mesh->corners_allocated = triangles_count * 3;
+
+    return 1;
+}
+
+/* average cache miss ratio (misses per triangle) of a obj mesh drawn with a FIFO vertex cache of "cache_size" entries, faces being split in fans */
+double obj_mesh_acmr(const obj_mesh_t *obj_mesh, int cache_size)
+{
+    int *insert_time = NULL;
+    int face_index = 0;
+    int first_corner = 0;
+    int corner_count = 0;
+    int corner_index = 0;
+    int fan_corners[3];
+    int index = 0;
+    int vertex = 0;
+    int misses = 0;
+    int triangles_count = 0;
+
+    /* a vertex is in the cache if less than cache_size vertices were loaded after it */
+    insert_time = (int *) calloc(obj_mesh->vertices_used > 0 ? obj_mesh->vertices_used : 1, sizeof(int));
+    if (insert_time == NULL)
+        {
+            report_error("Error : can't allocate vertex cache in function obj_mesh_acmr !\n");
+            return 0.0;
+        }
+
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            first_corner = obj_mesh->face_offsets[face_index];
+            corner_count = obj_face_corner_count(obj_mesh, face_index);
+            for (corner_index = 1; corner_index + 1 < corner_count; corner_index++)
+                {
+                    fan_corners[0] = first_corner;
+                    fan_corners[1] = first_corner + corner_index;
+                    fan_corners[2] = first_corner + corner_index + 1;
+                    for (index = 0; index < 3; index++)
+                        {
+                            vertex = obj_mesh->corner_vertices[fan_corners[index]] - 1;
+                            if (vertex < 0 || vertex >= obj_mesh->vertices_used)
+                                {
+                                    misses++;
+                                }
+                            else if (insert_time[vertex] == 0 || misses - insert_time[vertex] >= cache_size)
+                                {
+                                    misses++;
+                                    insert_time[vertex] = misses;
+                                }
+                        }
+                    triangles_count++;
+                }
+        }
+
+    free(insert_time);
+
+    return (triangles_count > 0) ? (double) misses / triangles_count : 0.0;
+}
+
+/* order in which to draw the triangles of a triangulated obj mesh for a vertex cache of "cache_size" entries
+   (Tipsify, Sander, Nehab and Barczak 2007 : fans around the vertices kept in the cache, returns NULL on error) */
+int * obj_mesh_tipsify(const obj_mesh_t *obj_mesh, int cache_size)
+{
+    int vertices_count = obj_mesh->vertices_used;
+    int triangles_count = obj_mesh->faces_used;
+    int *adjacency_offsets = NULL;
+    int *adjacency = NULL;
+    int *live_triangles = NULL;
+    int *cache_time = NULL;
+    int *dead_ends = NULL;
+    int *candidates = NULL;
+    char *emitted = NULL;
+    int *order = NULL;
+    int dead_ends_used = 0;
+    int candidates_used = 0;
+    int order_used = 0;
+    int time_stamp = 0;
+    int next_vertex = 0;
+    int fanning_vertex = 0;
+    int best_priority = 0;
+    int priority = 0;
+    int adjacency_index = 0;
+    int triangle = 0;
+    int corner_index = 0;
+    int vertex = 0;
+    int index = 0;
+
+    adjacency_offsets = (int *) calloc(vertices_count + 1, sizeof(int));
+    adjacency = (int *) malloc(sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    live_triangles = (int *) calloc(vertices_count > 0 ? vertices_count : 1, sizeof(int));
+    cache_time = (int *) calloc(vertices_count > 0 ? vertices_count : 1, sizeof(int));
+    dead_ends = (int *) malloc(sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    candidates = (int *) malloc(sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    emitted = (char *) calloc(triangles_count > 0 ? triangles_count : 1, sizeof(char));
+    order = (int *) malloc(sizeof(int) * (triangles_count > 0 ? triangles_count : 1));
+    if (adjacency_offsets == NULL || adjacency == NULL || live_triangles == NULL || cache_time == NULL
+            || dead_ends == NULL || candidates == NULL || emitted == NULL || order == NULL)
+        {
+            report_error("Error : can't allocate buffers in function obj_mesh_tipsify !\n");
+            free(order);
+            order = NULL;
+        }
+    else
+        {
+            /* triangles using each vertex */
+            for (index = 0; index < triangles_count * 3; index++)
+                live_triangles[obj_mesh->corner_vertices[index] - 1]++;
+            for (vertex = 0; vertex < vertices_count; vertex++)
+                adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live_triangles[vertex];
+            for (index = 0; index < triangles_count * 3; index++)
+                {
+                    vertex = obj_mesh->corner_vertices[index] - 1;
+                    adjacency[adjacency_offsets[vertex] + cache_time[vertex]] = index / 3;
+                    cache_time[vertex]++;
+                }
+            memset(cache_time, 0, sizeof(int) * vertices_count);
+
+            time_stamp = cache_size + 1;
+            fanning_vertex = (vertices_count > 0) ? 0 : -1;
+            while (fanning_vertex >= 0)
+                {
+                    /* emit all the triangles around the fanning vertex */
+                    candidates_used = 0;
+                    for (adjacency_index = adjacency_offsets[fanning_vertex]; adjacency_index < adjacency_offsets[fanning_vertex + 1]; adjacency_index++)
+                        {
+                            triangle = adjacency[adjacency_index];
+                            if (emitted[triangle])
+                                continue;
+
+                            for (corner_index = 0; corner_index < 3; corner_index++)
+                                {
+                                    vertex = obj_mesh->corner_vertices[triangle * 3 + corner_index] - 1;
+                                    dead_ends[dead_ends_used++] = vertex;
+                                    candidates[candidates_used++] = vertex;
+                                    live_triangles[vertex]--;
+                                    if (time_stamp - cache_time[vertex] > cache_size)
+                                        {
+                                            cache_time[vertex] = time_stamp;
+                                            time_stamp++;
+                                        }
+                                }
+                            emitted[triangle] = 1;
+                            order[order_used++] = triangle;
+                        }
+
+                    /* next fanning vertex : the oldest candidate still in the cache after its remaining triangles are drawn */
+                    fanning_vertex = -1;
+                    best_priority = -1;
+                    for (index = 0; index < candidates_used; index++)
+                        {
+                            vertex = candidates[index];
+                            if (live_triangles[vertex] <= 0)
+                                continue;
+
+                            priority = 0;
+                            if (time_stamp - cache_time[vertex] + 2 * live_triangles[vertex] <= cache_size)
+                                priority = time_stamp - cache_time[vertex];
+                            if (priority > best_priority)
+                                {
+                                    best_priority = priority;
+                                    fanning_vertex = vertex;
+                                }
+                        }
+
+                    /* dead end : go back to a recently used vertex, then to the next vertex in the input order */
+                    while (fanning_vertex == -1 && dead_ends_used > 0)
+                        {
+                            vertex = dead_ends[--dead_ends_used];
+                            if (live_triangles[vertex] > 0)
+                                fanning_vertex = vertex;
+                        }
+                    while (fanning_vertex == -1 && next_vertex < vertices_count)
+                        {
+                            if (live_triangles[next_vertex] > 0)
+                                fanning_vertex = next_vertex;
+                            else
+                                next_vertex++;
+                        }
+                }
+        }
+
+    free(adjacency_offsets);
+    free(adjacency);
+    free(live_triangles);
+    free(cache_time);
+    free(dead_ends);
+    free(candidates);
+    free(emitted);
+
+    return order;
+}
+
+/* average cache miss ratio of a triangulated obj mesh whose triangles are drawn in "order" (NULL for their own order)
+   with a FIFO vertex cache of "cache_size" entries (vertices must exist, returns a negative value on error) */
+double obj_mesh_order_acmr(const obj_mesh_t *obj_mesh, const int *order, int cache_size)
+{
+    int *insert_time = NULL;
+    int triangle_index = 0;
+    int triangle = 0;
+    int index = 0;
+    int vertex = 0;
+    int misses = 0;
+
+    insert_time = (int *) calloc(obj_mesh->vertices_used > 0 ? obj_mesh->vertices_used : 1, sizeof(int));
+    if (insert_time == NULL)
+        {
+            report_error("Error : can't allocate vertex cache in function obj_mesh_order_acmr !\n");
+            return -1.0;
+        }
+
+    for (triangle_index = 0; triangle_index < obj_mesh->faces_used; triangle_index++)
+        {
+            triangle = (order != NULL) ? order[triangle_index] : triangle_index;
+            for (index = 0; index < 3; index++)
+                {
+                    vertex = obj_mesh->corner_vertices[triangle * 3 + index] - 1;
+                    if (insert_time[vertex] == 0 || misses - insert_time[vertex] >= cache_size)
+                        {
+                            misses++;
+                            insert_time[vertex] = misses;
+                        }
+                }
+        }
+
+    free(insert_time);
+
+    return (obj_mesh->faces_used > 0) ? (double) misses / obj_mesh->faces_used : 0.0;
+}
+
+/* reorder the triangles of a obj mesh for a vertex cache of "cache_size" entries (faces are split in triangles first),
+   then number the vertices in the order they are first used (the order is kept if it misses the cache less, returns 0 on error) */
+int obj_mesh_optimize_vertex_cache(obj_mesh_t *obj_mesh, int cache_size)
+{
+    int *order = NULL;
+    int *remap = NULL;
+    int *corners = NULL;
+    int *materials = NULL;
+    obj_vertex_t *vertices = NULL;
+    int triangle_index = 0;
+    int corner_index = 0;
+    int vertex = 0;
+    int next_index = 0;
+    double acmr = 0.0;
+    double order_acmr = 0.0;
+    int result = 1;
+
+    if (obj_mesh == NULL || !obj_mesh_triangulate(obj_mesh))
+        return 0;
+
+    /* faces using vertices that don't exist are written as they are, the mesh is left alone */
+    for (corner_index = 0; corner_index < obj_mesh->corners_used; corner_index++)
+        {
+            vertex = obj_mesh->corner_vertices[corner_index];
+            if (vertex < 1 || vertex > obj_mesh->vertices_used)
+                {
+                    report_warning("Warning : face %d uses vertex %d which does not exist, vertex cache optimization skipped !\n", corner_index / 3 + 1, vertex);
+                    return 1;
+                }
+        }
+
+    order = obj_mesh_tipsify(obj_mesh, cache_size);
+    remap = (int *) malloc(sizeof(int) * (obj_mesh->vertices_used > 0 ? obj_mesh->vertices_used : 1));
+    corners = (int *) malloc(sizeof(int) * (obj_mesh->corners_used > 0 ? obj_mesh->corners_used : 1));
+    materials = (int *) malloc(sizeof(int) * (obj_mesh->faces_used > 0 ? obj_mesh->faces_used : 1));
+    vertices = (obj_vertex_t *) malloc(sizeof(obj_vertex_t) * (obj_mesh->vertices_used > 0 ? obj_mesh->vertices_used : 1));
+    if (order == NULL || remap == NULL || corners == NULL || materials == NULL || vertices == NULL)
+        {
+            report_error("Error : can't allocate buffers in function obj_mesh_optimize_vertex_cache !\n");
+            result = 0;
+        }
+    else if ((acmr = obj_mesh_order_acmr(obj_mesh, NULL, cache_size)) < 0.0 || (order_acmr = obj_mesh_order_acmr(obj_mesh, order, cache_size)) < 0.0)
+        {
+            result = 0;
+        }
+    else if (order_acmr >= acmr)
+        {
+            /* Tipsify doesn't beat meshes already ordered for the cache, their order is left alone */
+            report_info("vertex cache order kept, reordering would give %.3f misses per triangle against %.3f\n", order_acmr, acmr);
+        }
+    else
+        {
+            /* triangles in the new order (texture and normal indexes are not written in solid files, they follow anyway) */
+            for (triangle_index = 0; triangle_index < obj_mesh->faces_used; triangle_index++)
+                {
+                    memcpy(corners + triangle_index * 3, obj_mesh->corner_vertices + order[triangle_index] * 3, sizeof(int) * 3);
+                    materials[triangle_index] = obj_mesh->face_materials[order[triangle_index]];
+                }
+            memcpy(obj_mesh->corner_vertices, corners, sizeof(int) * obj_mesh->corners_used);
+            memcpy(obj_mesh->face_materials, materials, sizeof(int) * obj_mesh->faces_used);
+            if (obj_mesh->corner_textures != NULL)
+                {
+                    for (triangle_index = 0; triangle_index < obj_mesh->faces_used; triangle_index++)
+                        memcpy(corners + triangle_index * 3, obj_mesh->corner_textures + order[triangle_index] * 3, sizeof(int) * 3);
+                    memcpy(obj_mesh->corner_textures, corners, sizeof(int) * obj_mesh->corners_used);
+                }
+            if (obj_mesh->corner_normals != NULL)
+                {
+                    for (triangle_index = 0; triangle_index < obj_mesh->faces_used; triangle_index++)
+                        memcpy(corners + triangle_index * 3, obj_mesh->corner_normals + order[triangle_index] * 3, sizeof(int) * 3);
+                    memcpy(obj_mesh->corner_normals, corners, sizeof(int) * obj_mesh->corners_used);
+                }
+
+            /* vertices numbered in the order of their first use, unused ones last */
+            memset(remap, -1, sizeof(int) * obj_mesh->vertices_used);
+            for (corner_index = 0; corner_index < obj_mesh->corners_used; corner_index++)
+                {
+                    vertex = obj_mesh->corner_vertices[corner_index] - 1;
+                    if (remap[vertex] == -1)
+                        remap[vertex] = next_index++;
+                    obj_mesh->corner_vertices[corner_index] = remap[vertex] + 1;
+                }
+            for (vertex = 0; vertex < obj_mesh->vertices_used; vertex++)
+                {
+                    if (remap[vertex] == -1)
+                        remap[vertex] = next_index++;
+                    vertices[remap[vertex]] = obj_mesh->vertices[vertex];
+                }
+            memcpy(obj_mesh->vertices, vertices, sizeof(obj_vertex_t) * obj_mesh->vertices_used);
+        }
+
+    free(order);
+    free(remap);
+    free(corners);
+    free(materials);
+    free(vertices);
+
+    return result;
+}
+
+/* add the squared distance to a plane (a x + b y + c z + d = 0, normalized) times "weight" to a quadric */
+void obj_quadric_add_plane(obj_quadric_t *quadric, double a, double b, double c, double d, double weight)
+{
+    quadric->a2 += weight * a * a;
+    quadric->ab += weight * a * b;
+    quadric->ac += weight * a * c;
+    quadric->ad += weight * a * d;
+    quadric->b2 += weight * b * b;
+    quadric->bc += weight * b * c;
+    quadric->bd += weight * b * d;
+    quadric->c2 += weight * c * c;
+    quadric->cd += weight * c * d;
+    quadric->d2 += weight * d * d;
+}
+
+/* add a quadric to another one */
+void obj_quadric_add(obj_quadric_t *quadric, const obj_quadric_t *other)
+{
+    quadric->a2 += other->a2;
+    quadric->ab += other->ab;
+    quadric->ac += other->ac;
+    quadric->ad += other->ad;
+    quadric->b2 += other->b2;
+    quadric->bc += other->bc;
+    quadric->bd += other->bd;
+    quadric->c2 += other->c2;
+    quadric->cd += other->cd;
+    quadric->d2 += other->d2;
+}
+
+/* value of a quadric at a position (3 doubles) */
+double obj_quadric_error(const obj_quadric_t *quadric, const double *position)
+{
+    double x = position[0];
+    double y = position[1];
+    double z = position[2];
+    double error = 0.0;
+
+    error = x * (quadric->a2 * x + 2.0 * (quadric->ab * y + quadric->ac * z + quadric->ad))
+          + y * (quadric->b2 * y + 2.0 * (quadric->bc * z + quadric->bd))
+          + z * (quadric->c2 * z + 2.0 * quadric->cd)
+          + quadric->d2;
+
+    /* rounding can make it slightly negative */
+    return (error > 0.0) ? error : 0.0;
+}
+
+/* vertex a corner of a triangle is now merged into */
+#define OBJ_DECIMATION_CORNER(decimation, triangle, corner) ((decimation)->representatives[(decimation)->corners[(triangle) * 3 + (corner)]])
+
+/* true if the edge between two alive vertices is on a border (of the mesh or between two materials) */
+int obj_decimation_edge_is_border(const obj_decimation_t *decimation, int vertex, int other_vertex)
+{
+    int member = vertex;
+    int triangle_index = 0;
+    int triangle = 0;
+    int triangles_count = 0;
+    int material = 0;
+
+    do
+        {
+            for (triangle_index = decimation->triangle_offsets[member]; triangle_index < decimation->triangle_offsets[member + 1]; triangle_index++)
+                {
+                    triangle = decimation->vertex_triangles[triangle_index];
+                    if (!decimation->triangle_alive[triangle])
+                        continue;
+                    if (OBJ_DECIMATION_CORNER(decimation, triangle, 0) != other_vertex
+                            && OBJ_DECIMATION_CORNER(decimation, triangle, 1) != other_vertex
+                            && OBJ_DECIMATION_CORNER(decimation, triangle, 2) != other_vertex)
+                        continue;
+
+                    if (triangles_count == 0)
+                        material = decimation->obj_mesh->face_materials[triangle];
+                    else if (decimation->obj_mesh->face_materials[triangle] != material)
+                        return 1;
+                    triangles_count++;
+                }
+            member = decimation->next_merged[member];
+        }
+    while (member != vertex);
+
+    return triangles_count != 2;
+}
+
+/* true if collapsing a vertex into another one flips none of the triangles left */
+int obj_decimation_collapse_is_valid(const obj_decimation_t *decimation, int vertex, int target)
+{
+    const double *positions[3];
+    double old_normal[3];
+    double new_normal[3];
+    double edges[2][3];
+    int member = vertex;
+    int triangle_index = 0;
+    int triangle = 0;
+    int corner = 0;
+    int moved_corner = 0;
+    int corner_vertex = 0;
+    int axis = 0;
+
+    do
+        {
+            for (triangle_index = decimation->triangle_offsets[member]; triangle_index < decimation->triangle_offsets[member + 1]; triangle_index++)
+                {
+                    triangle = decimation->vertex_triangles[triangle_index];
+                    if (!decimation->triangle_alive[triangle])
+                        continue;
+
+                    moved_corner = -1;
+                    for (corner = 0; corner < 3; corner++)
+                        {
+                            corner_vertex = OBJ_DECIMATION_CORNER(decimation, triangle, corner);
+                            if (corner_vertex == target)
+                                break;
+                            if (corner_vertex == vertex)
+                                moved_corner = corner;
+                            positions[corner] = decimation->positions + corner_vertex * 3;
+                        }
+                    /* triangles using both vertices disappear */
+                    if (corner < 3)
+                        continue;
+
+                    for (axis = 0; axis < 3; axis++)
+                        {
+                            edges[0][axis] = positions[1][axis] - positions[0][axis];
+                            edges[1][axis] = positions[2][axis] - positions[0][axis];
+                        }
+                    old_normal[0] = edges[0][1] * edges[1][2] - edges[0][2] * edges[1][1];
+                    old_normal[1] = edges[0][2] * edges[1][0] - edges[0][0] * edges[1][2];
+                    old_normal[2] = edges[0][0] * edges[1][1] - edges[0][1] * edges[1][0];
+
+                    positions[moved_corner] = decimation->positions + target * 3;
+                    for (axis = 0; axis < 3; axis++)
+                        {
+                            edges[0][axis] = positions[1][axis] - positions[0][axis];
+                            edges[1][axis] = positions[2][axis] - positions[0][axis];
+                        }
+                    new_normal[0] = edges[0][1] * edges[1][2] - edges[0][2] * edges[1][1];
+                    new_normal[1] = edges[0][2] * edges[1][0] - edges[0][0] * edges[1][2];
+                    new_normal[2] = edges[0][0] * edges[1][1] - edges[0][1] * edges[1][0];
+
+                    if (old_normal[0] * new_normal[0] + old_normal[1] * new_normal[1] + old_normal[2] * new_normal[2] <= 0.0)
+                        return 0;
+                }
+            member = decimation->next_merged[member];
+        }
+    while (member != vertex);
+
+    return 1;
+}
+
+/* find the cheapest collapse of an alive vertex into one of its neighbours, flipping no triangle if "check_flips" is true
+   (costs and targets, the heap is not updated) */
+void obj_decimation_best_collapse(obj_decimation_t *decimation, int vertex, int check_flips)
+{
+    int kind = decimation->kinds[vertex];
+    int member = vertex;
+    int triangle_index = 0;
+    int triangle = 0;
+    int corner = 0;
+    int neighbour = 0;
+    double cost = 0.0;
+
+    decimation->costs[vertex] = DBL_MAX;
+    decimation->targets[vertex] = -1;
+    if (decimation->representatives[vertex] != vertex || kind == OBJ_DECIMATION_LOCKED || decimation->live_triangles[vertex] == 0)
+        return;
+
+    do
+        {
+            for (triangle_index = decimation->triangle_offsets[member]; triangle_index < decimation->triangle_offsets[member + 1]; triangle_index++)
+                {
+                    triangle = decimation->vertex_triangles[triangle_index];
+                    if (!decimation->triangle_alive[triangle])
+                        continue;
+
+                    for (corner = 0; corner < 3; corner++)
+                        {
+                            neighbour = OBJ_DECIMATION_CORNER(decimation, triangle, corner);
+                            if (neighbour == vertex || neighbour == decimation->targets[vertex])
+                                continue;
+                            /* around an interior vertex each neighbour follows the vertex in one triangle and precedes it in another */
+                            if (kind == OBJ_DECIMATION_INTERIOR && OBJ_DECIMATION_CORNER(decimation, triangle, (corner + 2) % 3) != vertex)
+                                continue;
+                            /* border vertices only slide along their border */
+                            if (kind == OBJ_DECIMATION_BORDER && !obj_decimation_edge_is_border(decimation, vertex, neighbour))
+                                continue;
+
+                            /* error of the sum of the quadrics at the position of the neighbour */
+                            cost = obj_quadric_error(&decimation->quadrics[vertex], decimation->positions + neighbour * 3)
+                                   + obj_quadric_error(&decimation->quadrics[neighbour], decimation->positions + neighbour * 3);
+                            if (cost < decimation->costs[vertex] && (!check_flips || obj_decimation_collapse_is_valid(decimation, vertex, neighbour)))
+                                {
+                                    decimation->costs[vertex] = cost;
+                                    decimation->targets[vertex] = neighbour;
+                                }
+                        }
+                }
+            member = decimation->next_merged[member];
+        }
+    while (member != vertex);
+}
+
+/* move a vertex of the collapse heap to its place after its cost changed */
+void obj_decimation_heap_fix(obj_decimation_t *decimation, int vertex)
+{
+    int *heap = decimation->heap;
+    double *heap_costs = decimation->heap_costs;
+    double cost = decimation->costs[vertex];
+    int position = decimation->heap_positions[vertex];
+
+    /* up */
+    while (position > 0 && heap_costs[(position - 1) / 2] > cost)
+        {
+            heap[position] = heap[(position - 1) / 2];
+            heap_costs[position] = heap_costs[(position - 1) / 2];
+            decimation->heap_positions[heap[position]] = position;
+            position = (position - 1) / 2;
+        }
+
+    heap[position] = vertex;
+    heap_costs[position] = cost;
+    decimation->heap_positions[vertex] = position;
+
+    obj_decimation_heap_sift_down(decimation, position);
+}
+
+/* move the vertex at a place of the collapse heap down until its children cost more (the subtrees below it must be heaps) */
+void obj_decimation_heap_sift_down(obj_decimation_t *decimation, int position)
+{
+    int *heap = decimation->heap;
+    double *heap_costs = decimation->heap_costs;
+    int vertex = heap[position];
+    double cost = heap_costs[position];
+    int child = 0;
+
+    for (;;)
+        {
+            child = position * 2 + 1;
+            if (child >= decimation->vertices_count)
+                break;
+            if (child + 1 < decimation->vertices_count && heap_costs[child + 1] < heap_costs[child])
+                child++;
+            if (heap_costs[child] >= cost)
+                break;
+            heap[position] = heap[child];
+            heap_costs[position] = heap_costs[child];
+            decimation->heap_positions[heap[position]] = position;
+            position = child;
+        }
+
+    heap[position] = vertex;
+    heap_costs[position] = cost;
+    decimation->heap_positions[vertex] = position;
+}
+
+/* free the buffers of a decimation */
+void obj_decimation_free(obj_decimation_t *decimation)
+{
+    free(decimation->positions);
+    free(decimation->corners);
+    free(decimation->quadrics);
+    free(decimation->kinds);
+    free(decimation->representatives);
+    free(decimation->next_merged);
+    free(decimation->triangle_offsets);
+    free(decimation->vertex_triangles);
+    free(decimation->live_triangles);
+    free(decimation->triangle_alive);
+    free(decimation->heap);
+    free(decimation->heap_positions);
+    free(decimation->heap_costs);
+    free(decimation->costs);
+    free(decimation->targets);
+    free(decimation->stamps);
+    memset(decimation, 0, sizeof(obj_decimation_t));
+}
+
+/* prepare the decimation of a triangulated obj mesh using only existing vertices : quadrics, vertex kinds and collapse heap (returns 0 on error) */
+int obj_decimation_init(obj_decimation_t *decimation, const obj_mesh_t *obj_mesh)
+{
+    double normal[3];
+    double edge[3];
+    double perpendicular[3];
+    const double *positions[3];
+    double length = 0.0;
+    int vertices_count = obj_mesh->vertices_used;
+    int triangles_count = obj_mesh->faces_used;
+    int allocated_count = (vertices_count > 0) ? vertices_count : 1;
+    int vertex = 0;
+    int triangle = 0;
+    int corner = 0;
+    int corner_vertex = 0;
+    int next_vertex = 0;
+    int border_edges = 0;
+    int member = 0;
+    int triangle_index = 0;
+    int axis = 0;
+
+    memset(decimation, 0, sizeof(obj_decimation_t));
+    decimation->obj_mesh = obj_mesh;
+    decimation->vertices_count = vertices_count;
+    decimation->triangles_count = triangles_count;
+    decimation->positions = (double *) malloc(sizeof(double) * 3 * allocated_count);
+    decimation->corners = (int *) malloc(sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    decimation->quadrics = (obj_quadric_t *) calloc(allocated_count, sizeof(obj_quadric_t));
+    decimation->kinds = (int *) calloc(allocated_count, sizeof(int));
+    decimation->representatives = (int *) malloc(sizeof(int) * allocated_count);
+    decimation->next_merged = (int *) malloc(sizeof(int) * allocated_count);
+    decimation->triangle_offsets = (int *) calloc(vertices_count + 1, sizeof(int));
+    decimation->vertex_triangles = (int *) malloc(sizeof(int) * (triangles_count > 0 ? triangles_count * 3 : 1));
+    decimation->live_triangles = (int *) calloc(allocated_count, sizeof(int));
+    decimation->triangle_alive = (char *) malloc(triangles_count > 0 ? triangles_count : 1);
+    decimation->heap = (int *) malloc(sizeof(int) * allocated_count);
+    decimation->heap_positions = (int *) malloc(sizeof(int) * allocated_count);
+    decimation->heap_costs = (double *) malloc(sizeof(double) * allocated_count);
+    decimation->costs = (double *) malloc(sizeof(double) * allocated_count);
+    decimation->targets = (int *) malloc(sizeof(int) * allocated_count);
+    decimation->stamps = (int *) calloc(allocated_count, sizeof(int));
+    if (decimation->positions == NULL || decimation->corners == NULL || decimation->quadrics == NULL || decimation->kinds == NULL || decimation->representatives == NULL
+            || decimation->next_merged == NULL || decimation->triangle_offsets == NULL || decimation->vertex_triangles == NULL
+            || decimation->live_triangles == NULL || decimation->triangle_alive == NULL || decimation->heap == NULL
+            || decimation->heap_positions == NULL || decimation->heap_costs == NULL || decimation->costs == NULL || decimation->targets == NULL || decimation->stamps == NULL)
+        {
+            report_error("Error : can't allocate buffers in function obj_decimation_init !\n");
+            obj_decimation_free(decimation);
+            return 0;
+        }
+
+    for (vertex = 0; vertex < vertices_count; vertex++)
+        {
+            decimation->positions[vertex * 3] = obj_mesh->vertices[vertex].x;
+            decimation->positions[vertex * 3 + 1] = obj_mesh->vertices[vertex].y;
+            decimation->positions[vertex * 3 + 2] = obj_mesh->vertices[vertex].z;
+            decimation->representatives[vertex] = vertex;
+            decimation->next_merged[vertex] = vertex;
+        }
+
+    /* triangles using each vertex (degenerate triangles are dropped) */
+    for (triangle = 0; triangle < triangles_count; triangle++)
+        {
+            for (corner = 0; corner < 3; corner++)
+                decimation->corners[triangle * 3 + corner] = obj_mesh->corner_vertices[triangle * 3 + corner] - 1;
+            decimation->triangle_alive[triangle] = obj_mesh->corner_vertices[triangle * 3] != obj_mesh->corner_vertices[triangle * 3 + 1]
+                                                   && obj_mesh->corner_vertices[triangle * 3] != obj_mesh->corner_vertices[triangle * 3 + 2]
+                                                   && obj_mesh->corner_vertices[triangle * 3 + 1] != obj_mesh->corner_vertices[triangle * 3 + 2];
+            if (!decimation->triangle_alive[triangle])
+                continue;
+            decimation->live_triangles_count++;
+            for (corner = 0; corner < 3; corner++)
+                decimation->live_triangles[obj_mesh->corner_vertices[triangle * 3 + corner] - 1]++;
+        }
+    for (vertex = 0; vertex < vertices_count; vertex++)
+        {
+            decimation->triangle_offsets[vertex + 1] = decimation->triangle_offsets[vertex] + decimation->live_triangles[vertex];
+            if (decimation->live_triangles[vertex] > 0)
+                decimation->live_vertices_count++;
+        }
+    for (triangle = 0; triangle < triangles_count; triangle++)
+        {
+            if (!decimation->triangle_alive[triangle])
+                continue;
+            for (corner = 0; corner < 3; corner++)
+                {
+                    corner_vertex = obj_mesh->corner_vertices[triangle * 3 + corner] - 1;
+                    decimation->vertex_triangles[decimation->triangle_offsets[corner_vertex] + decimation->stamps[corner_vertex]] = triangle;
+                    decimation->stamps[corner_vertex]++;
+                }
+        }
+    memset(decimation->stamps, 0, sizeof(int) * allocated_count);
+    decimation->compacted_triangles_count = decimation->live_triangles_count;
+
+    /* planes of the triangles weighted by their area, plus planes across the borders to keep them in place */
+    for (triangle = 0; triangle < triangles_count; triangle++)
+        {
+            if (!decimation->triangle_alive[triangle])
+                continue;
+
+            for (corner = 0; corner < 3; corner++)
+                positions[corner] = decimation->positions + (obj_mesh->corner_vertices[triangle * 3 + corner] - 1) * 3;
+            normal[0] = (positions[1][1] - positions[0][1]) * (positions[2][2] - positions[0][2]) - (positions[1][2] - positions[0][2]) * (positions[2][1] - positions[0][1]);
+            normal[1] = (positions[1][2] - positions[0][2]) * (positions[2][0] - positions[0][0]) - (positions[1][0] - positions[0][0]) * (positions[2][2] - positions[0][2]);
+            normal[2] = (positions[1][0] - positions[0][0]) * (positions[2][1] - positions[0][1]) - (positions[1][1] - positions[0][1]) * (positions[2][0] - positions[0][0]);
+            length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length == 0.0)
+                continue;
+            for (axis = 0; axis < 3; axis++)
+                normal[axis] /= length;
+
+            for (corner = 0; corner < 3; corner++)
+                obj_quadric_add_plane(&decimation->quadrics[obj_mesh->corner_vertices[triangle * 3 + corner] - 1], normal[0], normal[1], normal[2],
+                                      -(normal[0] * positions[0][0] + normal[1] * positions[0][1] + normal[2] * positions[0][2]), length * 0.5);
+
+            for (corner = 0; corner < 3; corner++)
+                {
+                    vertex = obj_mesh->corner_vertices[triangle * 3 + corner] - 1;
+                    next_vertex = obj_mesh->corner_vertices[triangle * 3 + (corner + 1) % 3] - 1;
+                    if (!obj_decimation_edge_is_border(decimation, vertex, next_vertex))
+                        continue;
+
+                    for (axis = 0; axis < 3; axis++)
+                        edge[axis] = decimation->positions[next_vertex * 3 + axis] - decimation->positions[vertex * 3 + axis];
+                    perpendicular[0] = edge[1] * normal[2] - edge[2] * normal[1];
+                    perpendicular[1] = edge[2] * normal[0] - edge[0] * normal[2];
+                    perpendicular[2] = edge[0] * normal[1] - edge[1] * normal[0];
+                    length = sqrt(perpendicular[0] * perpendicular[0] + perpendicular[1] * perpendicular[1] + perpendicular[2] * perpendicular[2]);
+                    if (length == 0.0)
+                        continue;
+                    for (axis = 0; axis < 3; axis++)
+                        perpendicular[axis] /= length;
+
+                    /* the edge length is the length of the perpendicular (the normal is a unit vector) */
+                    obj_quadric_add_plane(&decimation->quadrics[vertex], perpendicular[0], perpendicular[1], perpendicular[2],
+                                          -(perpendicular[0] * decimation->positions[vertex * 3] + perpendicular[1] * decimation->positions[vertex * 3 + 1] + perpendicular[2] * decimation->positions[vertex * 3 + 2]),
+                                          OBJ_DECIMATION_BORDER_WEIGHT * length * length);
+                    obj_quadric_add_plane(&decimation->quadrics[next_vertex], perpendicular[0], perpendicular[1], perpendicular[2],
+                                          -(perpendicular[0] * decimation->positions[vertex * 3] + perpendicular[1] * decimation->positions[vertex * 3 + 1] + perpendicular[2] * decimation->positions[vertex * 3 + 2]),
+                                          OBJ_DECIMATION_BORDER_WEIGHT * length * length);
+                }
+        }
+
+    /* vertices inside a surface of one material move freely, vertices on a simple border slide along it, the others stay */
+    for (vertex = 0; vertex < vertices_count; vertex++)
+        {
+            decimation->stamp++;
+            border_edges = 0;
+            for (triangle_index = decimation->triangle_offsets[vertex]; triangle_index < decimation->triangle_offsets[vertex + 1]; triangle_index++)
+                {
+                    triangle = decimation->vertex_triangles[triangle_index];
+                    for (corner = 0; corner < 3; corner++)
+                        {
+                            member = obj_mesh->corner_vertices[triangle * 3 + corner] - 1;
+                            if (member == vertex || decimation->stamps[member] == decimation->stamp)
+                                continue;
+                            decimation->stamps[member] = decimation->stamp;
+                            if (obj_decimation_edge_is_border(decimation, vertex, member))
+                                border_edges++;
+                        }
+                }
+            if (border_edges == 0)
+                decimation->kinds[vertex] = OBJ_DECIMATION_INTERIOR;
+            else if (border_edges == 2)
+                decimation->kinds[vertex] = OBJ_DECIMATION_BORDER;
+            else
+                decimation->kinds[vertex] = OBJ_DECIMATION_LOCKED;
+        }
+
+    /* cheapest collapses first */
+    for (vertex = 0; vertex < vertices_count; vertex++)
+        {
+            obj_decimation_best_collapse(decimation, vertex, 0);
+            decimation->heap[vertex] = vertex;
+            decimation->heap_costs[vertex] = decimation->costs[vertex];
+            decimation->heap_positions[vertex] = vertex;
+        }
+    /* bottom-up build : each place only moves down, into subtrees that are already heaps */
+    for (vertex = vertices_count / 2 - 1; vertex >= 0; vertex--)
+        obj_decimation_heap_sift_down(decimation, vertex);
+
+    return 1;
+}
+
+/* rebuild the lists of triangles around the vertices with the triangles left only (the dropped ones slow the walks down as they pile up) */
+void obj_decimation_compact(obj_decimation_t *decimation)
+{
+    int triangle = 0;
+    int corner = 0;
+    int corner_vertex = 0;
+    int vertex = 0;
+
+    memset(decimation->triangle_offsets, 0, sizeof(int) * (decimation->vertices_count + 1));
+    for (triangle = 0; triangle < decimation->triangles_count; triangle++)
+        {
+            if (!decimation->triangle_alive[triangle])
+                continue;
+            for (corner = 0; corner < 3; corner++)
+                {
+                    corner_vertex = OBJ_DECIMATION_CORNER(decimation, triangle, corner);
+                    decimation->corners[triangle * 3 + corner] = corner_vertex;
+                    decimation->triangle_offsets[corner_vertex + 1]++;
+                }
+        }
+    for (vertex = 0; vertex < decimation->vertices_count; vertex++)
+        {
+            decimation->triangle_offsets[vertex + 1] += decimation->triangle_offsets[vertex];
+            decimation->next_merged[vertex] = vertex;
+            decimation->stamps[vertex] = 0;
+        }
+    for (triangle = 0; triangle < decimation->triangles_count; triangle++)
+        {
+            if (!decimation->triangle_alive[triangle])
+                continue;
+            for (corner = 0; corner < 3; corner++)
+                {
+                    corner_vertex = decimation->corners[triangle * 3 + corner];
+                    decimation->vertex_triangles[decimation->triangle_offsets[corner_vertex] + decimation->stamps[corner_vertex]] = triangle;
+                    decimation->stamps[corner_vertex]++;
+                }
+        }
+    memset(decimation->stamps, 0, sizeof(int) * decimation->vertices_count);
+    decimation->stamp = 0;
+    decimation->compacted_triangles_count = decimation->live_triangles_count;
+}
+
+/* collapse an alive vertex into one of its neighbours, then update the costs of the vertices around */
+void obj_decimation_collapse(obj_decimation_t *decimation, int vertex, int target)
+{
+    int member = vertex;
+    int triangle_index = 0;
+    int triangle = 0;
+    int corner = 0;
+    int corner_vertex = 0;
+    int swap = 0;
+
+    decimation->stamp++;
+
+    /* triangles using both vertices disappear */
+    do
+        {
+            for (triangle_index = decimation->triangle_offsets[member]; triangle_index < decimation->triangle_offsets[member + 1]; triangle_index++)
+                {
+                    triangle = decimation->vertex_triangles[triangle_index];
+                    if (!decimation->triangle_alive[triangle])
+                        continue;
+                    if (OBJ_DECIMATION_CORNER(decimation, triangle, 0) != target
+                            && OBJ_DECIMATION_CORNER(decimation, triangle, 1) != target
+                            && OBJ_DECIMATION_CORNER(decimation, triangle, 2) != target)
+                        continue;
+
+                    decimation->triangle_alive[triangle] = 0;
+                    decimation->live_triangles_count--;
+                    for (corner = 0; corner < 3; corner++)
+                        {
+                            corner_vertex = OBJ_DECIMATION_CORNER(decimation, triangle, corner);
+                            decimation->live_triangles[corner_vertex]--;
+                            if (corner_vertex != vertex && corner_vertex != target)
+                                {
+                                    if (decimation->live_triangles[corner_vertex] == 0)
+                                        decimation->live_vertices_count--;
+                                    /* the third vertex lost a triangle, its best collapse may change */
+                                    decimation->stamps[corner_vertex] = decimation->stamp;
+                                }
+                        }
+                }
+            member = decimation->next_merged[member];
+        }
+    while (member != vertex);
+
+    /* the remaining triangles of the vertex now use the target */
+    do
+        {
+            decimation->representatives[member] = target;
+            member = decimation->next_merged[member];
+        }
+    while (member != vertex);
+    swap = decimation->next_merged[vertex];
+    decimation->next_merged[vertex] = decimation->next_merged[target];
+    decimation->next_merged[target] = swap;
+
+    obj_quadric_add(&decimation->quadrics[target], &decimation->quadrics[vertex]);
+    decimation->live_triangles[target] += decimation->live_triangles[vertex];
+    decimation->live_triangles[vertex] = 0;
+    decimation->live_vertices_count--;
+    if (decimation->live_triangles[target] == 0)
+        decimation->live_vertices_count--;
+
+    decimation->costs[vertex] = DBL_MAX;
+    decimation->targets[vertex] = -1;
+    obj_decimation_heap_fix(decimation, vertex);
+
+    /* the target and its neighbours */
+    decimation->stamps[target] = decimation->stamp;
+    member = target;
+    do
+        {
+            for (triangle_index = decimation->triangle_offsets[member]; triangle_index < decimation->triangle_offsets[member + 1]; triangle_index++)
+                {
+                    triangle = decimation->vertex_triangles[triangle_index];
+                    if (!decimation->triangle_alive[triangle])
+                        continue;
+                    for (corner = 0; corner < 3; corner++)
+                        decimation->stamps[OBJ_DECIMATION_CORNER(decimation, triangle, corner)] = decimation->stamp;
+                }
+            member = decimation->next_merged[member];
+        }
+    while (member != target);
+
+    /* visit the stamped vertices through the triangles around the target and the third vertices of the dropped triangles */
+    member = target;
+    do
+        {
+            for (triangle_index = decimation->triangle_offsets[member]; triangle_index < decimation->triangle_offsets[member + 1]; triangle_index++)
+                {
+                    triangle = decimation->vertex_triangles[triangle_index];
+                    for (corner = 0; corner < 3; corner++)
+                        {
+                            corner_vertex = OBJ_DECIMATION_CORNER(decimation, triangle, corner);
+                            if (decimation->stamps[corner_vertex] != decimation->stamp)
+                                continue;
+                            decimation->stamps[corner_vertex] = 0;
+                            obj_decimation_best_collapse(decimation, corner_vertex, 0);
+                            obj_decimation_heap_fix(decimation, corner_vertex);
+                        }
+                }
+            member = decimation->next_merged[member];
+        }
+    while (member != target);
+}
+
+/* reduce a obj mesh to "faces_budget" triangles and "vertices_budget" vertices (0 for no limit) by quadric error edge collapses
+   (Garland and Heckbert 1997), keeping the borders between materials and of the mesh (faces are split in triangles first, returns 0 on error) */
+int obj_mesh_decimate(obj_mesh_t *obj_mesh, int faces_budget, int vertices_budget)
+{
+    obj_decimation_t decimation;
+    obj_vertex_t *vertices = NULL;
+    int *remap = NULL;
+    int vertex = 0;
+    int target = 0;
+    int triangle = 0;
+    int corner = 0;
+    int corner_index = 0;
+    int vertices_used = 0;
+    int faces_used = 0;
+    int result = 1;
+
+    if (obj_mesh == NULL)
+        {
+            report_error("Error : obj mesh is NULL in function obj_mesh_decimate !\n");
+            return 0;
+        }
+
+    /* faces using vertices that don't exist are written as they are, the mesh is left alone */
+    for (corner_index = 0; corner_index < obj_mesh->corners_used; corner_index++)
+        {
+            vertex = obj_mesh->corner_vertices[corner_index];
+            if (vertex < 1 || vertex > obj_mesh->vertices_used)
+                {
+                    report_warning("Warning : a face uses vertex %d which does not exist, decimation skipped !\n", vertex);
+                    return 1;
+                }
+        }
+
+    if (!obj_mesh_triangulate(obj_mesh))
+        return 0;
+    if (obj_mesh->faces_used <= faces_budget && (vertices_budget <= 0 || obj_mesh->vertices_used <= vertices_budget))
+        return 1;
+    if (!obj_decimation_init(&decimation, obj_mesh))
+        return 0;
+
+    /* the costs in the heap are kept up to date but the flips are only looked for in the collapse coming first,
+       when it flips a triangle the vertex is looked at again for a collapse flipping none */
+    while (decimation.live_triangles_count > faces_budget || (vertices_budget > 0 && decimation.live_vertices_count > vertices_budget))
+        {
+            vertex = decimation.heap[0];
+            target = decimation.targets[vertex];
+            if (target < 0)
+                break;
+            if (decimation.representatives[target] != target
+                    || (decimation.kinds[vertex] == OBJ_DECIMATION_BORDER && !obj_decimation_edge_is_border(&decimation, vertex, target))
+                    || !obj_decimation_collapse_is_valid(&decimation, vertex, target))
+                {
+                    obj_decimation_best_collapse(&decimation, vertex, 1);
+                    obj_decimation_heap_fix(&decimation, vertex);
+                    continue;
+                }
+            obj_decimation_collapse(&decimation, vertex, target);
+            if (decimation.live_triangles_count * 2 < decimation.compacted_triangles_count)
+                obj_decimation_compact(&decimation);
+        }
+
+    if (decimation.live_triangles_count > faces_budget || (vertices_budget > 0 && decimation.live_vertices_count > vertices_budget))
+        report_warning("Warning : the mesh can't be reduced below %d triangles and %d vertices without moving its borders !\n",
+                     decimation.live_triangles_count, decimation.live_vertices_count);
+
+    /* alive vertices used by a triangle, in their first order */
+    remap = (int *) malloc(sizeof(int) * (obj_mesh->vertices_used > 0 ? obj_mesh->vertices_used : 1));
+    vertices = (obj_vertex_t *) memory_alloc(obj_mesh->arena, sizeof(obj_vertex_t) * (decimation.live_vertices_count > 0 ? decimation.live_vertices_count : 1));
+    if (remap == NULL || vertices == NULL)
+        {
+            report_error("Error : can't allocate vertices in function obj_mesh_decimate !\n");
+            result = 0;
+        }
+    else
+        {
+            for (vertex = 0; vertex < obj_mesh->vertices_used; vertex++)
+                {
+                    remap[vertex] = -1;
+                    if (decimation.representatives[vertex] == vertex && decimation.live_triangles[vertex] > 0)
+                        {
+                            vertices[vertices_used] = obj_mesh->vertices[vertex];
+                            remap[vertex] = vertices_used++;
+                        }
+                }
+
+            /* triangles left, in place (texture and normal indexes of their corners are kept) */
+            for (triangle = 0; triangle < obj_mesh->faces_used; triangle++)
+                {
+                    if (!decimation.triangle_alive[triangle])
+                        continue;
+                    for (corner = 0; corner < 3; corner++)
+                        {
+                            obj_mesh->corner_vertices[faces_used * 3 + corner] = remap[OBJ_DECIMATION_CORNER(&decimation, triangle, corner)] + 1;
+                            if (obj_mesh->corner_textures != NULL)
+                                obj_mesh->corner_textures[faces_used * 3 + corner] = obj_mesh->corner_textures[triangle * 3 + corner];
+                            if (obj_mesh->corner_normals != NULL)
+                                obj_mesh->corner_normals[faces_used * 3 + corner] = obj_mesh->corner_normals[triangle * 3 + corner];
+                        }
+                    obj_mesh->face_materials[faces_used] = obj_mesh->face_materials[triangle];
+                    faces_used++;
+                    obj_mesh->face_offsets[faces_used] = faces_used * 3;
+                }
+
+            memory_free(obj_mesh->arena, obj_mesh->vertices);
+            obj_mesh->vertices = vertices;
+            obj_mesh->vertices_used = vertices_used;
+            obj_mesh->vertices_allocated = (vertices_used > 0) ? vertices_used : 1;
+            obj_mesh->faces_used = faces_used;
+            obj_mesh->corners_used = faces_used * 3;
+            vertices = NULL;
+        }
+
+    free(remap);
+    memory_free(obj_mesh->arena, vertices);
+    obj_decimation_free(&decimation);
+
+    return result;
+}
+
+/* encode an obj mesh as a solid file in a buffer (returns 0 on error) */
+int obj_mesh_serialize_solid(obj_mesh_t *obj_mesh, solid_buffer_t *buffer)
+{
+    obj_material_t *current_material = NULL;
+    unsigned char *record = NULL;
+    unsigned char color[12];
+    int vertex_index = 0;
+    int face_index = 0;
+    int first_corner = 0;
+    int corner_index = 0;
+    int corner_count = 0;
+    int triangles_count = 0;
+
+    if (obj_mesh == NULL)
+        {
+            report_error("Error : obj mesh is NULL in function obj_mesh_serialize_solid !\n");
+            return 0;
+        }
+
+    /* we recount the faces as some of them may be quads or polygons (a face of n corners counts for n - 2 tri faces) */
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            triangles_count += obj_face_corner_count(obj_mesh, face_index) - 2;
+        }
+
+    /* header, vertices (3 floats) and triangles (4 shorts and 3 floats) are allocated at once */
+    record = solid_buffer_append(buffer, 4 + (size_t) obj_mesh->vertices_used * 12 + (size_t) triangles_count * 20);
+    if (record == NULL)
+        {
+            report_error("Error : can't allocate solid buffer in function obj_mesh_serialize_solid !\n");
+            return 0;
+        }
+
+    solid_store_short(record, (short) obj_mesh->vertices_used);
+    solid_store_short(record + 2, (short) triangles_count);
+    record += 4;
+
+    for (vertex_index = 0; vertex_index < obj_mesh->vertices_used; vertex_index++)
+        {
+            solid_store_float(record, obj_mesh->vertices[vertex_index].x);
+            /* swap vectors (Z is the up vector in blender) */
+            solid_store_float(record + 4, obj_mesh->vertices[vertex_index].z);
+            solid_store_float(record + 8, -1 * obj_mesh->vertices[vertex_index].y);
+            record += 12;
+        }
+
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            /* get the matching material and encode its color once for all the triangles of the face */
+            if (obj_mesh->face_materials[face_index] >= 0)
+                {
+                    current_material = &obj_mesh->materials[obj_mesh->face_materials[face_index]];
+                    solid_store_float(color, current_material->diffuse_r);
+                    solid_store_float(color + 4, current_material->diffuse_g);
+                    solid_store_float(color + 8, current_material->diffuse_b);
+                }
+            else
+                {
+                    memset(color, 0, 12);
+                }
+
+            first_corner = obj_mesh->face_offsets[face_index];
+            corner_count = obj_face_corner_count(obj_mesh, face_index);
+
+            /* quads and polygons are divided in a fan of triangles around their first corner */
+            for (corner_index = 1; corner_index + 1 < corner_count; corner_index++)
+                {
+                    /* vertices indexes */
+                    solid_store_short(record, (short) (obj_mesh->corner_vertices[first_corner] - 1));
+                    solid_store_short(record + 2, (short) (obj_mesh->corner_vertices[first_corner + corner_index] - 1));
+                    solid_store_short(record + 4, (short) (obj_mesh->corner_vertices[first_corner + corner_index + 1] - 1));
+
+                    /* padding */
+                    solid_store_short(record + 6, 0);
+
+                    /* color */
+                    memcpy(record + 8, color, 12);
+                    record += 20;
+                }
+        }
+
+    return 1;
+}
+
+/* encode an obj mesh as a compact solid file in a buffer : 16 bits positions between the bounds of the mesh, 8 bits colors
+   in a palette of SOLID_V2_MAX_COLORS indexed by each triangle, little endian (returns 0 on error) */
+int obj_mesh_serialize_solid_v2(obj_mesh_t *obj_mesh, solid_buffer_t *buffer)
+{
+    unsigned char *record = NULL;
+    unsigned char *colors = NULL;
+    unsigned char palette[SOLID_V2_MAX_COLORS * SOLID_V2_COLOR_SIZE];
+    unsigned char color[SOLID_V2_COLOR_SIZE];
+    int *material_colors = NULL;
+    obj_material_t *material = NULL;
+    float position[3];
+    float min[3];
+    float max[3];
+    int vertex_index = 0;
+    int face_index = 0;
+    int first_corner = 0;
+    int corner_index = 0;
+    int corner_count = 0;
+    int triangles_count = 0;
+    int colors_count = 0;
+    int color_index = 0;
+    int axis = 0;
+
+    if (obj_mesh == NULL)
+        {
+            report_error("Error : obj mesh is NULL in function obj_mesh_serialize_solid_v2 !\n");
+            return 0;
+        }
+
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        triangles_count += obj_face_corner_count(obj_mesh, face_index) - 2;
+    if (obj_mesh->vertices_used > 32767 || triangles_count > 32767)
+        {
+            report_error("Error : compact solid files can't hold more than 32767 vertices or triangles in function obj_mesh_serialize_solid_v2 !\n");
+            return 0;
+        }
+
+    /* palette index of each material (the last entry for the faces without one), the materials no face uses take no room */
+    material_colors = (int *) malloc(sizeof(int) * (obj_mesh->materials_used + 1));
+    if (material_colors == NULL)
+        {
+            report_error("Error : can't allocate material colors in function obj_mesh_serialize_solid_v2 !\n");
+            return 0;
+        }
+    for (color_index = 0; color_index <= obj_mesh->materials_used; color_index++)
+        material_colors[color_index] = -1;
+
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            color_index = (obj_mesh->face_materials[face_index] >= 0) ? obj_mesh->face_materials[face_index] : obj_mesh->materials_used;
+            if (material_colors[color_index] >= 0)
+                continue;
+
+            memset(color, 0, sizeof(color));
+            if (color_index < obj_mesh->materials_used)
+                {
+                    material = &obj_mesh->materials[color_index];
+                    color[0] = solid_v2_quantize_color(material->diffuse_r);
+                    color[1] = solid_v2_quantize_color(material->diffuse_g);
+                    color[2] = solid_v2_quantize_color(material->diffuse_b);
+                }
+
+            /* materials of the same color once quantized share their entry */
+            for (material_colors[color_index] = 0; material_colors[color_index] < colors_count; material_colors[color_index]++)
+                {
+                    if (memcmp(palette + material_colors[color_index] * SOLID_V2_COLOR_SIZE, color, SOLID_V2_COLOR_SIZE) == 0)
+                        break;
+                }
+            if (material_colors[color_index] == colors_count)
+                {
+                    if (colors_count == SOLID_V2_MAX_COLORS)
+                        {
+                            report_error("Error : compact solid files can't hold more than %d colors in function obj_mesh_serialize_solid_v2 !\n", SOLID_V2_MAX_COLORS);
+                            free(material_colors);
+                            return 0;
+                        }
+                    memcpy(palette + colors_count * SOLID_V2_COLOR_SIZE, color, SOLID_V2_COLOR_SIZE);
+                    colors_count++;
+                }
+        }
+
+    /* bounds of the mesh, in the axes of the solid file (Z is the up vector in blender) */
+    for (axis = 0; axis < 3; axis++)
+        {
+            min[axis] = 0.0f;
+            max[axis] = 0.0f;
+        }
+    for (vertex_index = 0; vertex_index < obj_mesh->vertices_used; vertex_index++)
+        {
+            position[0] = obj_mesh->vertices[vertex_index].x;
+            position[1] = obj_mesh->vertices[vertex_index].z;
+            position[2] = -1 * obj_mesh->vertices[vertex_index].y;
+            for (axis = 0; axis < 3; axis++)
+                {
+                    if (vertex_index == 0 || position[axis] < min[axis])
+                        min[axis] = position[axis];
+                    if (vertex_index == 0 || position[axis] > max[axis])
+                        max[axis] = position[axis];
+                }
+        }
+
+    record = solid_buffer_append(buffer, SOLID_V2_HEADER_SIZE + (size_t) obj_mesh->vertices_used * SOLID_V2_VERTEX_SIZE
+                                 + (size_t) colors_count * SOLID_V2_COLOR_SIZE + (size_t) triangles_count * SOLID_V2_TRIANGLE_SIZE);
+    if (record == NULL)
+        {
+            report_error("Error : can't allocate solid buffer in function obj_mesh_serialize_solid_v2 !\n");
+            free(material_colors);
+            return 0;
+        }
+
+    memcpy(record, SOLID_V2_MAGIC, 4);
+    solid_store_ushort_le(record + 4, SOLID_V2_VERSION);
+    solid_store_ushort_le(record + 6, SOLID_V2_HEADER_SIZE);
+    solid_store_ushort_le(record + 8, (unsigned short) obj_mesh->vertices_used);
+    solid_store_ushort_le(record + 10, (unsigned short) triangles_count);
+    solid_store_ushort_le(record + 12, (unsigned short) colors_count);
+    solid_store_ushort_le(record + 14, 0);
+    for (axis = 0; axis < 3; axis++)
+        {
+            solid_store_float_le(record + 16 + axis * 4, min[axis]);
+            solid_store_float_le(record + 28 + axis * 4, max[axis]);
+        }
+    record += SOLID_V2_HEADER_SIZE;
+
+    for (vertex_index = 0; vertex_index < obj_mesh->vertices_used; vertex_index++)
+        {
+            solid_store_ushort_le(record, solid_v2_quantize(obj_mesh->vertices[vertex_index].x, min[0], max[0]));
+            solid_store_ushort_le(record + 2, solid_v2_quantize(obj_mesh->vertices[vertex_index].z, min[1], max[1]));
+            solid_store_ushort_le(record + 4, solid_v2_quantize(-1 * obj_mesh->vertices[vertex_index].y, min[2], max[2]));
+            record += SOLID_V2_VERTEX_SIZE;
+        }
+
+    colors = record;
+    memcpy(colors, palette, (size_t) colors_count * SOLID_V2_COLOR_SIZE);
+    record += (size_t) colors_count * SOLID_V2_COLOR_SIZE;
+
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            color_index = material_colors[(obj_mesh->face_materials[face_index] >= 0) ? obj_mesh->face_materials[face_index] : obj_mesh->materials_used];
+            first_corner = obj_mesh->face_offsets[face_index];
+            corner_count = obj_face_corner_count(obj_mesh, face_index);
+
+            /* quads and polygons are divided in a fan of triangles around their first corner */
+            for (corner_index = 1; corner_index + 1 < corner_count; corner_index++)
+                {
+                    solid_store_ushort_le(record, (unsigned short) (obj_mesh->corner_vertices[first_corner] - 1));
+                    solid_store_ushort_le(record + 2, (unsigned short) (obj_mesh->corner_vertices[first_corner + corner_index] - 1));
+                    solid_store_ushort_le(record + 4, (unsigned short) (obj_mesh->corner_vertices[first_corner + corner_index + 1] - 1));
+                    record[6] = (unsigned char) color_index;
+                    record += SOLID_V2_TRIANGLE_SIZE;
+                }
+        }
+
+    free(material_colors);
+    return 1;
+}
+
+/* number of triangles of the fans of the faces of a obj mesh (as written in solid files) using a vertex more than once */
+int obj_mesh_degenerate_triangles_count(const obj_mesh_t *obj_mesh)
+{
+    const int *corners = NULL;
+    int face_index = 0;
+    int corner_index = 0;
+    int corner_count = 0;
+    int count = 0;
+
+    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+        {
+            corners = obj_mesh->corner_vertices + obj_mesh->face_offsets[face_index];
+            corner_count = obj_face_corner_count(obj_mesh, face_index);
+            for (corner_index = 1; corner_index + 1 < corner_count; corner_index++)
+                {
+                    if (corners[0] == corners[corner_index] || corners[0] == corners[corner_index + 1] || corners[corner_index] == corners[corner_index + 1])
+                        count++;
+                }
+        }
+
+    return count;
+}
+
+/* encode an obj mesh as a solid file in the format of the options, warning about the Black Shades limits (options may be NULL, returns 0 on error) */
+int obj_mesh_format_solid(obj_mesh_t *obj_mesh, solid_buffer_t *buffer, const conversion_options_t *options)
+{
+    int degenerate_count = 0;
+    int previous_stage = STATS_STAGE_NONE;
+    int result = 0;
+
+    if (obj_mesh == NULL)
+        {
+            report_error("Error : obj mesh is NULL in function obj_mesh_format_solid !\n");
+            return 0;
+        }
+
+    /* Check sizes */
+    if (obj_mesh->vertices_used > (BLACK_SHADES_MAX_VERTICES) || obj_mesh->faces_used > (BLACK_SHADES_MAX_FACES))
+        {
+            report_warning("Warning : more than %d vertices or than %d faces may not be supported in the current state of Black Shades !\n", BLACK_SHADES_MAX_VERTICES, BLACK_SHADES_MAX_FACES);
+        }
+
+    /* faces using a vertex twice, as given in the obj file (welding drops those it would create) */
+    degenerate_count = obj_mesh_degenerate_triangles_count(obj_mesh);
+    if (degenerate_count > 0)
+        report_warning("Warning : %d triangles of '%s' use a vertex twice !\n", degenerate_count, obj_mesh->filename);
+
+    report_info("vertices = %d\n", obj_mesh->vertices_used);
+    report_info("faces = %d\n", obj_mesh->faces_used);
+
+    previous_stage = stats_enter_stage(STATS_STAGE_FORMAT);
+    if (options != NULL && options->solid_format == SOLID_FORMAT_V2)
+        result = obj_mesh_serialize_solid_v2(obj_mesh, buffer);
+    else
+        result = obj_mesh_serialize_solid(obj_mesh, buffer);
+    stats_enter_stage(previous_stage);
+
+    return result;
+}
+
+/* convert an obj mesh to a solid one in the format of the options (options may be NULL, returns 0 on error) */
+int obj_mesh_convert_to_solid(obj_mesh_t *obj_mesh, char *solid_file_path, const conversion_options_t *options)
+{
+    solid_buffer_t buffer;
+    int result = 0;
+
+    /* encode the whole file in memory then write it with a single call */
+    solid_buffer_init(&buffer);
+    result = obj_mesh_format_solid(obj_mesh, &buffer, options) && solid_buffer_write_file(&buffer, solid_file_path)
+             && (options == NULL || !options->compute_normals || solid_buffer_write_geometry_file(&buffer, solid_file_path, options));
+    solid_buffer_free(&buffer);
+
+    return result;
+}
+
+/* size of a section of a mesh cache file, padding included */
+size_t obj_mesh_cache_section_size(int count, size_t element_size)
+{
+    return ((size_t) count * element_size + OBJ_MESH_CACHE_ALIGNMENT - 1) & ~(size_t) (OBJ_MESH_CACHE_ALIGNMENT - 1);
+}
+
+/* size of everything following the header of a mesh cache file */
+size_t obj_mesh_cache_payload_size(const obj_mesh_cache_header_t *header)
+{
+    return obj_mesh_cache_section_size(header->vertices_count, sizeof(obj_vertex_t))
+           + obj_mesh_cache_section_size(header->faces_count + 1, sizeof(int))
+           + obj_mesh_cache_section_size(header->faces_count, sizeof(int))
+           + obj_mesh_cache_section_size(header->corners_count, sizeof(int)) * (1 + (header->has_textures ? 1 : 0) + (header->has_normals ? 1 : 0))
+           + obj_mesh_cache_section_size(header->materials_count, sizeof(obj_material_t));
+}
+
+/* append a section to a mesh cache file being written (returns 0 on error) */
+int obj_mesh_cache_append_section(solid_buffer_t *buffer, const void *data, int count, size_t element_size)
+{
+    size_t size = obj_mesh_cache_section_size(count, element_size);
+    unsigned char *section = NULL;
+
+    section = solid_buffer_append(buffer, size);
+    if (section == NULL)
+        return 0;
+
+    memset(section, 0, size);
+    if (count > 0)
+        memcpy(section, data, (size_t) count * element_size);
+    return 1;
+}
+
+/* write a parsed obj mesh as a mesh cache file (returns 0 on error) */
+int obj_mesh_serialize_cache(const obj_mesh_t *obj_mesh, uint64_t obj_hash, size_t obj_size, uint64_t mtl_hash, solid_buffer_t *buffer)
+{
+    obj_mesh_cache_header_t header;
+    size_t header_offset = buffer->used;
+    unsigned char *header_data = NULL;
+    int result = 1;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "S2OMESH", 8);
+    header.version = OBJ_MESH_CACHE_VERSION;
+    header.byte_order = 0x01020304;
+    header.obj_hash = obj_hash;
+    header.obj_size = obj_size;
+    header.mtl_hash = mtl_hash;
+    header.vertices_count = obj_mesh->vertices_used;
+    header.faces_count = obj_mesh->faces_used;
+    header.corners_count = obj_mesh->corners_used;
+    header.materials_count = obj_mesh->materials_used;
+    header.has_textures = (obj_mesh->corner_textures != NULL);
+    header.has_normals = (obj_mesh->corner_normals != NULL);
+    snprintf(header.material_filename, sizeof(header.material_filename), "%s", obj_mesh->material_filename);
+    header.payload_size = obj_mesh_cache_payload_size(&header);
+
+    /* the header is written again once the payload hash is known */
+    header_data = solid_buffer_append(buffer, sizeof(header));
+    if (header_data == NULL)
+        return 0;
+
+    result &= obj_mesh_cache_append_section(buffer, obj_mesh->vertices, obj_mesh->vertices_used, sizeof(obj_vertex_t));
+    result &= obj_mesh_cache_append_section(buffer, obj_mesh->face_offsets, obj_mesh->faces_used + 1, sizeof(int));
+    result &= obj_mesh_cache_append_section(buffer, obj_mesh->face_materials, obj_mesh->faces_used, sizeof(int));
+    result &= obj_mesh_cache_append_section(buffer, obj_mesh->corner_vertices, obj_mesh->corners_used, sizeof(int));
+    if (header.has_textures)
+        result &= obj_mesh_cache_append_section(buffer, obj_mesh->corner_textures, obj_mesh->corners_used, sizeof(int));
+    if (header.has_normals)
+        result &= obj_mesh_cache_append_section(buffer, obj_mesh->corner_normals, obj_mesh->corners_used, sizeof(int));
+    result &= obj_mesh_cache_append_section(buffer, obj_mesh->materials, obj_mesh->materials_used, sizeof(obj_material_t));
+    if (!result)
+        return 0;
+
+    header.payload_hash = hash_xxh64(buffer->data + header_offset + sizeof(header), header.payload_size, 0);
+    memcpy(buffer->data + header_offset, &header, sizeof(header));
+    return 1;
+}
+
+/* check the header of a mesh cache file against the obj file it should come from (returns 0 if the file is stale or damaged) */
+int obj_mesh_cache_check(const unsigned char *data, size_t size, uint64_t obj_hash, size_t obj_size, obj_mesh_cache_header_t *header)
+{
+    if (size < sizeof(obj_mesh_cache_header_t))
+        return 0;
+    memcpy(header, data, sizeof(obj_mesh_cache_header_t));
+
+    if (memcmp(header->magic, "S2OMESH", 8) != 0 || header->version != OBJ_MESH_CACHE_VERSION || header->byte_order != 0x01020304
+            || header->obj_hash != obj_hash || header->obj_size != obj_size
+            || header->vertices_count < 0 || header->faces_count < 0 || header->corners_count < 0 || header->materials_count < 0
+            || header->material_filename[sizeof(header->material_filename) - 1] != '\0')
+        return 0;
+
+    /* a file cut short or changed since it has been written */
+    if (header->payload_size != obj_mesh_cache_payload_size(header) || header->payload_size != size - sizeof(obj_mesh_cache_header_t)
+            || hash_xxh64(data + sizeof(obj_mesh_cache_header_t), header->payload_size, 0) != header->payload_hash)
+        return 0;
+
+    return 1;
+}
+
+/* copy a section of a mesh cache file and return the next one */
+const unsigned char * obj_mesh_cache_read_section(const unsigned char *section, void *data, int count, size_t element_size)
+{
+    if (count > 0)
+        memcpy(data, section, (size_t) count * element_size);
+    return section + obj_mesh_cache_section_size(count, element_size);
+}
+
+/* fill an empty obj mesh from a mesh cache file checked by obj_mesh_cache_check (returns 0 on error) */
+int obj_mesh_parse_cache(obj_mesh_t *obj_mesh, const unsigned char *data, const obj_mesh_cache_header_t *header)
+{
+    const unsigned char *section = data + sizeof(obj_mesh_cache_header_t);
+    int slots_count = 64;
+
+    if (!obj_mesh_reserve(obj_mesh, header->vertices_count, header->faces_count, header->materials_count)
+            || !obj_corners_reserve(obj_mesh, header->corners_count))
+        return 0;
+    if (header->has_textures && obj_mesh->corner_textures == NULL)
+        obj_mesh->corner_textures = obj_corner_indexes_create(obj_mesh);
+    if (header->has_normals && obj_mesh->corner_normals == NULL)
+        obj_mesh->corner_normals = obj_corner_indexes_create(obj_mesh);
+    if ((header->has_textures && obj_mesh->corner_textures == NULL) || (header->has_normals && obj_mesh->corner_normals == NULL))
+        return 0;
+
+    section = obj_mesh_cache_read_section(section, obj_mesh->vertices, header->vertices_count, sizeof(obj_vertex_t));
+    section = obj_mesh_cache_read_section(section, obj_mesh->face_offsets, header->faces_count + 1, sizeof(int));
+    section = obj_mesh_cache_read_section(section, obj_mesh->face_materials, header->faces_count, sizeof(int));
+    section = obj_mesh_cache_read_section(section, obj_mesh->corner_vertices, header->corners_count, sizeof(int));
+    if (header->has_textures)
+        section = obj_mesh_cache_read_section(section, obj_mesh->corner_textures, header->corners_count, sizeof(int));
+    if (header->has_normals)
+        section = obj_mesh_cache_read_section(section, obj_mesh->corner_normals, header->corners_count, sizeof(int));
+    obj_mesh_cache_read_section(section, obj_mesh->materials, header->materials_count, sizeof(obj_material_t));
+
+    obj_mesh->vertices_used = header->vertices_count;
+    obj_mesh->faces_used = header->faces_count;
+    obj_mesh->corners_used = header->corners_count;
+    obj_mesh->materials_used = header->materials_count;
+    strncpy(obj_mesh->material_filename, header->material_filename, 1023);
+    obj_mesh->material_filename[1023] = '\0';
+
+    /* same load factor as obj_get_or_add_material */
+    if (obj_mesh->materials_used == 0)
+        return 1;
+    while (obj_mesh->materials_used * 2 > slots_count)
+        slots_count *= 2;
+    return obj_material_slots_rebuild(obj_mesh, slots_count);
+}
+
+/* path of the mesh cache file of an obj file content (returns 0 if it is too long) */
+int obj_mesh_cache_path(char *path, size_t path_size, const char *directory, uint64_t obj_hash)
+{
+    return snprintf(path, path_size, "%s/%016llx.mesh", directory, (unsigned long long) obj_hash) < (int) path_size;
+}
+
+/* fill an empty obj mesh from the mesh cache if the obj file and its material file have not changed since they were stored
+   (material_file_path, 1024 bytes or NULL, receives the path of the material file checked and material_file_state, if not NULL, its state,
+   returns 0 if they must be parsed) */
+int obj_mesh_cache_load(obj_mesh_t *obj_mesh, const char *directory, const char *obj_file_path, uint64_t obj_hash, size_t obj_size, char *material_file_path,
+                        solid_file_state_t *material_file_state)
+{
+    obj_mesh_cache_header_t header;
+    mapped_file_t cache_mapped_file;
+    mapped_file_t material_mapped_file;
+    char path[1024];
+    int result = 0;
+
+    if (!obj_mesh_cache_path(path, sizeof(path), directory, obj_hash) || !mapped_file_open(&cache_mapped_file, path))
+        {
+            STATS_ADD(cache_misses, 1);
+            return 0;
+        }
+
+    if (!obj_mesh_cache_check((const unsigned char *) cache_mapped_file.data, cache_mapped_file.size, obj_hash, obj_size, &header))
+        {
+            /* damaged or from another version : removed (a worker storing a good one at the same time only costs a parse later) */
+            mapped_file_close(&cache_mapped_file);
+            remove(path);
+            STATS_ADD(cache_misses, 1);
+            return 0;
+        }
+
+    /* the material file is part of the key, it is looked for as the parser would */
+    result = 1;
+    if (header.material_filename[0] != '\0')
+        {
+            result = obj_material_file_open(&material_mapped_file, obj_file_path, header.material_filename, material_file_path);
+            if (result)
+                {
+                    result = (mapped_file_hash(&material_mapped_file) == header.mtl_hash);
+                    if (result)
+                        solid_file_state_set(material_file_state, &material_mapped_file, header.mtl_hash);
+                    mapped_file_close(&material_mapped_file);
+                }
+        }
+
+    result = result && obj_mesh_parse_cache(obj_mesh, (const unsigned char *) cache_mapped_file.data, &header);
+    mapped_file_close(&cache_mapped_file);
+
+    if (result)
+        {
+            report_info("mesh loaded from cache '%s'\n", path);
+#ifndef _WIN32
+            /* the least recently used files are trimmed first */
+            utime(path, NULL);
+#endif
+            STATS_ADD(cache_hits, 1);
+        }
+    else
+        {
+            STATS_ADD(cache_misses, 1);
+        }
+
+    return result;
+}
+
+/* store a parsed obj mesh in the mesh cache (written to a temporary file then renamed, so that other workers never see a partial file, returns 0 on error) */
+int obj_mesh_cache_store(const obj_mesh_t *obj_mesh, const char *directory, uint64_t obj_hash, size_t obj_size, uint64_t mtl_hash)
+{
+    static unsigned int temporary_counter = 0;
+    solid_buffer_t buffer;
+    char path[1024];
+    char temporary_path[1024];
+    long process_id = 0;
+    unsigned int counter = ATOMIC_ADD_32(&temporary_counter, 1);
+    int result = 0;
+
+#ifdef _WIN32
+    process_id = (long) _getpid();
+    _mkdir(directory);
+#else
+    process_id = (long) getpid();
+    mkdir(directory, 0777);
+#endif
+
+    if (!obj_mesh_cache_path(path, sizeof(path), directory, obj_hash)
+            || snprintf(temporary_path, sizeof(temporary_path), "%s.%ld.%u.tmp", path, process_id, counter) >= (int) sizeof(temporary_path))
+        {
+            report_error("Error : cache directory path too long in function obj_mesh_cache_store !\n");
+            return 0;
+        }
+
+    solid_buffer_init(&buffer);
+    result = obj_mesh_serialize_cache(obj_mesh, obj_hash, obj_size, mtl_hash, &buffer)
+             && solid_buffer_write_file(&buffer, temporary_path);
+    solid_buffer_free(&buffer);
+
+    if (result)
+        {
+#ifdef _WIN32
+            /* rename does not replace files here */
+            remove(path);
+#endif
+            result = (rename(temporary_path, path) == 0);
+        }
+    if (!result)
+        {
+            report_warning("Warning : can't store '%s' in the mesh cache !\n", obj_mesh->filename);
+            remove(temporary_path);
+        }
+
+    return result;
+}
+
+/* order mesh cache files from the least recently used */
+int obj_mesh_cache_entry_compare(const void *entry1, const void *entry2)
+{
+    time_t time1 = ((const obj_mesh_cache_entry_t *) entry1)->time;
+    time_t time2 = ((const obj_mesh_cache_entry_t *) entry2)->time;
+
+    return (time1 > time2) - (time1 < time2);
+}
+
+/* remove the least recently used files of a mesh cache directory until it holds at most "max_size" bytes, and the temporary
+   files left by crashed writers (returns the number of files removed, -1 on error) */
+int obj_mesh_cache_trim(const char *directory, uint64_t max_size)
+{
+#ifdef _MSC_VER
+    HANDLE find_handle = INVALID_HANDLE_VALUE;
+    WIN32_FIND_DATAA find_data;
+    int found = 0;
+#else
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+#endif
+    const char *name = NULL;
+    struct stat file_stat;
+    obj_mesh_cache_entry_t *entries = NULL;
+    int entries_used = 0;
+    int entries_allocated = 0;
+    int entry_index = 0;
+    size_t name_length = 0;
+    uint64_t total_size = 0;
+    time_t now = time(NULL);
+    char path[1024];
+    int removed_count = 0;
+    int result = 1;
+
+#ifdef _MSC_VER
+    if (snprintf(path, sizeof(path), "%s/*", directory) >= (int) sizeof(path))
+        return 0;
+    find_handle = FindFirstFileA(path, &find_data);
+    if (find_handle == INVALID_HANDLE_VALUE)
+        return 0;
+
+    for (found = 1; found && result; found = FindNextFileA(find_handle, &find_data))
+        {
+            name = find_data.cFileName;
+#else
+    dir = opendir(directory);
+    if (dir == NULL)
+        return 0;
+
+    while (result && (entry = readdir(dir)) != NULL)
+        {
+            name = entry->d_name;
+#endif
+            name_length = strlen(name);
+            if (snprintf(path, sizeof(path), "%s/%s", directory, name) >= (int) sizeof(path) || stat(path, &file_stat) != 0)
+                continue;
+
+            if (name_length > 4 && strcmp(name + name_length - 4, ".tmp") == 0)
+                {
+                    if (now - file_stat.st_mtime > OBJ_MESH_CACHE_TEMPORARY_AGE && remove(path) == 0)
+                        removed_count++;
+                }
+            else if (name_length > 5 && strcmp(name + name_length - 5, ".mesh") == 0)
+                {
+                    if (!obj_array_reserve(NULL, (void **) &entries, &entries_allocated, entries_used + 1, sizeof(obj_mesh_cache_entry_t)))
+                        {
+                            report_error("Error : can't realloc entries in function obj_mesh_cache_trim !\n");
+                            result = 0;
+                            continue;
+                        }
+                    strcpy(entries[entries_used].path, path);
+                    entries[entries_used].size = (uint64_t) file_stat.st_size;
+                    entries[entries_used].time = file_stat.st_mtime;
+                    total_size += entries[entries_used].size;
+                    entries_used++;
+                }
+        }
+#ifdef _MSC_VER
+    FindClose(find_handle);
+#else
+    closedir(dir);
+#endif
+
+    if (!result)
+        {
+            free(entries);
+            return -1;
+        }
+
+    /* workers reading a removed file still have it mapped, the next ones parse their obj file again */
+    if (entries_used > 0)
+        qsort(entries, entries_used, sizeof(obj_mesh_cache_entry_t), obj_mesh_cache_entry_compare);
+    for (entry_index = 0; entry_index < entries_used && total_size > max_size; entry_index++)
+        {
+            if (remove(entries[entry_index].path) == 0)
+                removed_count++;
+            total_size -= entries[entry_index].size;
+        }
+
+    free(entries);
+    return removed_count;
+}
+
+/* load an obj file (and its mtl file) and encode it as a solid file in a buffer (options may be NULL, returns 0 on error) */
+int convert_obj_file_to_solid_buffer(char *obj_file_path, solid_buffer_t *solid_buffer, const conversion_options_t *options)
+{
+    mapped_file_t obj_mapped_file;
+    mapped_file_t obj_material_mapped_file;
+    obj_mesh_t *obj_mesh = NULL;
+    const char *cache_directory = (options != NULL) ? options->cache_directory : NULL;
+    char *material_file_path = (options != NULL) ? options->material_file_path : NULL;
+    solid_file_state_t *material_file_state = (options != NULL) ? options->material_file_state : NULL;
+    uint64_t obj_hash = 0;
+    uint64_t mtl_hash = 0;
+    size_t obj_size = 0;
+    int material_file_opened = 0;
+    int cached = 0;
+    int welded_count = 0;
+    double acmr = 0.0;
+    int faces_count = 0;
+    int vertices_count = 0;
+    int previous_stage = STATS_STAGE_NONE;
+    int result = 0;
+
+    report_info("loading '%s'...\n", obj_file_path);
+    if (material_file_path != NULL)
+        material_file_path[0] = '\0';
+    if (material_file_state != NULL)
+        memset(material_file_state, 0, sizeof(solid_file_state_t));
+
+    /* create the obj mesh in memory */
+    obj_mesh = obj_mesh_create(obj_file_path);
+    if (obj_mesh == NULL)
+        return 0;
+
+    /* map obj file */
+    if (!mapped_file_open(&obj_mapped_file, obj_file_path))
+        {
+            report_error("can't load file '%s' !\n", obj_file_path);
+            obj_mesh_free(obj_mesh);
+            return 0;
+        }
+
+    /* an unchanged obj file (and mtl file) is not parsed again */
+    previous_stage = stats_enter_stage(STATS_STAGE_PARSE);
+    if (cache_directory != NULL)
+        {
+            obj_size = obj_mapped_file.size;
+            obj_hash = mapped_file_hash(&obj_mapped_file);
+            cached = obj_mesh_cache_load(obj_mesh, cache_directory, obj_file_path, obj_hash, obj_size, material_file_path, material_file_state);
+        }
+
+    /* parse obj file */
+    result = cached || obj_mesh_parse_parallel(obj_mesh, obj_mapped_file.data, obj_mapped_file.size, (options != NULL) ? options->threads_count : 1);
+    stats_enter_stage(previous_stage);
+
+    /* unmap obj file */
+    mapped_file_close(&obj_mapped_file);
+
+    /* has a MTL (material) file been declared in the obj file ? (mtllib directive ?) */
+    if (!cached && result && strlen(obj_mesh->material_filename) > 0)
+        {
+            material_file_opened = obj_material_file_open(&obj_material_mapped_file, obj_file_path, obj_mesh->material_filename, material_file_path);
+            if (!material_file_opened)
+                {
+                    report_error("Error : can't open material file '%s' for reading !\n", obj_mesh->material_filename);
+                }
+            else
+                {
+                    /* parse material file */
+                    previous_stage = stats_enter_stage(STATS_STAGE_PARSE);
+                    if (cache_directory != NULL || material_file_state != NULL)
+                        {
+                            /* the state of the content actually parsed (the file may change once it is closed) */
+                            mtl_hash = mapped_file_hash(&obj_material_mapped_file);
+                            solid_file_state_set(material_file_state, &obj_material_mapped_file, mtl_hash);
+                        }
+                    result = obj_mesh_parse_materials(obj_mesh, obj_material_mapped_file.data, obj_material_mapped_file.size);
+                    stats_enter_stage(previous_stage);
+                    mapped_file_close(&obj_material_mapped_file);
+                }
+        }
+
+    /* the mesh is cached before the options change it (a missing material file can't be checked later) */
+    if (!cached && result && cache_directory != NULL && (material_file_opened || strlen(obj_mesh->material_filename) == 0))
+        {
+            previous_stage = stats_enter_stage(STATS_STAGE_WRITE);
+            obj_mesh_cache_store(obj_mesh, cache_directory, obj_hash, obj_size, mtl_hash);
+            stats_enter_stage(previous_stage);
+        }
+
+    /* merge the vertices duplicated at texture or normal seams, solid files have no use for them */
+    previous_stage = stats_enter_stage(STATS_STAGE_OPTIMIZE);
+    if (result && options != NULL && options->weld_epsilon >= 0.0f)
+        {
+            welded_count = obj_mesh_weld_vertices(obj_mesh, options->weld_epsilon);
+            if (welded_count < 0)
+                result = 0;
+            else
+                report_info("welding saved %d vertices (%d left)\n", welded_count, obj_mesh->vertices_used);
+        }
+
+    /* fewer triangles for the game */
+    if (result && options != NULL && (options->decimation_faces > 0 || options->decimation_vertices > 0))
+        {
+            faces_count = obj_mesh->faces_used;
+            vertices_count = obj_mesh->vertices_used;
+            result = obj_mesh_decimate(obj_mesh, (options->decimation_faces > 0) ? options->decimation_faces : INT_MAX, options->decimation_vertices);
+            if (result)
+                report_info("decimation left %d triangles and %d vertices (%d faces and %d vertices before)\n", obj_mesh->faces_used, obj_mesh->vertices_used, faces_count, vertices_count);
+        }
+
+    /* draw order for the vertex cache of the graphics card */
+    if (result && options != NULL && options->optimize_vertex_cache)
+        {
+            acmr = obj_mesh_acmr(obj_mesh, OBJ_VERTEX_CACHE_SIZE);
+            result = obj_mesh_optimize_vertex_cache(obj_mesh, OBJ_VERTEX_CACHE_SIZE);
+            if (result)
+                report_info("vertex cache misses per triangle (ACMR, %d entries) : %.3f before, %.3f after\n", OBJ_VERTEX_CACHE_SIZE, acmr, obj_mesh_acmr(obj_mesh, OBJ_VERTEX_CACHE_SIZE));
+        }
+    stats_enter_stage(previous_stage);
+
+    /* create solid file */
+    if (result)
+        {
+            report_info("creating solid file...\n");
+            result = obj_mesh_format_solid(obj_mesh, solid_buffer, options);
+        }
+
+    /* free data */
+    obj_mesh_free(obj_mesh);
+
+    return result;
+}
+
+/* load an obj file (and its mtl file) and write it as a solid file (options may be NULL, returns 0 on error) */
+int convert_obj_file_to_solid(char *obj_file_path, char *solid_file_path, const conversion_options_t *options)
+{
+    solid_buffer_t buffer;
+    int result = 0;
+
+    /* the whole file is encoded in memory then written with a single call */
+    solid_buffer_init(&buffer);
+    result = convert_obj_file_to_solid_buffer(obj_file_path, &buffer, options) && solid_buffer_write_file(&buffer, solid_file_path)
+             && (options == NULL || !options->compute_normals || solid_buffer_write_geometry_file(&buffer, solid_file_path, options));
+    if (result)
+        report_info("...done !\n");
+    solid_buffer_free(&buffer);
+
+    return result;
+}
+
+/* load a solid file and write it as an obj file and its mtl file (options may be NULL, returns 0 on error) */
+int convert_solid_file_to_obj(char *solid_file_path, char *obj_file_path, char *obj_material_file_path, const conversion_options_t *options)
+{
+    solid_mesh_t *solid_mesh = NULL;
+    int result = 0;
+
+    report_info("loading '%s'...\n", solid_file_path);
+
+    /* bounded memory : the file is read again and again instead of being held (the normals of a vertex need all the triangles around it) */
+    if (options != NULL && options->stream_window_size > 0 && !options->compute_normals)
+        return solid_file_stream_to_obj(solid_file_path, obj_file_path, obj_material_file_path, options, options->stream_window_size);
+
+    /* read the whole file and decode it */
+    solid_mesh = solid_mesh_load(solid_file_path);
+    if (solid_mesh == NULL)
+        return 0;
+    report_info("%d vertices to read\n", solid_mesh->vertex_count);
+    report_info("%d triangles to read\n", solid_mesh->triangle_count);
+
+    /* create obj file */
+    report_info("creating obj file...\n");
+    result = solid_mesh_convert_to_obj(solid_mesh, obj_file_path, obj_material_file_path, options);
+    report_info("...done !\n");
+
+    /* free data */
+    solid_mesh_free(solid_mesh);
+
+    return result;
+}
+
+/* store an unsigned int (4 bytes, little endian as in packs) in memory */
+void solid_store_uint_le(unsigned char *buf, uint32_t value)
+{
+    buf[0] = (unsigned char) (value & 0xff);
+    buf[1] = (unsigned char) ((value >> 8) & 0xff);
+    buf[2] = (unsigned char) ((value >> 16) & 0xff);
+    buf[3] = (unsigned char) ((value >> 24) & 0xff);
+}
+
+/* load an unsigned int (4 bytes, little endian) from memory */
+uint32_t solid_load_uint_le(const unsigned char *buf)
+{
+    return (uint32_t) buf[0] | ((uint32_t) buf[1] << 8) | ((uint32_t) buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
+/* store an unsigned 64 bits integer (8 bytes, little endian) in memory */
+void solid_store_uint64_le(unsigned char *buf, uint64_t value)
+{
+    solid_store_uint_le(buf, (uint32_t) (value & 0xffffffffu));
+    solid_store_uint_le(buf + 4, (uint32_t) (value >> 32));
+}
+
+/* load an unsigned 64 bits integer (8 bytes, little endian) from memory */
+uint64_t solid_load_uint64_le(const unsigned char *buf)
+{
+    return (uint64_t) solid_load_uint_le(buf) | ((uint64_t) solid_load_uint_le(buf + 4) << 32);
+}
+
+/* append a length of a compressed block, 255 by 255 past the 15 of its token */
+unsigned char * solid_lz_store_length(unsigned char *output, size_t length)
+{
+    while (length >= 255)
+        {
+            *output++ = 255;
+            length -= 255;
+        }
+    *output++ = (unsigned char) length;
+    return output;
+}
+
+/* append a sequence of a compressed block : literals, then a match of "match_length" bytes "offset" bytes back (none if match_length is 0) */
+unsigned char * solid_lz_store_sequence(unsigned char *output, const unsigned char *literals, size_t literals_length, size_t offset, size_t match_length)
+{
+    unsigned char *token = output++;
+
+    *token = (unsigned char) (((literals_length < 15) ? literals_length : 15) << 4);
+    if (literals_length >= 15)
+        output = solid_lz_store_length(output, literals_length - 15);
+    memcpy(output, literals, literals_length);
+    output += literals_length;
+
+    if (match_length == 0)
+        return output;
+
+    output[0] = (unsigned char) (offset & 0xff);
+    output[1] = (unsigned char) (offset >> 8);
+    output += 2;
+    match_length -= SOLID_LZ_MIN_MATCH;
+    *token |= (unsigned char) ((match_length < 15) ? match_length : 15);
+    if (match_length >= 15)
+        output = solid_lz_store_length(output, match_length - 15);
+    return output;
+}
+
+/* compress "size" bytes at the end of a buffer (LZ4 block format : greedy matches found with a hash table of 4 bytes sequences, returns 0 on error) */
+int solid_lz_compress(const unsigned char *data, size_t size, solid_buffer_t *buffer)
+{
+    uint32_t *table = NULL;
+    unsigned char *output = NULL;
+    unsigned char *output_start = NULL;
+    uint32_t sequence = 0;
+    uint32_t slot = 0;
+    size_t position = 0;
+    size_t anchor = 0;
+    size_t match = 0;
+    size_t length = 0;
+    size_t matches_limit = 0;
+
+    /* worst case : everything as literals */
+    output_start = solid_buffer_reserve(buffer, size + size / 255 + 16);
+    table = (uint32_t *) calloc((size_t) 1 << SOLID_LZ_HASH_BITS, sizeof(uint32_t));
+    if (output_start == NULL || table == NULL)
+        {
+            report_error("Error : can't allocate compression buffers in function solid_lz_compress !\n");
+            free(table);
+            return 0;
+        }
+    output = output_start;
+
+    /* the format wants the last 5 bytes as literals and no match starting in the last 12 */
+    if (size > SOLID_LZ_END_LIMIT)
+        matches_limit = size - SOLID_LZ_END_LIMIT;
+    while (position < matches_limit)
+        {
+            memcpy(&sequence, data + position, 4);
+            slot = (sequence * 2654435761u) >> (32 - SOLID_LZ_HASH_BITS);
+            match = table[slot];
+            table[slot] = (uint32_t) position + 1;
+
+            /* table entries are positions + 1, 0 for none */
+            if (match == 0 || position - (match - 1) > SOLID_LZ_MAX_OFFSET || memcmp(data + match - 1, data + position, 4) != 0)
+                {
+                    position++;
+                    continue;
+                }
+            match--;
+
+            length = SOLID_LZ_MIN_MATCH;
+            while (position + length < size - SOLID_LZ_LAST_LITERALS && data[match + length] == data[position + length])
+                length++;
+
+            output = solid_lz_store_sequence(output, data + anchor, position - anchor, position - match, length);
+            position += length;
+            anchor = position;
+        }
+
+    output = solid_lz_store_sequence(output, data + anchor, size - anchor, 0, 0);
+    buffer->used += output - output_start;
+    free(table);
+    return 1;
+}
+
+/* read a length of a compressed block past the 15 of its token (returns 0 if the block ends first) */
+int solid_lz_load_length(const unsigned char *data, size_t size, size_t *position, size_t *length)
+{
+    unsigned char byte = 255;
+
+    while (byte == 255)
+        {
+            if (*position >= size)
+                return 0;
+            byte = data[(*position)++];
+            *length += byte;
+        }
+    return 1;
+}
+
+/* decompress a block made by solid_lz_compress into exactly "output_size" bytes (returns 0 if it is damaged) */
+int solid_lz_decompress(const unsigned char *data, size_t size, unsigned char *output, size_t output_size)
+{
+    size_t position = 0;
+    size_t written = 0;
+    size_t length = 0;
+    size_t offset = 0;
+    unsigned char token = 0;
+
+    while (position < size)
+        {
+            token = data[position++];
+
+            length = token >> 4;
+            if (length == 15 && !solid_lz_load_length(data, size, &position, &length))
+                return 0;
+            if (length > size - position || length > output_size - written)
+                return 0;
+            memcpy(output + written, data + position, length);
+            position += length;
+            written += length;
+
+            /* the last sequence has no match */
+            if (position == size)
+                break;
+
+            if (size - position < 2)
+                return 0;
+            offset = data[position] | (data[position + 1] << 8);
+            position += 2;
+            if (offset == 0 || offset > written)
+                return 0;
+
+            length = token & 15;
+            if (length == 15 && !solid_lz_load_length(data, size, &position, &length))
+                return 0;
+            length += SOLID_LZ_MIN_MATCH;
+            if (length > output_size - written)
+                return 0;
+
+            /* byte after byte, a match may overlap what it writes (runs) */
+            while (length-- > 0)
+                {
+                    output[written] = output[written - offset];
+                    written++;
+                }
+        }
+
+    return written == output_size;
+}
+
+/* init an empty pack to write */
+void solid_pack_writer_init(solid_pack_writer_t *writer)
+{
+    writer->entries_used = 0;
+    writer->entries_allocated = 0;
+    writer->entries = NULL;
+    solid_buffer_init(&writer->data);
+}
+
+/* free the entries of a pack being written */
+void solid_pack_writer_free(solid_pack_writer_t *writer)
+{
+    if (writer->entries != NULL)
+        free(writer->entries);
+    solid_buffer_free(&writer->data);
+    solid_pack_writer_init(writer);
+}
+
+/* compress a file into a pack being written (its name must be shorter than SOLID_PACK_MAX_NAME and unique, returns 0 on error) */
+int solid_pack_writer_add(solid_pack_writer_t *writer, const char *name, const unsigned char *data, size_t size)
+{
+    solid_pack_writer_entry_t *entry = NULL;
+    unsigned char *stored = NULL;
+    size_t name_length = strlen(name);
+    int previous_stage = STATS_STAGE_NONE;
+
+    if (name_length == 0 || name_length >= SOLID_PACK_MAX_NAME || size > 0xffffffffu)
+        {
+            report_error("Error : can't pack '%s' (name or file too long) in function solid_pack_writer_add !\n", name);
+            return 0;
+        }
+    if (!obj_array_reserve(NULL, (void **) &writer->entries, &writer->entries_allocated, writer->entries_used + 1, sizeof(solid_pack_writer_entry_t)))
+        {
+            report_error("Error : can't realloc entries in function solid_pack_writer_add !\n");
+            return 0;
+        }
+
+    entry = &writer->entries[writer->entries_used];
+    memcpy(entry->name, name, name_length + 1);
+    entry->size = size;
+    entry->hash = hash_xxh64(data, size, 0);
+    entry->data_offset = writer->data.used;
+
+    previous_stage = stats_enter_stage(STATS_STAGE_FORMAT);
+    if (!solid_lz_compress(data, size, &writer->data))
+        {
+            stats_enter_stage(previous_stage);
+            return 0;
+        }
+    stats_enter_stage(previous_stage);
+    entry->stored_size = writer->data.used - entry->data_offset;
+
+    /* files that don't compress are stored as they are (an entry whose stored size is its size is not compressed) */
+    if (entry->stored_size >= size)
+        {
+            writer->data.used = entry->data_offset;
+            entry->stored_size = size;
+            if (size > 0)
+                {
+                    stored = solid_buffer_append(&writer->data, size);
+                    if (stored == NULL)
+                        {
+                            report_error("Error : can't realloc data in function solid_pack_writer_add !\n");
+                            return 0;
+                        }
+                    memcpy(stored, data, size);
+                }
+        }
+
+    writer->entries_used++;
+    return 1;
+}
+
+/* compare two entries of a pack being written by name for qsort */
+int solid_pack_writer_entry_compare(const void *entry1, const void *entry2)
+{
+    return strcmp(((const solid_pack_writer_entry_t *) entry1)->name, ((const solid_pack_writer_entry_t *) entry2)->name);
+}
+
+/* write a pack : header, index sorted by name, names, then the data of the entries (returns 0 on error) */
+int solid_pack_writer_write(solid_pack_writer_t *writer, const char *path)
+{
+    solid_buffer_t buffers[2];
+    solid_pack_writer_entry_t *entry = NULL;
+    unsigned char *header = NULL;
+    unsigned char *record = NULL;
+    size_t names_size = 0;
+    size_t name_offset = 0;
+    size_t data_offset = 0;
+    int entry_index = 0;
+    int result = 0;
+
+    if (writer->entries_used > 0)
+        qsort(writer->entries, writer->entries_used, sizeof(solid_pack_writer_entry_t), solid_pack_writer_entry_compare);
+    for (entry_index = 0; entry_index < writer->entries_used; entry_index++)
+        {
+            if (entry_index > 0 && strcmp(writer->entries[entry_index - 1].name, writer->entries[entry_index].name) == 0)
+                {
+                    report_error("Error : '%s' is twice in the pack '%s' !\n", writer->entries[entry_index].name, path);
+                    return 0;
+                }
+            names_size += strlen(writer->entries[entry_index].name) + 1;
+        }
+
+    /* the data of the entries is written from the buffer it has been compressed in */
+    solid_buffer_init(&buffers[0]);
+    data_offset = SOLID_PACK_HEADER_SIZE + (size_t) writer->entries_used * SOLID_PACK_ENTRY_SIZE + names_size;
+    header = solid_buffer_append(&buffers[0], data_offset);
+    if (header == NULL)
+        {
+            report_error("Error : can't allocate pack index in function solid_pack_writer_write !\n");
+            return 0;
+        }
+
+    memcpy(header, SOLID_PACK_MAGIC, 8);
+    solid_store_uint_le(header + 8, SOLID_PACK_VERSION);
+    solid_store_uint_le(header + 12, (uint32_t) writer->entries_used);
+    solid_store_uint64_le(header + 16, names_size);
+    solid_store_uint64_le(header + 24, data_offset);
+
+    record = header + SOLID_PACK_HEADER_SIZE;
+    for (entry_index = 0; entry_index < writer->entries_used; entry_index++)
+        {
+            entry = &writer->entries[entry_index];
+            solid_store_uint_le(record, (uint32_t) name_offset);
+            solid_store_uint_le(record + 4, (uint32_t) strlen(entry->name));
+            solid_store_uint64_le(record + 8, data_offset + entry->data_offset);
+            solid_store_uint_le(record + 16, (uint32_t) entry->stored_size);
+            solid_store_uint_le(record + 20, (uint32_t) entry->size);
+            solid_store_uint64_le(record + 24, entry->hash);
+            memcpy(header + SOLID_PACK_HEADER_SIZE + (size_t) writer->entries_used * SOLID_PACK_ENTRY_SIZE + name_offset, entry->name, strlen(entry->name) + 1);
+            name_offset += strlen(entry->name) + 1;
+            record += SOLID_PACK_ENTRY_SIZE;
+        }
+
+    buffers[1] = writer->data;
+    result = solid_buffers_write_file(buffers, 2, path);
+    solid_buffer_free(&buffers[0]);
+
+    return result;
+}
+
+/* open a pack for reading : it is mapped in memory and its index is checked once for all (returns 0 on error) */
+int solid_pack_open(solid_pack_t *pack, const char *path)
+{
+    const unsigned char *data = NULL;
+    const unsigned char *record = NULL;
+    const char *previous_name = NULL;
+    const char *name = NULL;
+    uint64_t names_size = 0;
+    uint64_t data_offset = 0;
+    uint64_t entry_offset = 0;
+    size_t name_offset = 0;
+    size_t name_length = 0;
+    int entry_index = 0;
+
+    memset(pack, 0, sizeof(solid_pack_t));
+    if (!mapped_file_open(&pack->file, path))
+        {
+            report_error("can't load file '%s' !\n", path);
+            return 0;
+        }
+    data = (const unsigned char *) pack->file.data;
+
+    if (pack->file.size < SOLID_PACK_HEADER_SIZE || memcmp(data, SOLID_PACK_MAGIC, 8) != 0 || solid_load_uint_le(data + 8) != SOLID_PACK_VERSION)
+        {
+            report_error("Error : '%s' is not a pack of version %d !\n", path, SOLID_PACK_VERSION);
+            solid_pack_close(pack);
+            return 0;
+        }
+
+    pack->entries_count = (int) solid_load_uint_le(data + 12);
+    names_size = solid_load_uint64_le(data + 16);
+    data_offset = solid_load_uint64_le(data + 24);
+    if (pack->entries_count < 0 || (uint64_t) pack->entries_count > (pack->file.size - SOLID_PACK_HEADER_SIZE) / SOLID_PACK_ENTRY_SIZE
+            || names_size > pack->file.size || data_offset != SOLID_PACK_HEADER_SIZE + (uint64_t) pack->entries_count * SOLID_PACK_ENTRY_SIZE + names_size
+            || data_offset > pack->file.size)
+        {
+            report_error("Error : '%s' is truncated or corrupted !\n", path);
+            solid_pack_close(pack);
+            return 0;
+        }
+    pack->index = data + SOLID_PACK_HEADER_SIZE;
+    pack->names = (const char *) pack->index + (size_t) pack->entries_count * SOLID_PACK_ENTRY_SIZE;
+    pack->names_size = (size_t) names_size;
+
+    /* names inside the names and in order (for solid_pack_find), data inside the file */
+    for (entry_index = 0; entry_index < pack->entries_count; entry_index++)
+        {
+            record = pack->index + (size_t) entry_index * SOLID_PACK_ENTRY_SIZE;
+            name_offset = solid_load_uint_le(record);
+            name_length = solid_load_uint_le(record + 4);
+            entry_offset = solid_load_uint64_le(record + 8);
+            name = pack->names + name_offset;
+            if (name_offset >= pack->names_size || name_length >= pack->names_size - name_offset || name[name_length] != '\0' || strlen(name) != name_length
+                    || (previous_name != NULL && strcmp(previous_name, name) >= 0)
+                    || entry_offset < data_offset || entry_offset > pack->file.size || solid_load_uint_le(record + 16) > pack->file.size - entry_offset
+                    || solid_load_uint_le(record + 16) > solid_load_uint_le(record + 20))
+                {
+                    report_error("Error : '%s' is corrupted (entry %d) !\n", path, entry_index);
+                    solid_pack_close(pack);
+                    return 0;
+                }
+            previous_name = name;
+        }
+
+    return 1;
+}
+
+/* release a pack opened with solid_pack_open */
+void solid_pack_close(solid_pack_t *pack)
+{
+    mapped_file_close(&pack->file);
+    pack->entries_count = 0;
+    pack->index = NULL;
+    pack->names = NULL;
+    pack->names_size = 0;
+}
+
+/* name of an entry of a pack */
+const char * solid_pack_entry_name(const solid_pack_t *pack, int entry_index)
+{
+    return pack->names + solid_load_uint_le(pack->index + (size_t) entry_index * SOLID_PACK_ENTRY_SIZE);
+}
+
+/* index of the entry of a pack with this name (binary search in the index, returns -1 if there is none) */
+int solid_pack_find(const solid_pack_t *pack, const char *name)
+{
+    int first = 0;
+    int last = pack->entries_count - 1;
+    int middle = 0;
+    int order = 0;
+
+    while (first <= last)
+        {
+            middle = first + (last - first) / 2;
+            order = strcmp(name, solid_pack_entry_name(pack, middle));
+            if (order == 0)
+                return middle;
+            if (order < 0)
+                last = middle - 1;
+            else
+                first = middle + 1;
+        }
+
+    return -1;
+}
+
+/* decompress an entry of a pack at the end of a buffer, straight from the mapped file (returns 0 if it is damaged) */
+int solid_pack_extract(const solid_pack_t *pack, int entry_index, solid_buffer_t *buffer)
+{
+    const unsigned char *record = pack->index + (size_t) entry_index * SOLID_PACK_ENTRY_SIZE;
+    const unsigned char *stored = (const unsigned char *) pack->file.data + solid_load_uint64_le(record + 8);
+    size_t stored_size = solid_load_uint_le(record + 16);
+    size_t size = solid_load_uint_le(record + 20);
+    unsigned char *output = NULL;
+    int previous_stage = STATS_STAGE_NONE;
+    int result = 0;
+
+    output = solid_buffer_reserve(buffer, size);
+    if (output == NULL)
+        {
+            report_error("Error : can't allocate buffer in function solid_pack_extract !\n");
+            return 0;
+        }
+
+    previous_stage = stats_enter_stage(STATS_STAGE_READ);
+    if (stored_size == size)
+        {
+            memcpy(output, stored, size);
+            result = 1;
+        }
+    else
+        {
+            result = solid_lz_decompress(stored, stored_size, output, size);
+        }
+    result = result && hash_xxh64(output, size, 0) == solid_load_uint64_le(record + 24);
+    stats_enter_stage(previous_stage);
+
+    if (!result)
+        {
+            report_error("Error : entry '%s' of the pack is corrupted !\n", solid_pack_entry_name(pack, entry_index));
+            return 0;
+        }
+
+    buffer->used += size;
+    return 1;
+}
+
+/* decode the solid file of an entry of a pack (returns NULL on error) */
+solid_mesh_t * solid_pack_load_mesh(const solid_pack_t *pack, int entry_index)
+{
+    solid_buffer_t buffer;
+    solid_mesh_t *solid_mesh = NULL;
+    char name[SOLID_PACK_MAX_NAME];
+    int previous_stage = STATS_STAGE_NONE;
+
+    solid_buffer_init(&buffer);
+    if (!solid_pack_extract(pack, entry_index, &buffer))
+        {
+            solid_buffer_free(&buffer);
+            return NULL;
+        }
+
+    snprintf(name, sizeof(name), "%s", solid_pack_entry_name(pack, entry_index));
+    previous_stage = stats_enter_stage(STATS_STAGE_PARSE);
+    solid_mesh = solid_mesh_parse(name, buffer.data, buffer.used);
+    stats_enter_stage(previous_stage);
+
+    solid_buffer_free(&buffer);
+    return solid_mesh;
+}
+
+/* load the solid file of an entry of a pack and write it as an obj file and its mtl file (options may be NULL, returns 0 on error) */
+int convert_pack_entry_to_obj(const solid_pack_t *pack, int entry_index, char *obj_file_path, char *obj_material_file_path, const conversion_options_t *options)
+{
+    solid_mesh_t *solid_mesh = NULL;
+    int result = 0;
+
+    report_info("loading '%s' from the pack...\n", solid_pack_entry_name(pack, entry_index));
+
+    /* entries are small, they are always loaded whole */
+    solid_mesh = solid_pack_load_mesh(pack, entry_index);
+    if (solid_mesh == NULL)
+        return 0;
+    report_info("%d vertices to read\n", solid_mesh->vertex_count);
+    report_info("%d triangles to read\n", solid_mesh->triangle_count);
+
+    report_info("creating obj file...\n");
+    result = solid_mesh_convert_to_obj(solid_mesh, obj_file_path, obj_material_file_path, options);
+    report_info("...done !\n");
+
+    solid_mesh_free(solid_mesh);
+    return result;
+}
@@ -19,1032 +19,1329 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "solid2obj.h"
 
 #define PROGRAM_NAME "solid2obj"
 #define PROGRAM_VERSION "0.3.1a"
 #define PROGRAM_DESCRIPTION "Wolfire's Black Shades solid file converter from and to obj file"
 
-#define BLACK_SHADES_MAX_FACES 400
-#define BLACK_SHADES_MAX_VERTICES BLACK_SHADES_MAX_FACES*3
-
-/* solid file vertex 3d coordinates structure */
-typedef struct _solid_XYZ
-{
-    float x, y, z;
-} solid_XYZ_t;
-
-/* solid file textured triangle (colored triangle) structure */
-typedef struct _solid_textured_triangle
-{
-    short vertex[3];
-    float r, g, b;
-} solid_textured_triangle_t;
-
-/* solid file mesh structure */
-typedef struct _solid_mesh
-{
-    char filename[1024];
-    short vertex_count;
-    short triangle_count;
-    solid_XYZ_t *vertices;
-    solid_textured_triangle_t *triangles;
-} solid_mesh_t;
-
-/* solid file material structure */
-typedef struct _solid_material
-{
-    char name[1024];
-    int id;
-    float r, g, b;
-} solid_material_t;
-
-/* vertex in obj file */
-typedef struct _obj_vextex
-{
-    float x, y, z, w;
-} obj_vertex_t;
+/* how the statistics of the conversions are printed when the program ends (--stats) */
+#define STATS_OUTPUT_NONE 0
+#define STATS_OUTPUT_TABLE 1
+#define STATS_OUTPUT_JSON 2
 
-/* face in obj file */
-typedef struct _obj_face
+/* line of the build manifest : a converted file and what it has been converted from */
+typedef struct _build_record
 {
-    /* face can be a triangle or a quad */
-    int is_quad;
-    int vertex_index[4];
-    int texture_index[4];
-    int normal_index[4];
-    char texture_name[1024];
-} obj_face_t;
-
-/* material in obj file */
-typedef struct _obj_material
+    char output_path[1024];
+    char input_path[1024];
+    char material_path[1024]; /* material file declared by an obj input ("" if none, its name as declared if it is missing) */
+    char options[256]; /* PROGRAM_VERSION and the options changing the files written (see build_options_format) */
+    solid_file_state_t input;
+    solid_file_state_t material;
+} build_record_t;
+
+/* file read by a job of a batch (same device and inode for two paths of the same file, the path is compared where files have no inode) */
+typedef struct _batch_input
 {
-    char name[1024];
-    float ambient_r, ambient_g, ambient_b;
-    float diffuse_r, diffuse_g, diffuse_b;
-    float specular_r, specular_g, specular_b;
-    float specular_coefficient;
-} obj_material_t;
-
-/* obj file mesh structure */
-typedef struct _obj_mesh
+    long long device;
+    long long inode;
+    const char *path;
+    int job_index;
+} batch_input_t;
+
+/* conversion of a single file in batch mode */
+typedef struct _batch_job
 {
-    char filename[1024];
-    char material_filename[1024];
-    int vertices_used;
-    int vertices_allocated;
-    obj_vertex_t *vertices;
-    int faces_used;
-    int faces_allocated;
-    obj_face_t *faces;
-    int materials_used;
-    int materials_allocated;
-    obj_material_t *materials;
-} obj_mesh_t;
-
-/* basic generic list structure */
-typedef struct _list
+    char input_path[1024];
+    char output_path[1024];
+    char output_material_path[1024]; /* only used by solid->obj */
+    int to_solid;
+    int succeeded;
+    int up_to_date; /* skipped, the build manifest shows that its inputs have not changed */
+    build_record_t record; /* what the job has been converted from (build manifest only) */
+    int pack_index; /* pack holding the input solid file (in batch->packs), -1 if it is a file */
+    int entry_index; /* entry of the input solid file in its pack */
+    char pack_name[SOLID_PACK_MAX_NAME]; /* name of the solid file in the pack it is read from or written to */
+    solid_buffer_t packed; /* solid file to put in the pack being written (-P) */
+} batch_job_t;
+
+/* list of conversions run by a pool of threads */
+typedef struct _batch
 {
-    void *data;
-    struct _list *next;
-} list_t;
-
-/* create a new vertex in a obj mesh and return its handle */
-obj_vertex_t * obj_add_vertex(obj_mesh_t *obj_mesh)
+    int jobs_used;
+    int jobs_allocated;
+    batch_job_t *jobs;
+    int next_job; /* next job to take (protected by the mutex) */
+    int failed_count;
+    conversion_options_t options; /* same options for every job */
+    const char *build_manifest_path; /* NULL if every job is run */
+    char build_options[256];
+    int records_used;
+    build_record_t *records; /* build manifest of the previous run, sorted by output path (read only while the jobs run) */
+    const char *pack_path; /* pack the solid files are written to instead of files, NULL for files */
+    int packs_used;
+    int packs_allocated;
+    solid_pack_t *packs; /* packs given as inputs, mapped until the batch is freed */
+#ifndef _WIN32
+    pthread_mutex_t mutex;
+#endif
+} batch_t;
+
+/* read the conversion option at argv[argument_index] (returns the number of arguments it uses, 0 if it is not a conversion option, -1 if it is invalid) */
+int conversion_option_parse(int argc, char *argv[], int argument_index, conversion_options_t *options)
 {
-    obj_vertex_t *new_buffer = NULL;
-    obj_vertex_t *new_vertex = NULL;
-    int vertex_array_increment = 1; /* allocate X vertex at a time */
+    char *end = NULL;
+    long value = 0;
+    double epsilon = 0.0;
 
-    if (obj_mesh == NULL)
-        return NULL;
-
-    /* reserved memory is full or has not yet been created */
-    if (obj_mesh->vertices_used == obj_mesh->vertices_allocated)
+    if (strcmp(argv[argument_index], "-p") == 0)
         {
-            new_buffer = (obj_vertex_t *) realloc(obj_mesh->vertices, sizeof(obj_vertex_t) * (obj_mesh->vertices_allocated + vertex_array_increment));
-            if (new_buffer != NULL)
+            if (argument_index + 1 < argc)
+                value = strtol(argv[argument_index + 1], &end, 10);
+            if (end == NULL || end == argv[argument_index + 1] || *end != '\0' || value < 0 || value > TEXT_FLOAT_MAX_PRECISION)
                 {
-                    obj_mesh->vertices = new_buffer;
-                    obj_mesh->vertices_allocated += vertex_array_increment;
+                    printf("Error : -p needs a number of decimals between 0 and %d !\n", TEXT_FLOAT_MAX_PRECISION);
+                    return -1;
                 }
-            else
+            options->float_precision = (int) value;
+            return 2;
+        }
+    else if (strcmp(argv[argument_index], "-t") == 0)
+        {
+            if (argument_index + 1 < argc)
+                value = strtol(argv[argument_index + 1], &end, 10);
+            if (end == NULL || end == argv[argument_index + 1] || *end != '\0' || value < 1 || value > 1024)
                 {
-                    printf("Error : can't realloc vertices buffer in function obj_add_vertex !\n");
-                    return NULL;
+                    printf("Error : -t needs a number of threads between 1 and 1024 !\n");
+                    return -1;
                 }
+            options->threads_count = (int) value;
+            return 2;
         }
-
-    /* if there is still unused vertices */
-    if (obj_mesh->vertices_used < obj_mesh->vertices_allocated)
+    else if (strcmp(argv[argument_index], "-c") == 0)
         {
-            new_vertex = obj_mesh->vertices + obj_mesh->vertices_used;
-            obj_mesh->vertices_used++;
-            return new_vertex;
+            options->optimize_vertex_cache = 1;
+            return 1;
         }
-
-    return NULL;
-}
-
-/* create a new face in a obj mesh and return its handle */
-obj_face_t * obj_add_face(obj_mesh_t *obj_mesh)
-{
-    obj_face_t *new_buffer = NULL;
-    obj_face_t *new_face = NULL;
-    int face_array_increment = 1; /* allocate X face at a time */
-
-    if (obj_mesh == NULL)
-        return NULL;
-
-    /* reserved memory is full or has not yet been created */
-    if (obj_mesh->faces_used == obj_mesh->faces_allocated)
+    else if (strcmp(argv[argument_index], "-s") == 0)
         {
-            new_buffer = (obj_face_t *) realloc(obj_mesh->faces, sizeof(obj_face_t) * (obj_mesh->faces_allocated + face_array_increment));
-            if (new_buffer != NULL)
+            options->stream_window_size = SOLID_STREAM_WINDOW_SIZE;
+            return 1;
+        }
+    else if (strcmp(argv[argument_index], "-n") == 0)
+        {
+            options->compute_normals = 1;
+            return 1;
+        }
+    else if (strcmp(argv[argument_index], "-d") == 0)
+        {
+            options->decimation_faces = BLACK_SHADES_MAX_FACES;
+            options->decimation_vertices = BLACK_SHADES_MAX_VERTICES;
+            return 1;
+        }
+    else if (strcmp(argv[argument_index], "-D") == 0)
+        {
+            if (argument_index + 1 < argc)
+                value = strtol(argv[argument_index + 1], &end, 10);
+            if (end == NULL || end == argv[argument_index + 1] || *end != '\0' || value < 1 || value > INT_MAX)
                 {
-                    obj_mesh->faces = new_buffer;
-                    obj_mesh->faces_allocated += face_array_increment;
+                    printf("Error : -D needs a number of triangles greater than 0 !\n");
+                    return -1;
                 }
-            else
+            options->decimation_faces = (int) value;
+            options->decimation_vertices = 0;
+            return 2;
+        }
+    else if (strcmp(argv[argument_index], "-w") == 0)
+        {
+            if (argument_index + 1 < argc)
+                epsilon = strtod(argv[argument_index + 1], &end);
+            if (end == NULL || end == argv[argument_index + 1] || *end != '\0' || !(epsilon >= 0.0))
                 {
-                    printf("Error : can't realloc faces buffer in function obj_add_face !\n");
-                    return NULL;
+                    printf("Error : -w needs a distance greater than or equal to 0 !\n");
+                    return -1;
                 }
+            options->weld_epsilon = (float) epsilon;
+            return 2;
         }
-
-    /* if there is still unused faces */
-    if (obj_mesh->faces_used < obj_mesh->faces_allocated)
+    else if (strcmp(argv[argument_index], "-f") == 0)
         {
-            new_face = obj_mesh->faces + obj_mesh->faces_used;
-            obj_mesh->faces_used++;
-            return new_face;
+            if (argument_index + 1 < argc)
+                value = strtol(argv[argument_index + 1], &end, 10);
+            if (end == NULL || end == argv[argument_index + 1] || *end != '\0' || (value != SOLID_FORMAT_V1 && value != SOLID_FORMAT_V2))
+                {
+                    printf("Error : -f needs a solid format, %d (Black Shades) or %d (compact) !\n", SOLID_FORMAT_V1, SOLID_FORMAT_V2);
+                    return -1;
+                }
+            options->solid_format = (int) value;
+            return 2;
+        }
+    else if (strcmp(argv[argument_index], "-C") == 0)
+        {
+            if (argument_index + 1 >= argc || argv[argument_index + 1][0] == '\0')
+                {
+                    printf("Error : -C needs a cache directory !\n");
+                    return -1;
+                }
+            options->cache_directory = argv[argument_index + 1];
+            return 2;
         }
 
-    return NULL;
+    return 0;
 }
 
-/* create a new material in a obj mesh and return its handle */
-obj_material_t * obj_add_material(obj_mesh_t *obj_mesh)
+/* read the --stats option (returns 1 if the argument is one) */
+int stats_option_parse(const char *argument, int *stats_output)
 {
-    obj_material_t *new_buffer = NULL;
-    obj_material_t *new_material = NULL;
-    int material_array_increment = 1; /* allocate X material at a time */
+    if (strcmp(argument, "--stats") == 0)
+        *stats_output = STATS_OUTPUT_TABLE;
+    else if (strcmp(argument, "--stats=json") == 0)
+        *stats_output = STATS_OUTPUT_JSON;
+    else
+        return 0;
 
-    if (obj_mesh == NULL)
-        return NULL;
+    return 1;
+}
 
-    /* reserved memory is full or has not yet been created */
-    if (obj_mesh->materials_used == obj_mesh->materials_allocated)
-        {
-            new_buffer = (obj_material_t *) realloc(obj_mesh->materials, sizeof(obj_material_t) * (obj_mesh->materials_allocated + material_array_increment));
-            if (new_buffer != NULL)
-                {
-                    obj_mesh->materials = new_buffer;
-                    obj_mesh->materials_allocated += material_array_increment;
-                }
-            else
-                {
-                    printf("Error : can't realloc materials buffer in function obj_add_material !\n");
-                    return NULL;
-                }
-        }
+/* start measuring the conversions if statistics have been asked for */
+void stats_start(conversion_stats_t *stats, int stats_output)
+{
+    conversion_stats_init(stats);
+    if (stats_output != STATS_OUTPUT_NONE)
+        stats_set_capture(stats);
+}
 
-    /* if there is still unused materials */
-    if (obj_mesh->materials_used < obj_mesh->materials_allocated)
-        {
-            new_material = obj_mesh->materials + obj_mesh->materials_used;
-            obj_mesh->materials_used++;
-            return new_material;
-        }
+/* stop measuring the conversions and print their statistics on stderr (stdout keeps the messages of the conversions) */
+void stats_stop(conversion_stats_t *stats, int stats_output)
+{
+    solid_buffer_t buffer;
 
-    return NULL;
+    if (stats_output == STATS_OUTPUT_NONE)
+        return;
+
+    stats_set_capture(NULL);
+    solid_buffer_init(&buffer);
+    if (conversion_stats_format(stats, stats_output == STATS_OUTPUT_JSON, &buffer))
+        fwrite(buffer.data, 1, buffer.used, stderr);
+    solid_buffer_free(&buffer);
 }
 
-/* create a new obj mesh in memory */
-obj_mesh_t * obj_mesh_create(char *filename)
+/* true if the path ends with the given extension (case is ignored) */
+int path_has_extension(const char *path, const char *extension)
 {
-    obj_mesh_t *obj_mesh = NULL;
+    size_t path_length = strlen(path);
+    size_t extension_length = strlen(extension);
+    size_t index = 0;
 
-    obj_mesh = (obj_mesh_t *) malloc(sizeof(obj_mesh_t));
+    if (path_length <= extension_length)
+        return 0;
 
-    if (obj_mesh == NULL)
+    path += path_length - extension_length;
+    for (index = 0; index < extension_length; index++)
         {
-            printf("Error : can't allocate obj_mesh_t in function obj_mesh_create !\n");
-            return NULL;
+            if (path[index] != extension[index] && path[index] != extension[index] - 'a' + 'A')
+                return 0;
         }
 
-    /* init filename */
-    strncpy(obj_mesh->filename, filename, 1024);
-
-    /* init material filename (we need to parse the file to get the real name of the mat file) */
-    memset(obj_mesh->material_filename,'\0', 1024);
-
-    /* init vertices */
-    obj_mesh->vertices = NULL;
-    obj_mesh->vertices_used = 0;
-    obj_mesh->vertices_allocated = 0;
-
-    /* init faces */
-    obj_mesh->faces = NULL;
-    obj_mesh->faces_used = 0;
-    obj_mesh->faces_allocated = 0;
+    return 1;
+}
 
-    /* init materials */
-    obj_mesh->materials = NULL;
-    obj_mesh->materials_used = 0;
-    obj_mesh->materials_allocated = 0;
+/* true if something exists at the path */
+int path_exists(const char *path)
+{
+    struct stat path_stat;
 
-    return obj_mesh;
+    return (stat(path, &path_stat) == 0);
 }
 
-/* free a obj mesh from memory */
-void obj_mesh_free(obj_mesh_t *obj_mesh)
+/* true if the path is a directory */
+int path_is_directory(const char *path)
 {
-    if (obj_mesh == NULL)
-        return;
+    struct stat path_stat;
 
-    if (obj_mesh->vertices != NULL)
-        free(obj_mesh->vertices);
+    return (stat(path, &path_stat) == 0 && S_ISDIR(path_stat.st_mode));
+}
 
-    if (obj_mesh->faces != NULL)
-        free(obj_mesh->faces);
+/* create a batch without any job */
+void batch_init(batch_t *batch)
+{
+    batch->jobs = NULL;
+    batch->jobs_used = 0;
+    batch->jobs_allocated = 0;
+    batch->next_job = 0;
+    batch->failed_count = 0;
+    conversion_options_init(&batch->options);
+    batch->build_manifest_path = NULL;
+    batch->build_options[0] = '\0';
+    batch->records = NULL;
+    batch->records_used = 0;
+    batch->pack_path = NULL;
+    batch->packs = NULL;
+    batch->packs_used = 0;
+    batch->packs_allocated = 0;
+}
 
-    free(obj_mesh);
+/* free the jobs of a batch */
+void batch_free(batch_t *batch)
+{
+    int index = 0;
+
+    for (index = 0; index < batch->jobs_used; index++)
+        solid_buffer_free(&batch->jobs[index].packed);
+    for (index = 0; index < batch->packs_used; index++)
+        solid_pack_close(&batch->packs[index]);
+    if (batch->packs != NULL)
+        free(batch->packs);
+    if (batch->jobs != NULL)
+        free(batch->jobs);
+    if (batch->records != NULL)
+        free(batch->records);
+
+    batch_init(batch);
 }
 
-obj_face_t * obj_read_face(char *read_line, obj_mesh_t *obj_mesh)
+/* add the conversion of a file to a batch, the direction is given by its extension (returns 0 if it is not a mesh file) */
+int batch_add_file(batch_t *batch, const char *input_path, const char *output_directory)
 {
-    obj_face_t *obj_face;
+    batch_job_t *job = NULL;
+    char directory[1024];
+    const char *name = NULL;
+    size_t stem_length = 0;
+    int to_solid = 0;
+
+    if (path_has_extension(input_path, ".obj"))
+        to_solid = 1;
+    else if (path_has_extension(input_path, ".solid"))
+        to_solid = 0;
+    else
+        return 0;
+
+    if (!obj_array_reserve(NULL, (void **) &batch->jobs, &batch->jobs_allocated, batch->jobs_used + 1, sizeof(batch_job_t)))
+        {
+            printf("Error : can't realloc jobs buffer in function batch_add_file !\n");
+            return 0;
+        }
 
-    obj_face = obj_add_face(obj_mesh);
+    job = &batch->jobs[batch->jobs_used];
+    memset(job, 0, sizeof(batch_job_t));
+    job->to_solid = to_solid;
+    job->succeeded = 0;
+    job->pack_index = -1;
+    solid_buffer_init(&job->packed);
+    snprintf(job->input_path, sizeof(job->input_path), "%s", input_path);
+
+    /* outputs are written next to the input unless an output directory is given */
+    name = input_path + path_directory_length(input_path);
+    stem_length = strlen(name) - (to_solid ? 4 : 6);
+    if (output_directory == NULL)
+        snprintf(directory, sizeof(directory), "%.*s", (int) path_directory_length(input_path), input_path);
+    else
+        snprintf(directory, sizeof(directory), "%s/", output_directory);
 
-    if (obj_face != NULL)
+    if (snprintf(job->output_path, sizeof(job->output_path), "%s%.*s%s", directory, (int) stem_length, name, to_solid ? ".solid" : ".obj") >= (int) sizeof(job->output_path)
+            || snprintf(job->output_material_path, sizeof(job->output_material_path), "%s%.*s.mtl", directory, (int) stem_length, name) >= (int) sizeof(job->output_material_path))
         {
-            obj_face->is_quad = 0;
-            obj_face->vertex_index[0]=1;
-            obj_face->vertex_index[1]=1;
-            obj_face->vertex_index[2]=1;
-            obj_face->vertex_index[3]=1;
-            obj_face->texture_index[0]=1;
-            obj_face->texture_index[1]=1;
-            obj_face->texture_index[2]=1;
-            obj_face->texture_index[3]=1;
-            obj_face->normal_index[0]=1;
-            obj_face->normal_index[1]=1;
-            obj_face->normal_index[2]=1;
-            obj_face->normal_index[3]=1;
-            memset(obj_face->texture_name, '\0', 1024);
-
-            /* QUAD with vertex / texture / normal */
-            if (sscanf(read_line, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-                       &obj_face->vertex_index[0],
-                       &obj_face->texture_index[0],
-                       &obj_face->normal_index[0],
-                       &obj_face->vertex_index[1],
-                       &obj_face->texture_index[1],
-                       &obj_face->normal_index[1],
-                       &obj_face->vertex_index[2],
-                       &obj_face->texture_index[2],
-                       &obj_face->normal_index[2],
-                       &obj_face->vertex_index[3],
-                       &obj_face->texture_index[3],
-                       &obj_face->normal_index[3]
-                      ) == 12)
-                {
-                    obj_face->is_quad = 1;
-                    return obj_face;
-                }
+            printf("Error : output path of '%s' is too long !\n", input_path);
+            return 0;
+        }
 
-            /* QUAD with vertex / texture */
-            if (sscanf(read_line, "f %d/%d %d/%d %d/%d %d/%d",
-                       &obj_face->vertex_index[0],
-                       &obj_face->texture_index[0],
-                       &obj_face->vertex_index[1],
-                       &obj_face->texture_index[1],
-                       &obj_face->vertex_index[2],
-                       &obj_face->texture_index[2],
-                       &obj_face->vertex_index[3],
-                       &obj_face->texture_index[3]
-                      ) == 8)
-                {
-                    obj_face->is_quad = 1;
-                    return obj_face;
-                }
+    /* name in a pack (-P) */
+    if (snprintf(job->pack_name, sizeof(job->pack_name), "%.*s.solid", (int) stem_length, name) >= (int) sizeof(job->pack_name))
+        {
+            printf("Error : name of '%s' is too long for a pack !\n", input_path);
+            return 0;
+        }
 
-            /* QUAD with vertex */
-            if (sscanf(read_line, "f %d %d %d %d",
-                       &obj_face->vertex_index[0],
-                       &obj_face->vertex_index[1],
-                       &obj_face->vertex_index[2],
-                       &obj_face->vertex_index[3]
-                      ) == 4)
-                {
-                    obj_face->is_quad = 1;
-                    return obj_face;
-                }
+    batch->jobs_used++;
+    return 1;
+}
+
+/* add the conversion of every solid file of a pack to obj files to a batch (returns 0 on error) */
+int batch_add_pack(batch_t *batch, const char *pack_path, const char *output_directory)
+{
+    batch_job_t *job = NULL;
+    solid_pack_t *pack = NULL;
+    char directory[1024];
+    const char *name = NULL;
+    size_t stem_length = 0;
+    int entry_index = 0;
+
+    if (!obj_array_reserve(NULL, (void **) &batch->packs, &batch->packs_allocated, batch->packs_used + 1, sizeof(solid_pack_t)))
+        {
+            printf("Error : can't realloc packs buffer in function batch_add_pack !\n");
+            return 0;
+        }
+    pack = &batch->packs[batch->packs_used];
+    if (!solid_pack_open(pack, pack_path))
+        return 0;
+    batch->packs_used++;
+
+    if (output_directory == NULL)
+        snprintf(directory, sizeof(directory), "%.*s", (int) path_directory_length(pack_path), pack_path);
+    else
+        snprintf(directory, sizeof(directory), "%s/", output_directory);
 
-            /* TRI with vertex / texture / normal */
-            if (sscanf(read_line, "f %d/%d/%d %d/%d/%d %d/%d/%d",
-                       &obj_face->vertex_index[0],
-                       &obj_face->texture_index[0],
-                       &obj_face->normal_index[0],
-                       &obj_face->vertex_index[1],
-                       &obj_face->texture_index[1],
-                       &obj_face->normal_index[1],
-                       &obj_face->vertex_index[2],
-                       &obj_face->texture_index[2],
-                       &obj_face->normal_index[2]
-                      ) == 9)
+    for (entry_index = 0; entry_index < pack->entries_count; entry_index++)
+        {
+            /* names come from the pack, they must not lead out of the output directory */
+            name = solid_pack_entry_name(pack, entry_index);
+            if (strchr(name, '/') != NULL || strchr(name, '\\') != NULL)
                 {
-                    return obj_face;
+                    printf("Warning : '%s' in '%s' is not a plain file name, skipped !\n", name, pack_path);
+                    continue;
                 }
+            stem_length = strlen(name) - (path_has_extension(name, ".solid") ? 6 : 0);
 
-            /* TRI with vertex / texture */
-            if (sscanf(read_line, "f %d/%d %d/%d %d/%d",
-                       &obj_face->vertex_index[0],
-                       &obj_face->texture_index[0],
-                       &obj_face->vertex_index[1],
-                       &obj_face->texture_index[1],
-                       &obj_face->vertex_index[2],
-                       &obj_face->texture_index[2]
-                      ) == 6)
+            if (!obj_array_reserve(NULL, (void **) &batch->jobs, &batch->jobs_allocated, batch->jobs_used + 1, sizeof(batch_job_t)))
                 {
-                    return obj_face;
+                    printf("Error : can't realloc jobs buffer in function batch_add_pack !\n");
+                    return 0;
                 }
-
-            /* TRI with vertex */
-            if (sscanf(read_line, "f %d %d %d",
-                       &obj_face->vertex_index[0],
-                       &obj_face->vertex_index[1],
-                       &obj_face->vertex_index[2]
-                      ) == 3)
+            job = &batch->jobs[batch->jobs_used];
+            memset(job, 0, sizeof(batch_job_t));
+            job->to_solid = 0;
+            job->pack_index = batch->packs_used - 1;
+            job->entry_index = entry_index;
+            solid_buffer_init(&job->packed);
+            snprintf(job->input_path, sizeof(job->input_path), "%s", pack_path);
+            snprintf(job->pack_name, sizeof(job->pack_name), "%s", name);
+
+            if (snprintf(job->output_path, sizeof(job->output_path), "%s%.*s.obj", directory, (int) stem_length, name) >= (int) sizeof(job->output_path)
+                    || snprintf(job->output_material_path, sizeof(job->output_material_path), "%s%.*s.mtl", directory, (int) stem_length, name) >= (int) sizeof(job->output_material_path))
                 {
-                    return obj_face;
+                    printf("Error : output path of '%s' is too long !\n", name);
+                    continue;
                 }
-
-
-            return obj_face;
-
-            printf("Unknown face format\n");
+            batch->jobs_used++;
         }
-    return NULL;
+
+    return 1;
 }
 
-obj_material_t * obj_get_material_by_name(obj_mesh_t *obj_mesh, char *name)
+/* compare two strings for qsort */
+int compare_strings(const void *string1, const void *string2)
 {
-    int material_index = 0;
+    return strcmp(*(char * const *) string1, *(char * const *) string2);
+}
 
-    if (obj_mesh == NULL)
+/* add every obj and solid file of a directory to a batch (not recursive, sorted by name) */
+int batch_add_directory(batch_t *batch, const char *directory_path, const char *output_directory)
+{
+    DIR *directory = NULL;
+    struct dirent *entry = NULL;
+    char **names = NULL;
+    int names_used = 0;
+    int names_allocated = 0;
+    int name_index = 0;
+    char path[1024];
+    int result = 1;
+
+    directory = opendir(directory_path);
+    if (directory == NULL)
         {
-            return NULL;
+            printf("Error : can't open directory '%s' !\n", directory_path);
+            return 0;
         }
 
-    for(material_index=0; material_index < obj_mesh->materials_used; material_index++)
+    while ((entry = readdir(directory)) != NULL)
         {
-            if ( strcmp(obj_mesh->materials[material_index].name, name) == 0)
+            if (!path_has_extension(entry->d_name, ".obj") && !path_has_extension(entry->d_name, ".solid"))
+                continue;
+
+            if (!obj_array_reserve(NULL, (void **) &names, &names_allocated, names_used + 1, sizeof(char *))
+                    || (names[names_used] = strdup(entry->d_name)) == NULL)
                 {
-                    return &obj_mesh->materials[material_index];
+                    printf("Error : can't realloc names buffer in function batch_add_directory !\n");
+                    result = 0;
+                    break;
                 }
+            names_used++;
         }
+    closedir(directory);
 
-    return NULL;
-}
-
-/* allocate a new list and returns its handle */
-list_t * list_create(void *data)
-{
-    list_t *new_list;
-
-    new_list = (list_t *) malloc(sizeof(list_t));
+    /* readdir order depends on the file system, sort to get the same jobs on every run */
+    if (names_used > 0)
+        qsort(names, names_used, sizeof(char *), compare_strings);
 
-    if (new_list == NULL)
+    for (name_index = 0; name_index < names_used; name_index++)
         {
-            printf("Error while allocating list_t in function list_create !\n");
-            return NULL;
+            snprintf(path, sizeof(path), "%s/%s", directory_path, names[name_index]);
+            if (result)
+                batch_add_file(batch, path, output_directory);
+            free(names[name_index]);
         }
 
-    new_list->next = NULL;
-    new_list->data = data;
+    if (names != NULL)
+        free(names);
 
-    return new_list;
+    return result;
 }
 
-/* remove the first element of the list and returns the new list handle */
-list_t * list_pop_front(list_t *root)
+/* compare two inputs of a batch by file for qsort and bsearch */
+int batch_input_compare(const void *input1, const void *input2)
 {
-    list_t *node_to_free = NULL;
-
-    if (root == NULL)
-        return NULL;
-
-    node_to_free = root;
-    root = root->next;
-    free(node_to_free);
-    return root;
-}
-
-/* return the data of the first element of the list */
-void * list_get_front_data(list_t *root)
-{
-    if (root == NULL)
-        return NULL;
-
-    return root->data;
+    const batch_input_t *first = (const batch_input_t *) input1;
+    const batch_input_t *second = (const batch_input_t *) input2;
+
+    if (first->device != second->device)
+        return (first->device < second->device) ? -1 : 1;
+    if (first->inode != second->inode)
+        return (first->inode < second->inode) ? -1 : 1;
+#ifdef _WIN32
+    return strcmp(first->path, second->path);
+#else
+    return 0;
+#endif
 }
 
-/* insert a new data in the list */
-list_t * list_insert_front(list_t *root, void *data)
+/* read the identity of a file (returns 0 if it does not exist) */
+int batch_input_read(batch_input_t *input, const char *path, int job_index)
 {
-    list_t *new_root = NULL;
-
-    new_root = list_create(data);
-
-    new_root->next = root;
-
-    return new_root;
+    struct stat path_stat;
+
+    input->device = 0;
+    input->inode = 0;
+    input->path = path;
+    input->job_index = job_index;
+    if (stat(path, &path_stat) != 0)
+        return 0;
+#ifndef _WIN32
+    input->device = (long long) path_stat.st_dev;
+    input->inode = (long long) path_stat.st_ino;
+#endif
+    return 1;
 }
 
-/* get size of the list */
-size_t list_size(list_t *root)
+/* index of a job (not skipped, other than "job_index") reading the file at "path", -1 if there is none */
+int batch_find_reader(const batch_input_t *inputs, int inputs_count, const char *skipped, const char *path, int job_index)
 {
-    size_t size = 0;
-    list_t *iterator = NULL;
-
-    iterator = root;
-    while (iterator != NULL)
+    batch_input_t output;
+    const batch_input_t *found = NULL;
+    int first = 0;
+    int index = 0;
+
+    if (!batch_input_read(&output, path, -1))
+        return -1;
+    found = (const batch_input_t *) bsearch(&output, inputs, inputs_count, sizeof(batch_input_t), batch_input_compare);
+    if (found == NULL)
+        return -1;
+
+    /* the same file may be given twice */
+    for (first = (int) (found - inputs); first > 0 && batch_input_compare(&inputs[first - 1], &output) == 0; first--)
+        ;
+    for (index = first; index < inputs_count && batch_input_compare(&inputs[index], &output) == 0; index++)
         {
-            size++;
-            iterator = iterator->next;
+            if (inputs[index].job_index != job_index && !skipped[inputs[index].job_index])
+                return inputs[index].job_index;
         }
-
-    return size;
+    return -1;
 }
 
-/* free memory used by a list, free data if specified */
-list_t * list_free(list_t *root, int free_data)
+/* skip the jobs that would overwrite the input of another job : first the solid files converted back to the obj file they were made from
+   (left by a previous batch next to their obj file), then any job still writing over an input (returns 0 on error) */
+int batch_skip_overwriting_jobs(batch_t *batch)
 {
-    list_t *node_to_free = NULL;
+    batch_input_t *inputs = NULL;
+    char *skipped = NULL;
+    batch_job_t *job = NULL;
+    int pass = 0;
+    int job_index = 0;
+    int reader_index = 0;
+    int kept_count = 0;
+
+    if (batch->jobs_used == 0)
+        return 1;
+    inputs = (batch_input_t *) malloc(sizeof(batch_input_t) * batch->jobs_used);
+    skipped = (char *) calloc(batch->jobs_used, 1);
+    if (inputs == NULL || skipped == NULL)
+        {
+            printf("Error : can't allocate inputs in function batch_skip_overwriting_jobs !\n");
+            free(inputs);
+            free(skipped);
+            return 0;
+        }
 
-    node_to_free = root;
+    for (job_index = 0; job_index < batch->jobs_used; job_index++)
+        batch_input_read(&inputs[job_index], batch->jobs[job_index].input_path, job_index);
+    qsort(inputs, batch->jobs_used, sizeof(batch_input_t), batch_input_compare);
 
-    while (node_to_free != NULL)
+    for (pass = 0; pass < 2; pass++)
         {
-            root = node_to_free->next;
-            if (free_data)
+            for (job_index = 0; job_index < batch->jobs_used; job_index++)
                 {
-                    free(node_to_free->data);
+                    job = &batch->jobs[job_index];
+                    if (skipped[job_index] || (pass == 0 && (job->to_solid || job->pack_index >= 0)))
+                        continue;
+                    reader_index = batch_find_reader(inputs, batch->jobs_used, skipped, job->output_path, job_index);
+                    if (reader_index < 0 && !job->to_solid)
+                        reader_index = batch_find_reader(inputs, batch->jobs_used, skipped, job->output_material_path, job_index);
+                    if (reader_index < 0)
+                        continue;
+                    printf("Warning : converting '%s' would overwrite '%s', an input of the batch, skipped !\n", job->input_path, batch->jobs[reader_index].input_path);
+                    skipped[job_index] = 1;
                 }
-            free(node_to_free);
-            node_to_free = root;
         }
 
-    return root;
+    /* the jobs left keep their order */
+    for (job_index = 0; job_index < batch->jobs_used; job_index++)
+        {
+            if (skipped[job_index])
+                solid_buffer_free(&batch->jobs[job_index].packed);
+            else
+                batch->jobs[kept_count++] = batch->jobs[job_index];
+        }
+    batch->jobs_used = kept_count;
+
+    free(inputs);
+    free(skipped);
+    return 1;
 }
 
-/* compare two materials colors (id is not compared) */
-int compare_materials_colors(const solid_material_t *mat1, const solid_material_t *mat2)
+/* compare two pointers to jobs of a batch by name in the pack for qsort */
+int batch_job_pack_name_compare(const void *job1, const void *job2)
 {
-    return (mat1->r == mat2->r && mat1->g == mat2->g && mat1->b == mat2->b);
+    return strcmp((*(batch_job_t * const *) job1)->pack_name, (*(batch_job_t * const *) job2)->pack_name);
 }
 
-/* get the material matching the data supplied */
-solid_material_t * solid_material_get(list_t *root, const solid_material_t *material)
+/* make the names of the solid files put in a pack unique before converting anything : a solid file named like an obj file of the batch
+   (left by a previous batch next to it) is skipped for the obj file, other files with the same name are refused (returns 0 on error) */
+int batch_skip_duplicate_pack_names(batch_t *batch)
 {
-    list_t *iterator = NULL;
+    batch_job_t **sorted = NULL;
+    char *skipped = NULL;
+    int first = 0;
+    int last = 0;
+    int index = 0;
+    int obj_count = 0;
+    int kept_count = 0;
+    int result = 1;
+
+    if (batch->jobs_used == 0)
+        return 1;
+    sorted = (batch_job_t **) malloc(sizeof(batch_job_t *) * batch->jobs_used);
+    skipped = (char *) calloc(batch->jobs_used, 1);
+    if (sorted == NULL || skipped == NULL)
+        {
+            printf("Error : can't allocate jobs in function batch_skip_duplicate_pack_names !\n");
+            free(sorted);
+            free(skipped);
+            return 0;
+        }
 
-    /* go to the start of the list */
-    iterator = root;
+    for (index = 0; index < batch->jobs_used; index++)
+        sorted[index] = &batch->jobs[index];
+    qsort(sorted, batch->jobs_used, sizeof(batch_job_t *), batch_job_pack_name_compare);
 
-    while (iterator != NULL)
+    for (first = 0; first < batch->jobs_used; first = last)
         {
-            if ( compare_materials_colors(material, iterator->data) )
-                return iterator->data;
+            obj_count = 0;
+            for (last = first; last < batch->jobs_used && strcmp(sorted[last]->pack_name, sorted[first]->pack_name) == 0; last++)
+                obj_count += sorted[last]->to_solid;
+            if (last - first == 1)
+                continue;
 
-            iterator = iterator->next;
+            for (index = first; index < last; index++)
+                {
+                    if (obj_count == 1 && !sorted[index]->to_solid)
+                        {
+                            printf("Warning : '%s' would be '%s' in the pack like an obj file of the batch, skipped !\n", sorted[index]->input_path, sorted[index]->pack_name);
+                            skipped[sorted[index] - batch->jobs] = 1;
+                        }
+                    else if (obj_count != 1)
+                        {
+                            printf("Error : '%s' and '%s' would both be '%s' in the pack !\n", sorted[first]->input_path, sorted[first + 1]->input_path, sorted[first]->pack_name);
+                            result = 0;
+                            break;
+                        }
+                }
         }
 
-    /* material not found */
-    return NULL;
+    /* the jobs left keep their order */
+    for (index = 0; index < batch->jobs_used; index++)
+        {
+            if (skipped[index])
+                solid_buffer_free(&batch->jobs[index].packed);
+            else
+                batch->jobs[kept_count++] = batch->jobs[index];
+        }
+    batch->jobs_used = kept_count;
+
+    free(sorted);
+    free(skipped);
+    return result;
 }
 
-/* get the material matching the data supplied or insert a new one (list root passed as argument may be altered) */
-solid_material_t * solid_material_get_or_insert_in_list(list_t **root, const solid_material_t *material)
+/* add a file, every solid file of a pack or every mesh file of a directory to a batch */
+int batch_add_input(batch_t *batch, const char *input_path, const char *output_directory)
 {
-    solid_material_t *new_material = NULL;
-    solid_material_t *found_material = NULL;
-
-    found_material = solid_material_get(*root, material);
-
-    if (found_material != NULL)
-        return found_material;
+    if (path_is_directory(input_path))
+        return batch_add_directory(batch, input_path, output_directory);
+    if (path_has_extension(input_path, ".pack"))
+        return batch_add_pack(batch, input_path, output_directory);
 
-    /* material not found, insert a new one */
-    new_material = (solid_material_t *) malloc(sizeof(solid_material_t));
-    if (new_material == NULL)
+    if (!batch_add_file(batch, input_path, output_directory))
         {
-            printf("Error : can't allocate a new solid_material_t in function solid_material_get_or_insert_in_list !\n");
-            return NULL;
+            printf("Warning : '%s' is neither an obj nor a solid file, skipped !\n", input_path);
+            return 0;
         }
-    *new_material = *material;
 
-    *root = list_insert_front(*root, new_material);
-
-    return new_material;
+    return 1;
 }
 
-/* assign unique id and name to each material in the list */
-void solid_material_list_assign_unique_id_and_name(list_t *root)
+/* add the inputs listed in a manifest file (one file or directory per line, '#' starts a comment) */
+int batch_add_manifest(batch_t *batch, const char *manifest_path, const char *output_directory)
 {
-    list_t *iterator = NULL;
-    int current_unique_id = 0;
-    char name_buffer[1024];
-
-    iterator = root;
-
-    while(iterator != NULL)
+    mapped_file_t manifest;
+    const char *line = NULL;
+    const char *line_end = NULL;
+    const char *end = NULL;
+    char input_path[1024];
+    size_t length = 0;
+
+    if (!mapped_file_open(&manifest, manifest_path))
         {
-            if (iterator->data != NULL)
-                {
-                    ((solid_material_t *) iterator->data)->id = current_unique_id;
-                    sprintf(name_buffer, "%s_%d", "material", current_unique_id);
-                    strncpy(((solid_material_t *) iterator->data)->name, name_buffer, strlen(name_buffer));
-                    current_unique_id++;
-                }
-            iterator = iterator->next;
+            printf("Error : can't open manifest '%s' for reading !\n", manifest_path);
+            return 0;
         }
-}
 
-/* read short (2 bytes) from file */
-int solid_read_short(FILE *file, int count, short *s)
-{
-    while(count--)
+    line = manifest.data;
+    end = manifest.data + manifest.size;
+    while (line < end)
         {
-            unsigned char buf[2];
-            if (fread(&buf, 2, 1, file) != 1)
+            line_end = (const char *) memchr(line, '\n', end - line);
+            if (line_end == NULL)
+                line_end = end;
+
+            /* paths may contain spaces, only the blanks around them are removed */
+            while (line < line_end && (*line == ' ' || *line == '\t'))
+                line++;
+            length = line_end - line;
+            while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t' || line[length - 1] == '\r'))
+                length--;
+
+            if (length > 0 && line[0] != '#')
                 {
-                    return 0;
+                    snprintf(input_path, sizeof(input_path), "%.*s", (int) length, line);
+                    batch_add_input(batch, input_path, output_directory);
                 }
-            *s = (short) ((buf[0] << 8) | buf[1]);
-            s++;
+
+            line = line_end + 1;
         }
+
+    mapped_file_close(&manifest);
     return 1;
 }
 
-/* write short (2 bytes) to file */
-int solid_write_short(FILE *file, int count, const short *s)
+/* options changing the files written, the outputs of a previous run with other options or another version are converted again */
+void build_options_format(const conversion_options_t *options, char *build_options, size_t size)
 {
-    while(count--)
-        {
-            fputc( (*s >> 8) & 0xff, file);
-            fputc( (*s >> 0) & 0xff, file);
-            s++;
-        }
-    return 1;
+    snprintf(build_options, size, "v%s p%d w%.9g c%d D%d,%d f%d n%d", PROGRAM_VERSION, options->float_precision, options->weld_epsilon,
+             options->optimize_vertex_cache, options->decimation_faces, options->decimation_vertices, options->solid_format, options->compute_normals);
 }
 
-/* read int (4 bytes) from file */
-int solid_read_int(FILE *file, int count, int *s)
+/* read the state of a file, its content is only hashed if its size or time differ from "known" (may be NULL, returns 0 if the file can't be read) */
+int build_file_state_read(const char *path, const solid_file_state_t *known, solid_file_state_t *state)
 {
-    while(count--)
+    struct stat file_stat;
+    mapped_file_t mapped_file;
+
+    memset(state, 0, sizeof(solid_file_state_t));
+    if (stat(path, &file_stat) != 0)
+        return 0;
+
+    state->size = (uint64_t) file_stat.st_size;
+    state->time = (long long) file_stat.st_mtime;
+    if (known != NULL && known->found && known->size == state->size && known->time == state->time)
         {
-            unsigned char buf[4];
-            if (fread(&buf, 4, 1, file) != 1)
-                {
-                    return 0;
-                }
-            *s = (int) ((buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3]));
-            s++;
+            state->hash = known->hash;
+        }
+    else
+        {
+            if (!mapped_file_open(&mapped_file, path))
+                return 0;
+            state->hash = mapped_file_hash(&mapped_file);
+            mapped_file_close(&mapped_file);
         }
+
+    state->found = 1;
     return 1;
 }
 
-/* write int (4 bytes) to file */
-int solid_write_int(FILE *file, int count, const int *s)
+/* true if a file is still in the state it has been recorded in (the time alone does not matter) */
+int build_file_state_unchanged(const solid_file_state_t *recorded, const solid_file_state_t *state)
 {
-    while(count--)
-        {
-            fputc( (*s >> 24) & 0xff, file);
-            fputc( (*s >> 16) & 0xff, file);
-            fputc( (*s >> 8) & 0xff, file);
-            fputc( (*s >> 0) & 0xff, file);
-            s++;
-        }
+    return recorded->found == state->found && (!state->found || (recorded->size == state->size && recorded->hash == state->hash));
+}
+
+/* read a state written by build_manifest_write */
+int build_file_state_parse(const char *text, solid_file_state_t *state)
+{
+    unsigned long long size = 0;
+    unsigned long long hash = 0;
+
+    memset(state, 0, sizeof(solid_file_state_t));
+    if (sscanf(text, "%d %llu %lld %llx", &state->found, &size, &state->time, &hash) != 4)
+        return 0;
+
+    state->size = (uint64_t) size;
+    state->hash = (uint64_t) hash;
     return 1;
 }
 
-/* union between int and float (used here to convert int to float) */
-union intfloat
+/* compare two records of a build manifest by output path for qsort and bsearch */
+int build_record_compare(const void *record1, const void *record2)
 {
-    int i;
-    float f;
-} intfloat;
+    return strcmp(((const build_record_t *) record1)->output_path, ((const build_record_t *) record2)->output_path);
+}
 
-/* read float (here 4 bytes specifically to the solid file format) from file */
-int solid_read_float(FILE *file, int count, float *f)
+/* compare two pointers to records of a build manifest by output path for qsort and bsearch */
+int build_record_pointer_compare(const void *record1, const void *record2)
 {
-    union intfloat infl;
-    infl.f = 0;
-    while(count--)
-        {
-            solid_read_int(file, 1, &(infl.i));
-            *f = infl.f;
-            f++;
-        }
-    return 1;
+    return build_record_compare(*(const build_record_t * const *) record1, *(const build_record_t * const *) record2);
 }
 
-/* write float (4 bytes) to file */
-int solid_write_float(FILE *file, int count, const float *f)
+/* load the build manifest of the previous run (a missing manifest is an empty one, returns 0 on error) */
+int build_manifest_load(batch_t *batch, const char *path)
 {
-    union intfloat infl;
-    while(count--)
+    mapped_file_t manifest;
+    const char *line = NULL;
+    const char *line_end = NULL;
+    const char *end = NULL;
+    const char *field = NULL;
+    const char *field_end = NULL;
+    const char *fields[6];
+    size_t lengths[6];
+    char text[1024];
+    build_record_t *record = NULL;
+    int records_allocated = 0;
+    int fields_count = 0;
+
+    batch->build_manifest_path = path;
+    build_options_format(&batch->options, batch->build_options, sizeof(batch->build_options));
+
+    if (!path_exists(path))
+        return 1;
+    if (!mapped_file_open(&manifest, path))
         {
-            infl.f = *f;
-            solid_write_int(file, 1, &infl.i);
-            f++;
+            printf("Error : can't open build manifest '%s' for reading !\n", path);
+            return 0;
         }
-    return 1;
-}
 
-/* read XYZ from file */
-int solid_read_XYZ(FILE *file, int count, solid_XYZ_t *xyz)
-{
-    while(count--)
+    /* output, input, input state, material, material state and options separated by tabs */
+    line = manifest.data;
+    end = manifest.data + manifest.size;
+    while (line < end)
         {
-            solid_read_float(file, 1, &(xyz->x));
-            solid_read_float(file, 1, &(xyz->y));
-            solid_read_float(file, 1, &(xyz->z));
-            xyz++;
+            line_end = (const char *) memchr(line, '\n', end - line);
+            if (line_end == NULL)
+                line_end = end;
+
+            /* the options are the last field, they may hold tabs */
+            fields_count = 0;
+            field = line;
+            while (fields_count < 6)
+                {
+                    field_end = (const char *) memchr(field, '\t', line_end - field);
+                    if (field_end == NULL || fields_count == 5)
+                        field_end = line_end;
+                    fields[fields_count] = field;
+                    lengths[fields_count] = field_end - field;
+                    fields_count++;
+                    if (field_end == line_end)
+                        break;
+                    field = field_end + 1;
+                }
+            if (fields_count == 6 && lengths[5] > 0 && fields[5][lengths[5] - 1] == '\r')
+                lengths[5]--;
+
+            /* comments and lines that can't be read are dropped, their outputs are converted again */
+            if (line[0] != '#' && fields_count == 6 && lengths[0] < 1024 && lengths[1] < 1024 && lengths[2] < 1024
+                    && lengths[3] < 1024 && lengths[4] < 1024 && lengths[5] < 256)
+                {
+                    if (!obj_array_reserve(NULL, (void **) &batch->records, &records_allocated, batch->records_used + 1, sizeof(build_record_t)))
+                        {
+                            printf("Error : can't realloc records buffer in function build_manifest_load !\n");
+                            mapped_file_close(&manifest);
+                            return 0;
+                        }
+                    record = &batch->records[batch->records_used];
+                    snprintf(record->output_path, sizeof(record->output_path), "%.*s", (int) lengths[0], fields[0]);
+                    snprintf(record->input_path, sizeof(record->input_path), "%.*s", (int) lengths[1], fields[1]);
+                    snprintf(record->material_path, sizeof(record->material_path), "%.*s", (int) lengths[3], fields[3]);
+                    snprintf(record->options, sizeof(record->options), "%.*s", (int) lengths[5], fields[5]);
+                    snprintf(text, sizeof(text), "%.*s", (int) lengths[2], fields[2]);
+                    if (build_file_state_parse(text, &record->input))
+                        {
+                            snprintf(text, sizeof(text), "%.*s", (int) lengths[4], fields[4]);
+                            if (build_file_state_parse(text, &record->material))
+                                batch->records_used++;
+                        }
+                }
+
+            line = line_end + 1;
         }
+    mapped_file_close(&manifest);
+
+    if (batch->records_used > 0)
+        qsort(batch->records, batch->records_used, sizeof(build_record_t), build_record_compare);
     return 1;
 }
 
-/* read solid_textured_triangle from file */
-int solid_read_textured_triangle(FILE *file, int count, solid_textured_triangle_t *solid_textured_triangle)
+/* read the state of the inputs of a job into its record and tell if its outputs are up to date (called by the workers, only reads the batch) */
+int build_job_check(const batch_t *batch, batch_job_t *job)
 {
-    while(count--)
+    const build_record_t *recorded = NULL;
+    solid_file_state_t material;
+    char geometry_path[1024 + sizeof(SOLID_GEOMETRY_EXTENSION)];
+    int result = 0;
+
+    snprintf(job->record.output_path, sizeof(job->record.output_path), "%s", job->output_path);
+    snprintf(job->record.input_path, sizeof(job->record.input_path), "%s", job->input_path);
+    snprintf(job->record.options, sizeof(job->record.options), "%s", batch->build_options);
+    job->record.material_path[0] = '\0';
+
+    if (batch->records_used > 0)
+        recorded = (const build_record_t *) bsearch(&job->record, batch->records, batch->records_used, sizeof(build_record_t), build_record_compare);
+    if (recorded != NULL && strcmp(recorded->input_path, job->input_path) != 0)
+        recorded = NULL;
+
+    if (!build_file_state_read(job->input_path, (recorded != NULL) ? &recorded->input : NULL, &job->record.input) || recorded == NULL)
+        return 0;
+
+    /* the outputs are only looked for, never opened */
+    result = strcmp(recorded->options, batch->build_options) == 0
+             && build_file_state_unchanged(&recorded->input, &job->record.input)
+             && path_exists(job->output_path) && (job->to_solid || path_exists(job->output_material_path));
+
+    /* the bounds and normals written next to a solid file are an output too */
+    if (result && job->to_solid && batch->options.compute_normals)
         {
-            short pad;
-            solid_read_short(file, 3, solid_textured_triangle->vertex);
-            solid_read_short(file, 1, &pad);
-            solid_read_float(file, 1, &(solid_textured_triangle->r));
-            solid_read_float(file, 1, &(solid_textured_triangle->g));
-            solid_read_float(file, 1, &(solid_textured_triangle->b));
-            solid_textured_triangle++;
+            snprintf(geometry_path, sizeof(geometry_path), "%s" SOLID_GEOMETRY_EXTENSION, job->output_path);
+            result = path_exists(geometry_path);
         }
-    return 1;
+
+    /* the material file declared by the obj file (a missing one counts too, it may have been added since next to the obj file or in the
+       current directory) */
+    if (result && recorded->material_path[0] != '\0')
+        {
+            if (recorded->material.found)
+                {
+                    build_file_state_read(recorded->material_path, &recorded->material, &material);
+                    result = build_file_state_unchanged(&recorded->material, &material);
+                }
+            else
+                {
+                    memset(&material, 0, sizeof(solid_file_state_t));
+                    result = !obj_material_file_exists(job->input_path, recorded->material_path);
+                }
+            if (result)
+                {
+                    snprintf(job->record.material_path, sizeof(job->record.material_path), "%s", recorded->material_path);
+                    job->record.material = material;
+                }
+        }
+
+    return result;
 }
 
-/* create a new solid mesh in memory */
-solid_mesh_t *solid_mesh_create(char *filename, short vertex_count, short triangle_count)
+/* write the build manifest : the jobs converted, and the records of the previous run for the outputs not in this batch (returns 0 on error) */
+int build_manifest_write(const batch_t *batch)
 {
-    solid_mesh_t *solid_mesh = NULL;
-
-    /* allocate memory for the solid mesh structure */
-    solid_mesh = (solid_mesh_t *) malloc(sizeof(solid_mesh_t));
-    if (solid_mesh == NULL)
+    solid_buffer_t buffer;
+    const build_record_t **records = NULL;
+    const build_record_t **job_records = NULL;
+    const build_record_t *record = NULL;
+    char temporary_path[1024];
+    int records_used = 0;
+    int record_index = 0;
+    int job_index = 0;
+    int result = 1;
+
+    records = (const build_record_t **) malloc(sizeof(build_record_t *) * (batch->records_used + batch->jobs_used + 1));
+    job_records = (const build_record_t **) malloc(sizeof(build_record_t *) * (batch->jobs_used + 1));
+    if (records == NULL || job_records == NULL)
         {
-            printf("Error : can't allocate solid mesh in function create_solid_mesh !\n");
-            return NULL;
+            printf("Error : can't allocate records in function build_manifest_write !\n");
+            free(records);
+            free(job_records);
+            return 0;
         }
 
-    /* set filename */
-    strncpy(solid_mesh->filename, filename, 1024);
-
-    /* set vertex and triangle count */
-    solid_mesh->vertex_count = vertex_count;
-    solid_mesh->triangle_count = triangle_count;
+    /* the outputs of failed jobs are dropped, they are converted again next time */
+    for (job_index = 0; job_index < batch->jobs_used; job_index++)
+        {
+            job_records[job_index] = &batch->jobs[job_index].record;
+            if (batch->jobs[job_index].succeeded)
+                records[records_used++] = &batch->jobs[job_index].record;
+        }
+    if (batch->jobs_used > 0)
+        qsort(job_records, batch->jobs_used, sizeof(build_record_t *), build_record_pointer_compare);
+    for (record_index = 0; record_index < batch->records_used; record_index++)
+        {
+            record = &batch->records[record_index];
+            if (batch->jobs_used == 0 || bsearch(&record, job_records, batch->jobs_used, sizeof(build_record_t *), build_record_pointer_compare) == NULL)
+                records[records_used++] = record;
+        }
+    if (records_used > 0)
+        qsort(records, records_used, sizeof(build_record_t *), build_record_pointer_compare);
 
-    /* allocate memory for the vertices of the solid mesh */
-    solid_mesh->vertices = (solid_XYZ_t *) malloc(sizeof(solid_XYZ_t) * vertex_count);
-    if (solid_mesh->vertices == NULL)
+    solid_buffer_init(&buffer);
+    result &= solid_buffer_printf(&buffer, "# " PROGRAM_NAME " build manifest : output, input, input state, material, material state, options\n");
+    for (record_index = 0; record_index < records_used; record_index++)
         {
-            printf("Error : can't allocate solid mesh vertices in function create_solid_mesh !\n");
-            free(solid_mesh);
-            return NULL;
+            /* an input listed twice is written once */
+            record = records[record_index];
+            if (record_index > 0 && strcmp(record->output_path, records[record_index - 1]->output_path) == 0)
+                continue;
+            result &= solid_buffer_printf(&buffer, "%s\t%s\t%d %llu %lld %016llx\t%s\t%d %llu %lld %016llx\t%s\n",
+                                          record->output_path, record->input_path,
+                                          record->input.found, (unsigned long long) record->input.size, record->input.time, (unsigned long long) record->input.hash,
+                                          record->material_path,
+                                          record->material.found, (unsigned long long) record->material.size, record->material.time, (unsigned long long) record->material.hash,
+                                          record->options);
         }
 
-    /* allocate memory for the triangles of the solid mesh */
-    solid_mesh->triangles = (solid_textured_triangle_t *) malloc(sizeof(solid_textured_triangle_t) * triangle_count);
-    if (solid_mesh->triangles == NULL)
+    /* written aside then renamed, an interrupted run keeps the previous manifest */
+    result = result && snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", batch->build_manifest_path) < (int) sizeof(temporary_path)
+             && solid_buffer_write_file(&buffer, temporary_path);
+    if (result)
         {
-            printf("Error : can't allocate solid mesh triangles in function create_solid_mesh !\n");
-            free(solid_mesh->vertices);
-            free(solid_mesh);
-            return NULL;
+#ifdef _WIN32
+            remove(batch->build_manifest_path);
+#endif
+            result = (rename(temporary_path, batch->build_manifest_path) == 0);
         }
+    if (!result)
+        printf("Error : can't write build manifest '%s' !\n", batch->build_manifest_path);
 
-    /* return the newly created solid mesh */
-    return solid_mesh;
+    solid_buffer_free(&buffer);
+    free(records);
+    free(job_records);
+    return result;
 }
 
-/* free a solid mesh from memory */
-void solid_mesh_free(solid_mesh_t *solid_mesh)
+/* put the solid files made by the jobs of a batch in its pack, in the order of the jobs (returns 0 on error) */
+int batch_write_pack(batch_t *batch)
 {
-    if (solid_mesh == NULL)
-        return;
-
-    if (solid_mesh->vertices != NULL)
-        free(solid_mesh->vertices);
+    solid_pack_writer_t writer;
+    size_t files_size = 0;
+    int job_index = 0;
+    int packed_count = 0;
+    int result = 1;
+
+    solid_pack_writer_init(&writer);
+    for (job_index = 0; job_index < batch->jobs_used && result; job_index++)
+        {
+            if (!batch->jobs[job_index].succeeded)
+                continue;
+            result = solid_pack_writer_add(&writer, batch->jobs[job_index].pack_name, batch->jobs[job_index].packed.data, batch->jobs[job_index].packed.used);
+            files_size += batch->jobs[job_index].packed.used;
+            packed_count++;
+        }
 
-    if (solid_mesh->triangles != NULL)
-        free(solid_mesh->triangles);
+    result = result && solid_pack_writer_write(&writer, batch->pack_path);
+    if (result)
+        printf("%d file(s) packed in '%s' (%lu bytes of solid files compressed to %lu)\n", packed_count, batch->pack_path,
+               (unsigned long) files_size, (unsigned long) writer.data.used);
+    else
+        printf("Error : can't write pack '%s' !\n", batch->pack_path);
 
-    free(solid_mesh);
+    solid_pack_writer_free(&writer);
+    return result;
 }
 
-/* convert a solid mesh to an obj one */
-void solid_mesh_convert_to_obj(solid_mesh_t *solid_mesh, char *output_file_path, char *output_material_file_path)
+/* run a job of a batch and print its result */
+void batch_run_job(batch_t *batch, batch_job_t *job)
 {
-    FILE *output_file = NULL;
-    FILE *output_material_file = NULL;
-    int vertex_index = 0;
-    int triangle_index = 0;
-    list_t *material_list = NULL;
-    solid_material_t *current_material = NULL;
-    solid_material_t *found_material = NULL;
-    int previous_material_id = -1;
-    list_t *iterator = NULL;
-
-    if (solid_mesh == NULL)
+    conversion_options_t options;
+    solid_buffer_t report;
+
+    /* the inputs are checked by the workers, so many files are hashed at the same time */
+    if (batch->build_manifest_path != NULL && build_job_check(batch, job))
         {
-            printf("Error : solid mesh is NULL in function solid_mesh_convert_to_obj !\n");
+            job->up_to_date = 1;
+            job->succeeded = 1;
             return;
         }
 
-    /* allocate memory for the material used for comparison */
-    current_material = (solid_material_t *) malloc(sizeof(solid_material_t));
+    /* the material file read is a dependency of the solid file, its state is the one of the content converted */
+    options = batch->options;
+    options.material_file_path = job->record.material_path;
+    options.material_file_state = &job->record.material;
+    memset(&job->record.material, 0, sizeof(solid_file_state_t));
+
+    /* messages are kept per file so that the outputs of concurrent jobs are not mixed */
+    solid_buffer_init(&report);
+    report_set_capture(&report);
+    if (job->pack_index >= 0)
+        job->succeeded = convert_pack_entry_to_obj(&batch->packs[job->pack_index], job->entry_index, job->output_path, job->output_material_path, &options);
+    else if (batch->pack_path != NULL && job->to_solid)
+        job->succeeded = convert_obj_file_to_solid_buffer(job->input_path, &job->packed, &options);
+    else if (batch->pack_path != NULL)
+        job->succeeded = solid_buffer_read_file(&job->packed, job->input_path);
+    else if (job->to_solid)
+        job->succeeded = convert_obj_file_to_solid(job->input_path, job->output_path, &options);
+    else
+        job->succeeded = convert_solid_file_to_obj(job->input_path, job->output_path, job->output_material_path, &options);
+    report_set_capture(NULL);
+
+#ifndef _WIN32
+    pthread_mutex_lock(&batch->mutex);
+#endif
+    if (job->pack_index >= 0)
+        printf("%s '%s' in '%s' -> '%s'\n", job->succeeded ? "ok" : "FAILED", job->pack_name, job->input_path, job->output_path);
+    else if (batch->pack_path != NULL)
+        printf("%s '%s' -> '%s' in '%s'\n", job->succeeded ? "ok" : "FAILED", job->input_path, job->pack_name, batch->pack_path);
+    else
+        printf("%s '%s' -> '%s'\n", job->succeeded ? "ok" : "FAILED", job->input_path, job->output_path);
+    if (report.used > 0)
+        printf("%.*s", (int) report.used, (const char *) report.data);
+    if (!job->succeeded)
+        batch->failed_count++;
+#ifndef _WIN32
+    pthread_mutex_unlock(&batch->mutex);
+#endif
+
+    solid_buffer_free(&report);
+}
 
-    /* compute all materials (colors only) */
-    for(triangle_index=0; triangle_index<solid_mesh->triangle_count; triangle_index++)
-        {
-            current_material->r =  solid_mesh->triangles[triangle_index].r;
-            current_material->g =  solid_mesh->triangles[triangle_index].g;
-            current_material->b =  solid_mesh->triangles[triangle_index].b;
-            found_material = solid_material_get_or_insert_in_list(&material_list, current_material);
-        }
-    solid_material_list_assign_unique_id_and_name(material_list);
-    printf("%lu material(s) declared\n", (unsigned long) list_size(material_list));
+/* take the jobs of a batch one after the other until there is none left */
+void * batch_worker(void *data)
+{
+    batch_t *batch = (batch_t *) data;
+    solid_arena_t arena;
+    int job_index = 0;
 
-    /* OBJ file */
+    /* the meshes of each job are kept in an arena of the worker, emptied at once between jobs and reused */
+    solid_arena_init(&arena);
+    solid_arena_set_current(&arena);
 
-    /* open obj output file for writing */
-    output_file = fopen(output_file_path, "w");
-    if (output_file == NULL)
+    while (1)
         {
-            printf("Error : can't open '%s' for writing !\n", output_file_path);
-            return;
+#ifndef _WIN32
+            pthread_mutex_lock(&batch->mutex);
+#endif
+            job_index = batch->next_job;
+            if (job_index < batch->jobs_used)
+                batch->next_job++;
+#ifndef _WIN32
+            pthread_mutex_unlock(&batch->mutex);
+#endif
+
+            if (job_index >= batch->jobs_used)
+                break;
+
+            batch_run_job(batch, &batch->jobs[job_index]);
+            solid_arena_reset(&arena);
         }
 
-    /* header */
-    fprintf(output_file, "# exported from Blackshade's solid mesh file '%s'\n", solid_mesh->filename);
-
-    /* material file */
-    fprintf(output_file, "mtllib %s\n", output_material_file_path);
-
-    /* export vertices */
-    for(vertex_index=0; vertex_index<solid_mesh->vertex_count; vertex_index++)
-        {
-            fprintf(output_file, "v %f %f %f 1.0\n",
-                    solid_mesh->vertices[vertex_index].x,
-                    -1 * solid_mesh->vertices[vertex_index].z, /* Up vector must be swapped for blender (blender uses Z as the up vector) */
-                    solid_mesh->vertices[vertex_index].y
-                   );
-        }
+    solid_arena_set_current(NULL);
+    solid_arena_free(&arena);
+    return NULL;
+}
 
-    /* export triangles */
-    for(triangle_index=0; triangle_index<solid_mesh->triangle_count; triangle_index++)
-        {
-            found_material = NULL;
+/* run all the jobs of a batch on a pool of threads (returns the number of failed jobs) */
+int batch_run(batch_t *batch, int threads_count)
+{
+#ifndef _WIN32
+    pthread_t *threads = NULL;
+    int thread_index = 0;
+    int threads_started = 0;
 
-            current_material->r =  solid_mesh->triangles[triangle_index].r;
-            current_material->g =  solid_mesh->triangles[triangle_index].g;
-            current_material->b =  solid_mesh->triangles[triangle_index].b;
+    if (threads_count > batch->jobs_used)
+        threads_count = batch->jobs_used;
 
-            /* get matching material */
-            found_material = solid_material_get(material_list, current_material);
+    pthread_mutex_init(&batch->mutex, NULL);
 
-            if (found_material != NULL && found_material->id != previous_material_id)
+    threads = (pthread_t *) malloc(sizeof(pthread_t) * (threads_count > 0 ? threads_count : 1));
+    if (threads != NULL)
+        {
+            for (thread_index = 0; thread_index < threads_count; thread_index++)
                 {
-                    fprintf(output_file, "usemtl %s\n", found_material->name);
-                    previous_material_id = found_material->id;
+                    if (pthread_create(&threads[thread_index], NULL, batch_worker, batch) != 0)
+                        break;
+                    threads_started++;
                 }
-            fprintf(output_file, "f %hu %hu %hu\n",
-                    solid_mesh->triangles[triangle_index].vertex[0] + 1,
-                    solid_mesh->triangles[triangle_index].vertex[1] + 1,
-                    solid_mesh->triangles[triangle_index].vertex[2] + 1
-                   );
         }
 
-    fclose(output_file);
-
-    /* MTL file */
-    output_material_file = fopen(output_material_file_path, "w");
-    if (output_material_file == NULL)
-        {
-            printf("Error : can't open '%s' for writing !\n", output_material_file_path);
-            return;
-        }
+    /* the calling thread works too (and does everything if no thread could be started) */
+    batch_worker(batch);
 
-    /* header */
-    fprintf(output_material_file, "# material file for Blackshade's solid mesh file '%s' converted to obj '%s'\n", solid_mesh->filename, output_file_path);
+    for (thread_index = 0; thread_index < threads_started; thread_index++)
+        pthread_join(threads[thread_index], NULL);
 
-    /* export materials */
-    iterator = material_list;
+    if (threads != NULL)
+        free(threads);
+    pthread_mutex_destroy(&batch->mutex);
+#else
+    /* no thread pool on this platform, jobs are run one after the other */
+    (void) threads_count;
+    batch_worker(batch);
+#endif
 
-    while (iterator != NULL)
-        {
-            if (iterator->data != NULL)
-                {
-                    fprintf(output_material_file, "\nnewmtl %s\n", ((solid_material_t *)iterator->data)->name);
-                    /* ambient color */
-                    fprintf(output_material_file, "Ka 1.0 1.0 1.0\n");
-                    /* diffuse color */
-                    fprintf(output_material_file, "Kd %f %f %f\n",
-                            ((solid_material_t *)iterator->data)->r,
-                            ((solid_material_t *)iterator->data)->g,
-                            ((solid_material_t *)iterator->data)->b
-                           );
-
-                    /* specular color */
-                    fprintf(output_material_file, "Ks 0.0 0.0 0.0\n");
-                    fprintf(output_material_file, "Ns 0.0\n");
-                }
-            iterator = iterator->next;
-        }
+    return batch->failed_count;
+}
 
-    fclose(output_material_file);
+/* number of processors available to run the jobs */
+int processors_count(void)
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
 
-    /* free data */
-    free(current_material);
-    list_free(material_list, 1);
+    if (count > 0)
+        return (int) count;
+#endif
+    return 1;
 }
 
-/* convert an obj mesh to a solid one */
-void obj_mesh_convert_to_solid(obj_mesh_t *obj_mesh, char *solid_file_path)
+/* batch mode : convert many files in a single process */
+int batch_main(int argc, char *argv[])
 {
-    FILE *output_file = NULL;
-    obj_material_t *current_material = NULL;
-    int vertex_index = 0;
-    int face_index = 0;
-    short vertices_count = 0;
-    short faces_count = 0;
-    short pad = 0;
-    short vertex_index_short = 0;
-    float color = 0.0f;
-    float vertex_coordinate = 0.0f;
-
-    if (obj_mesh == NULL)
+    batch_t batch;
+    conversion_stats_t stats;
+    char *output_directory = NULL;
+    char *end = NULL;
+    long value = 0;
+    int stats_output = STATS_OUTPUT_NONE;
+    int threads_count = 0;
+    int argument_index = 0;
+    int option_length = 0;
+    int failed_count = 0;
+    int up_to_date_count = 0;
+    int job_index = 0;
+    int write_failed = 0;
+
+    batch_init(&batch);
+
+    /* options first, so that they apply to every input whatever their position */
+    for (argument_index = 2; argument_index < argc; argument_index++)
         {
-            printf("Error : obj mesh is NULL in function obj_mesh_convert_to_solid !\n");
-            return;
+            option_length = conversion_option_parse(argc, argv, argument_index, &batch.options);
+            if (option_length < 0)
+                {
+                    batch_free(&batch);
+                    return 1;
+                }
+            else if (option_length > 0)
+                argument_index += option_length - 1;
+            else if (stats_option_parse(argv[argument_index], &stats_output))
+                continue;
+            else if (strcmp(argv[argument_index], "-j") == 0)
+                {
+                    end = NULL;
+                    if (argument_index + 1 < argc)
+                        value = strtol(argv[argument_index + 1], &end, 10);
+                    if (end == NULL || end == argv[argument_index + 1] || *end != '\0' || value < 1 || value > 1024)
+                        {
+                            printf("Error : -j needs a number of threads between 1 and 1024 !\n");
+                            batch_free(&batch);
+                            return 1;
+                        }
+                    threads_count = (int) value;
+                    argument_index++;
+                }
+            else if (strcmp(argv[argument_index], "-o") == 0 && argument_index + 1 < argc)
+                output_directory = argv[++argument_index];
+            else if (strcmp(argv[argument_index], "-l") == 0 && argument_index + 1 < argc)
+                argument_index++;
+            else if (strcmp(argv[argument_index], "-m") == 0 && argument_index + 1 < argc)
+                batch.build_manifest_path = argv[++argument_index];
+            else if (strcmp(argv[argument_index], "-P") == 0 && argument_index + 1 < argc)
+                batch.pack_path = argv[++argument_index];
         }
 
-    /* Check sizes */
-    if (obj_mesh->vertices_used > (BLACK_SHADES_MAX_VERTICES) || obj_mesh->faces_used > (BLACK_SHADES_MAX_FACES))
+    for (argument_index = 2; argument_index < argc; argument_index++)
         {
-            printf("Warning : more than %d vertices or than %d faces may not be supported in the current state of Black Shades !\n", BLACK_SHADES_MAX_VERTICES, BLACK_SHADES_MAX_FACES);
+            option_length = conversion_option_parse(argc, argv, argument_index, &batch.options);
+            if (option_length > 0)
+                argument_index += option_length - 1;
+            else if (stats_option_parse(argv[argument_index], &stats_output))
+                continue;
+            else if ((strcmp(argv[argument_index], "-j") == 0 || strcmp(argv[argument_index], "-o") == 0 || strcmp(argv[argument_index], "-m") == 0
+                      || strcmp(argv[argument_index], "-P") == 0) && argument_index + 1 < argc)
+                argument_index++;
+            else if (strcmp(argv[argument_index], "-l") == 0 && argument_index + 1 < argc)
+                batch_add_manifest(&batch, argv[++argument_index], output_directory);
+            else
+                batch_add_input(&batch, argv[argument_index], output_directory);
         }
 
-    /* open solid output file for writing in binary mode */
-    output_file = fopen(solid_file_path, "wb");
-    if (output_file == NULL)
+    /* a batch run twice on a directory finds the solid files of the first run next to their obj files (packs are written aside) */
+    if (batch.pack_path == NULL && !batch_skip_overwriting_jobs(&batch))
         {
-            printf("Error : can't open '%s' for writing !\n", solid_file_path);
-            return;
+            batch_free(&batch);
+            return 1;
         }
 
-    printf("vertices = %d\n", obj_mesh->vertices_used);
-    printf("faces = %d\n", obj_mesh->faces_used);
-    vertices_count = obj_mesh->vertices_used;
-    faces_count = 0;
-    /* we recount the faces as some of them may be quads (they count for two tri faces) */
-    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+    if (batch.jobs_used == 0)
         {
-            if (obj_mesh->faces[face_index].is_quad)
-                {
-                    faces_count+=2;
-                }
-            else
-                {
-                    faces_count++;
-                }
+            printf("Error : no obj or solid file to convert !\n");
+            batch_free(&batch);
+            return 1;
         }
-    solid_write_short(output_file, 1, &vertices_count);
-    solid_write_short(output_file, 1, &faces_count);
 
-    for (vertex_index = 0; vertex_index < obj_mesh->vertices_used; vertex_index++)
+    /* a pack is written whole, from obj or solid files only, and holds no bounds and normals files */
+    if (batch.pack_path != NULL && (batch.build_manifest_path != NULL || batch.packs_used > 0 || batch.options.compute_normals))
         {
-            solid_write_float(output_file, 1, &obj_mesh->vertices[vertex_index].x);
-            /* swap vectors (Z is the up vector in blender) */
-            vertex_coordinate = obj_mesh->vertices[vertex_index].z;
-            solid_write_float(output_file, 1, &vertex_coordinate);
-            vertex_coordinate = -1 * obj_mesh->vertices[vertex_index].y;
-            solid_write_float(output_file, 1, &vertex_coordinate);
+            printf("Error : -P can't be used with -m, -n or with packs as inputs !\n");
+            batch_free(&batch);
+            return 1;
         }
-
-    pad = 0;
-    color = 0.0f;
-    for (face_index = 0; face_index < obj_mesh->faces_used; face_index++)
+    if (batch.pack_path != NULL && !batch_skip_duplicate_pack_names(&batch))
         {
-            /* get the matching material */
-            current_material = obj_get_material_by_name(obj_mesh, obj_mesh->faces[face_index].texture_name);
-
-            /* TRI */
-            if (obj_mesh->faces[face_index].is_quad == 0)
-                {
-                    /* vertices indexes */
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[0] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
-
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[1] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
-
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[2] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
-
-                    /* padding */
-                    solid_write_short(output_file, 1, &pad);
-
-                    /* color */
-                    if (current_material != NULL)
-                        {
-                            solid_write_float(output_file, 1, &current_material->diffuse_r);
-                            solid_write_float(output_file, 1, &current_material->diffuse_g);
-                            solid_write_float(output_file, 1, &current_material->diffuse_b);
-
-                        }
-                    else
-                        {
-                            solid_write_float(output_file, 1, &color);
-                            solid_write_float(output_file, 1, &color);
-                            solid_write_float(output_file, 1, &color);
-                        }
-                }
-            else
-                {
-                    /* QUAD */
-
-                    /* quads have to be divided in two triangles */
-
-                    /* vertices indexes */
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[0] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
-
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[1] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
-
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[2] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
-
-                    /* padding */
-                    solid_write_short(output_file, 1, &pad);
-
-                    /* color */
-                    if (current_material != NULL)
-                        {
-                            solid_write_float(output_file, 1, &current_material->diffuse_r);
-                            solid_write_float(output_file, 1, &current_material->diffuse_g);
-                            solid_write_float(output_file, 1, &current_material->diffuse_b);
-
-                        }
-                    else
-                        {
-                            solid_write_float(output_file, 1, &color);
-                            solid_write_float(output_file, 1, &color);
-                            solid_write_float(output_file, 1, &color);
-                        }
+            batch_free(&batch);
+            return 1;
+        }
 
-                    /* vertices indexes */
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[2] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
+    if (batch.build_manifest_path != NULL && !build_manifest_load(&batch, batch.build_manifest_path))
+        {
+            batch_free(&batch);
+            return 1;
+        }
 
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[1] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
+    if (threads_count <= 0)
+        threads_count = processors_count();
 
-                    vertex_index_short = obj_mesh->faces[face_index].vertex_index[3] - 1;
-                    solid_write_short(output_file, 1, &vertex_index_short);
+    /* the main thread is a worker too */
+    stats_start(&stats, stats_output);
+    failed_count = batch_run(&batch, threads_count - 1);
+    if (batch.pack_path != NULL && !batch_write_pack(&batch))
+        {
+            /* nothing has been written */
+            write_failed = 1;
+            failed_count = batch.jobs_used;
+        }
+    stats_stop(&stats, stats_output);
 
-                    /* padding */
-                    solid_write_short(output_file, 1, &pad);
+    /* once every worker is done with the cache */
+    if (batch.options.cache_directory != NULL)
+        obj_mesh_cache_trim(batch.options.cache_directory, OBJ_MESH_CACHE_MAX_SIZE);
 
-                    /* color */
-                    if (current_material != NULL)
-                        {
-                            solid_write_float(output_file, 1, &current_material->diffuse_r);
-                            solid_write_float(output_file, 1, &current_material->diffuse_g);
-                            solid_write_float(output_file, 1, &current_material->diffuse_b);
-
-                        }
-                    else
-                        {
-                            solid_write_float(output_file, 1, &color);
-                            solid_write_float(output_file, 1, &color);
-                            solid_write_float(output_file, 1, &color);
-                        }
-                }
+    if (batch.build_manifest_path != NULL)
+        {
+            for (job_index = 0; job_index < batch.jobs_used; job_index++)
+                up_to_date_count += batch.jobs[job_index].up_to_date;
+            printf("%d file(s) converted, %d up to date, %d failed\n", batch.jobs_used - failed_count - up_to_date_count, up_to_date_count, failed_count);
+            if (!build_manifest_write(&batch))
+                write_failed = 1;
         }
+    else
+        {
+            printf("%d file(s) converted, %d failed\n", batch.jobs_used - failed_count, failed_count);
+        }
+    batch_free(&batch);
 
-    fclose(output_file);
+    return (failed_count > 0 || write_failed) ? 2 : 0;
 }
 
 /* print usage of the command */
@@ -1056,274 +1353,151 @@ void usage(char *command_name)
             "\n"
             "[solid->obj] (with 3 args)\n"
             "\n"
-            "\t%s <input_solid_file> <output_obj_file> <output_mtl_file>\n"
+            "\t%s [--stats[=json]] [-p <decimals>] [-t <threads> | -s] [-n] <input_solid_file> <output_obj_file> <output_mtl_file>\n"
             "\n"
             "\tinput_solid_file \t:\ta valid solid mesh file\n"
             "\toutput_obj_file \t:\tname of the output obj file to create\n"
             "\toutput_mtl_file \t:\tname of the output material file to create\n"
+            "\t-p decimals\t\t:\twrite floats with this number of decimals (0 to 12, like printf \"%%.*f\")\n"
+            "\t\t\t\t\tinstead of the shortest text reading back as the same float\n"
+            "\t-t threads\t\t:\tthreads formatting the obj file (default : number of processors)\n"
+            "\t-s\t\t\t:\tstream the conversion %d vertices or triangles at a time instead of loading the whole mesh\n"
+            "\t-n\t\t\t:\twrite the normals of the vertices (vn lines) and the bounds of the mesh (comments)\n"
             "\n"
             "\t! WARNING output files WILL be OVERWRITTEN !\n"
             "\n"
             "[obj->solid] (with 2 args)\n"
             "\n"
-            "\t%s <input_obj_file> <output_solid_file>\n"
+            "\t%s [--stats[=json]] [-t <threads>] [-w <distance>] [-c] [-d | -D <triangles>] [-f <solid_format>] [-C <cache_directory>] [-n] <input_obj_file> <output_solid_file>\n"
             "\n"
             "\tinput_obj_file\t\t:\ta valid obj mesh file\n"
             "\toutput_solid_file\t:\tname of the output solid file to create\n"
+            "\t-t threads\t\t:\tthreads parsing the obj file (default : number of processors)\n"
+            "\t-w distance\t\t:\tmerge the vertices closer than this distance (0 for exact duplicates)\n"
+            "\t-c\t\t\t:\treorder triangles and vertices for the vertex cache of the graphics card\n"
+            "\t-d\t\t\t:\tdecimate the mesh to the Black Shades limits (%d triangles, %d vertices)\n"
+            "\t-D triangles\t\t:\tdecimate the mesh to this number of triangles\n"
+            "\t-f solid_format\t\t:\t%d for the solid files Black Shades reads (default), %d for compact ones (quantized, see README)\n"
+            "\t-C cache_directory\t:\tkeep the parsed meshes there, unchanged obj and mtl files are not parsed again\n"
+            "\t-n\t\t\t:\twrite the bounds and normals of the solid file next to it (output_solid_file" SOLID_GEOMETRY_EXTENSION ")\n"
             "\n"
             "\t! WARNING output file WILL be OVERWRITTEN !\n"
             "\n"
-            , command_name, command_name);
+            "[batch] (obj->solid or solid->obj depending on the extension of each file)\n"
+            "\n"
+            "\t%s --batch [--stats[=json]] [-p <decimals>] [-t <threads>] [-s] [-w <distance>] [-c] [-d | -D <triangles>] [-f <solid_format>] [-C <cache_directory>] [-n] [-j <threads>] [-o <output_directory>] [-l <list_file>] [-m <build_manifest> | -P <pack_file>] <input_file_or_directory_or_pack> ...\n"
+            "\n"
+            "\t-t threads\t\t:\tthreads parsing or formatting each obj file (default : 1)\n"
+            "\t-s\t\t\t:\tsame as above, for the obj files created\n"
+            "\t-n\t\t\t:\tsame as above, for the obj and solid files created\n"
+            "\t-w, -c, -d, -D, -f, -C\t:\tsame as above, for the solid files created\n"
+            "\t-j threads\t\t:\tnumber of files converted at the same time (default : number of processors)\n"
+            "\t-o output_directory\t:\tdirectory of the files created (default : next to each input file)\n"
+            "\t-l list_file\t\t:\tfile listing the inputs, one file or directory per line\n"
+            "\t-m build_manifest\t:\tskip the files whose inputs and options have not changed since the manifest was written\n"
+            "\t-P pack_file\t\t:\tput the solid files made from the obj files, and the solid files given, in a single compressed pack\n"
+            "\n"
+            "\tdirectories are searched (not recursively) for .obj and .solid files, every solid file of a .pack file is converted to obj\n"
+            "\n"
+            "[all modes]\n"
+            "\n"
+            "\t--stats\t\t\t:\tprint the time spent in each stage and counters on stderr once done (a table)\n"
+            "\t--stats=json\t\t:\tsame as --stats, as JSON\n"
+            "\n"
+            "\t! WARNING output files WILL be OVERWRITTEN !\n"
+            "\n"
+            , command_name, SOLID_STREAM_WINDOW_SIZE, command_name, BLACK_SHADES_MAX_FACES, BLACK_SHADES_MAX_VERTICES, SOLID_FORMAT_V1, SOLID_FORMAT_V2, command_name);
 }
 
 int main(int argc, char *argv[])
 {
+    char *command_name = argv[0];
+    conversion_options_t options;
+    conversion_stats_t stats;
+    solid_arena_t arena;
+    int stats_output = STATS_OUTPUT_NONE;
+    int argument_index = 1;
+    int option_length = 0;
+    int result = 0;
+
     /* path to the input and output mesh files */
     char solid_file_path[1024];
     char obj_file_path[1024];
     char obj_material_file_path[1024];
 
-    /* obj file line buffer */
-    char obj_line_buffer[1024];
-
-    /* obj file key */
-    char obj_key[255];
-
-    /* obj current material name */
-    char obj_current_material_name[1024];
-
-    /* solid mesh file handle */
-    FILE *solid_file = NULL;
-
-    /* obj mesh file handle */
-    FILE *obj_file = NULL;
-
-    /* obj material file handle */
-    FILE *obj_material_file = NULL;
-
-    /* solid mesh */
-    solid_mesh_t *solid_mesh = NULL;
-
-    /* obj mesh */
-    obj_mesh_t *obj_mesh = NULL;
-
-    /* obj vertex */
-    obj_vertex_t *obj_vertex = NULL;
-
-    /* obj face */
-    obj_face_t *obj_face = NULL;
-
-    /* obj material */
-    obj_material_t *obj_material = NULL;
-
-    /* number of vertices to read from the solid file */
-    short vertex_count = 0;
-    /* number of triangles to read from the solid file */
-    short triangle_count = 0;
-
     /* initialize paths with '\0' */
     memset(solid_file_path, '\0', 1024);
     memset(obj_file_path, '\0', 1024);
     memset(obj_material_file_path, '\0', 1024);
 
-    /* init obj file line buffer */
-    memset(obj_line_buffer, '\0', 1024);
-
-    /* init obj file key */
-    memset(obj_key, '\0', 255);
-
-    /* init current material name */
-    memset(obj_current_material_name, '\0', 1024);
+    /* a single big obj file is parsed on all the processors */
+    conversion_options_init(&options);
+    options.threads_count = processors_count();
 
     /* if files are specified at command line */
-    if (argc == 3) /* OBJ to SOLID mode */
+    if (argc >= 2 && strcmp(argv[1], "--batch") == 0) /* BATCH mode */
         {
-            /* copy files names into corresponding arrays */
-            strncpy(obj_file_path, argv[1], 1024);
-            strncpy(solid_file_path, argv[2], 1024);
-            /* note : material file name will be extracted from the obj file */
-
-
-            printf("loading '%s'...\n", obj_file_path);
-
-            /* create the obj mesh in memory */
-            obj_mesh = obj_mesh_create(obj_file_path);
+            return batch_main(argc, argv);
+        }
 
-            /* open obj file */
-            obj_file = fopen(obj_file_path, "r");
-            if (obj_file == NULL)
+    /* options come before the files */
+    while (argument_index < argc)
+        {
+            if (stats_option_parse(argv[argument_index], &stats_output))
                 {
-                    printf("can't load file '%s' !\n", obj_file_path);
-                    exit(2);
+                    argument_index++;
+                    continue;
                 }
+            option_length = conversion_option_parse(argc, argv, argument_index, &options);
+            if (option_length == 0)
+                break;
+            if (option_length < 0)
+                exit(1);
+            argument_index += option_length;
+        }
+    argc -= argument_index - 1;
+    argv += argument_index - 1;
 
-            /* parse obj file */
-            while ( fgets(obj_line_buffer, 1024, obj_file) != NULL)
-                {
-                    sscanf(obj_line_buffer, "%s%*[^\n]", obj_key);
-
-                    /* vertex line */
-                    if (strcmp(obj_key, "v") == 0)
-                        {
-                            obj_vertex = obj_add_vertex(obj_mesh);
-                            if (obj_vertex != NULL)
-                                {
-                                    obj_vertex->x = 0;
-                                    obj_vertex->y = 0;
-                                    obj_vertex->z = 0;
-                                    obj_vertex->w = 0;
-                                    sscanf(obj_line_buffer, "v %f %f %f %f", &(obj_vertex->x), &(obj_vertex->y), &(obj_vertex->z), &(obj_vertex->w));
-                                }
-                        }
-                    /* face line */
-                    else if (strcmp(obj_key, "f") == 0)
-                        {
-                            obj_face = obj_read_face(obj_line_buffer, obj_mesh);
-                            if (strlen(obj_current_material_name) > 0)
-                                {
-                                    strncpy(obj_face->texture_name, obj_current_material_name, 1024);
-                                }
-                        }
-                    /* use material */
-                    else if (strcmp(obj_key, "usemtl") == 0)
-                        {
-                            sscanf(obj_line_buffer, "usemtl %s", obj_current_material_name);
-                        }
-                    /* comment */
-                    else if (strcmp(obj_key, "#") == 0)
-                        {
-
-                        }
-                    /* material file */
-                    else if (strcmp(obj_key, "mtllib") == 0)
-                        {
-                            sscanf(obj_line_buffer, "mtllib %s", obj_material_file_path);
-                        }
-                }
-
-            /* close obj file */
-            fclose(obj_file);
-
-
-            /* has a MTL (material) file been declared in the obj file ? (mtllib directive ?) */
-            if (strlen(obj_material_file_path)>0)
-                {
-                    obj_material_file = fopen(obj_material_file_path, "r");
-                    if (obj_material_file == NULL)
-                        {
-                            printf("Error : can't open material file '%s' for reading !/n", obj_material_file_path);
-                        }
-                    else
-                        {
-                            obj_material = NULL;
-                            /* parse material file */
-                            while ( fgets(obj_line_buffer, 1024, obj_material_file) != NULL)
-                                {
-                                    sscanf(obj_line_buffer, "%s%*[^\n]", obj_key);
-                                    if (strcmp(obj_key, "newmtl") == 0)
-                                        {
-                                            obj_material = obj_add_material(obj_mesh);
-                                            sscanf(obj_line_buffer, "newmtl %s", obj_material->name);
-                                            obj_material->ambient_r = 0.0f;
-                                            obj_material->ambient_g = 0.0f;
-                                            obj_material->ambient_b = 0.0f;
-                                            obj_material->diffuse_r = 0.0f;
-                                            obj_material->diffuse_g = 0.0f;
-                                            obj_material->diffuse_b = 0.0f;
-                                            obj_material->specular_r = 0.0f;
-                                            obj_material->specular_g = 0.0f;
-                                            obj_material->specular_b = 0.0f;
-                                            obj_material->specular_coefficient = 0.0f;
-                                        }
-                                    else if (strcmp(obj_key, "Ka") == 0)
-                                        {
-                                            if (obj_material != NULL)
-                                                {
-                                                    sscanf(obj_line_buffer, "Ka %f %f %f", &(obj_material->ambient_r), &(obj_material->ambient_g), &(obj_material->ambient_b));
-                                                }
-                                        }
-                                    else if (strcmp(obj_key, "Kd") == 0)
-                                        {
-                                            if (obj_material != NULL)
-                                                {
-                                                    sscanf(obj_line_buffer, "Kd %f %f %f", &(obj_material->diffuse_r), &(obj_material->diffuse_g), &(obj_material->diffuse_b));
-                                                }
-                                        }
-                                    else if (strcmp(obj_key, "Ks") == 0)
-                                        {
-                                            if (obj_material != NULL)
-                                                {
-                                                    sscanf(obj_line_buffer, "Ks %f %f %f", &(obj_material->specular_r), &(obj_material->specular_g), &(obj_material->specular_b));
-                                                }
-                                        }
-                                    else if (strcmp(obj_key, "Ns") == 0)
-                                        {
-                                            if (obj_material != NULL)
-                                                {
-                                                    sscanf(obj_line_buffer, "Ka %f", &(obj_material->specular_coefficient));
-                                                }
-                                        }
-                                }
-
-                            fclose(obj_material_file);
-                        }
-                }
+    /* the meshes are given back all at once at the end */
+    solid_arena_init(&arena);
+    solid_arena_set_current(&arena);
 
-            /* create solid file */
-            printf("creating solid file...\n");
-            obj_mesh_convert_to_solid(obj_mesh, solid_file_path);
-            printf("...done !\n");
+    if (argc == 3) /* OBJ to SOLID mode */
+        {
+            /* copy files names into corresponding arrays */
+            strncpy(obj_file_path, argv[1], 1023);
+            strncpy(solid_file_path, argv[2], 1023);
+            /* note : material file name will be extracted from the obj file */
 
-            /* free data */
-            obj_mesh_free(obj_mesh);
+            stats_start(&stats, stats_output);
+            result = convert_obj_file_to_solid(obj_file_path, solid_file_path, &options);
+            stats_stop(&stats, stats_output);
+            if (options.cache_directory != NULL)
+                obj_mesh_cache_trim(options.cache_directory, OBJ_MESH_CACHE_MAX_SIZE);
+            if (!result)
+                exit(2);
         }
     else if (argc == 4) /* SOLID to OBJ mode */
         {
             /* copy files names into corresponding arrays */
-            strncpy(solid_file_path, argv[1], 1024);
-            strncpy(obj_file_path, argv[2], 1024);
-            strncpy(obj_material_file_path, argv[3], 1024);
-
-            printf("loading '%s'...\n", solid_file_path);
-
-            /* opening the file in binary mode */
-            solid_file = fopen(solid_file_path, "rb");
-            if (solid_file == NULL)
-                {
-                    printf("can't load file '%s' !\n", solid_file_path);
-                    exit(2);
-                }
-
-            /* read vertices count in solid file */
-            solid_read_short(solid_file, 1, &vertex_count);
-            printf("%d vertices to read\n", vertex_count);
-
-            /* read triangles count in solid file */
-            solid_read_short(solid_file, 1, &triangle_count);
-            printf("%d triangles to read\n", triangle_count);
-
-            /* allocate memory for the solid mesh */
-            solid_mesh = solid_mesh_create(solid_file_path, vertex_count, triangle_count);
-
-            /* fill the solid mesh from file */
-            solid_read_XYZ(solid_file, vertex_count, solid_mesh->vertices);
-            solid_read_textured_triangle(solid_file, triangle_count, solid_mesh->triangles);
-
-            fclose(solid_file);
-
-            /* create obj file */
-            printf("creating obj file...\n");
-            solid_mesh_convert_to_obj(solid_mesh, obj_file_path, obj_material_file_path);
-            printf("...done !\n");
-
-            /* free data */
-            solid_mesh_free(solid_mesh);
+            strncpy(solid_file_path, argv[1], 1023);
+            strncpy(obj_file_path, argv[2], 1023);
+            strncpy(obj_material_file_path, argv[3], 1023);
+
+            stats_start(&stats, stats_output);
+            result = convert_solid_file_to_obj(solid_file_path, obj_file_path, obj_material_file_path, &options);
+            stats_stop(&stats, stats_output);
+            if (!result)
+                exit(2);
         }
     else
         {
-            usage(argv[0]);
+            usage(command_name);
             exit(1);
         }
+
+    solid_arena_set_current(NULL);
+    solid_arena_free(&arena);
     return 0;
 }
 
@@ -0,0 +1,449 @@
+/*
+    solid2obj
+    Copyright (C) 2013 melchips (Francois Truphemus : francois (at) truphemus (dot) fr)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLID2OBJ_H
+#define SOLID2OBJ_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BLACK_SHADES_MAX_FACES 400
+#define BLACK_SHADES_MAX_VERTICES BLACK_SHADES_MAX_FACES*3
+
+/* most decimals of the floats in obj and mtl files (float_precision of conversion_options_t) */
+#define TEXT_FLOAT_MAX_PRECISION 12
+
+/* vertices or triangles held at a time by default when a solid file is converted without loading it (stream_window_size of conversion_options_t) */
+#define SOLID_STREAM_WINDOW_SIZE 4096
+
+/* formats of the solid files written (see conversion_options_t) */
+#define SOLID_FORMAT_V1 1
+#define SOLID_FORMAT_V2 2
+
+/* packs of solid files (little endian) : header (magic, version, entries count, size of the names, offset of the data), index sorted
+   by name (name offset and length, data offset, stored size, size and hash_xxh64 of each entry), names (nul terminated), data */
+#define SOLID_PACK_MAGIC "S2OPACK"
+#define SOLID_PACK_VERSION 1
+#define SOLID_PACK_HEADER_SIZE 32
+#define SOLID_PACK_ENTRY_SIZE 32
+#define SOLID_PACK_MAX_NAME 256
+
+/* file written next to a solid file with its bounds and normals (compute_normals of conversion_options_t) */
+#define SOLID_GEOMETRY_EXTENSION ".geometry"
+
+/* stages of a conversion timed by the statistics (a thread is in a single stage at a time, STATS_STAGE_NONE outside of them) */
+#define STATS_STAGE_NONE (-1)
+#define STATS_STAGE_OPEN 0
+#define STATS_STAGE_READ 1
+#define STATS_STAGE_PARSE 2
+#define STATS_STAGE_DEDUP 3
+#define STATS_STAGE_OPTIMIZE 4
+#define STATS_STAGE_NORMALS 5
+#define STATS_STAGE_FORMAT 6
+#define STATS_STAGE_WRITE 7
+#define STATS_STAGES_COUNT 8
+
+/* keywords of the obj and mtl lines counted by the statistics */
+#define STATS_KEYWORD_V 0
+#define STATS_KEYWORD_VT 1
+#define STATS_KEYWORD_VN 2
+#define STATS_KEYWORD_F 3
+#define STATS_KEYWORD_USEMTL 4
+#define STATS_KEYWORD_MTLLIB 5
+#define STATS_KEYWORD_NEWMTL 6
+#define STATS_KEYWORD_KD 7
+#define STATS_KEYWORD_OTHER 8
+#define STATS_KEYWORDS_COUNT 9
+
+/* smallest block allocated by an arena and alignment of the memory it gives */
+#define SOLID_ARENA_BLOCK_SIZE (1 << 20)
+#define SOLID_ARENA_ALIGNMENT 16
+
+/* size the command trims its mesh cache directory to once done */
+#define OBJ_MESH_CACHE_MAX_SIZE (256 << 20)
+
+/* block of memory of an arena (its memory follows the header, aligned on SOLID_ARENA_ALIGNMENT) */
+typedef struct _solid_arena_block
+{
+    struct _solid_arena_block *next;
+    size_t size;
+    size_t used;
+} solid_arena_block_t;
+
+/* memory of a conversion given block after block and taken back all at once (see solid_arena_set_current) */
+typedef struct _solid_arena
+{
+    solid_arena_block_t *first;
+    solid_arena_block_t *current; /* the blocks after it are empty */
+    unsigned char *last_allocation; /* grown in place by solid_arena_realloc when its block has room */
+} solid_arena_t;
+
+/* solid file vertex 3d coordinates structure */
+typedef struct _solid_XYZ
+{
+    float x, y, z;
+} solid_XYZ_t;
+
+/* solid file textured triangle (colored triangle) structure */
+typedef struct _solid_textured_triangle
+{
+    short vertex[3];
+    float r, g, b;
+} solid_textured_triangle_t;
+
+/* solid file mesh structure */
+typedef struct _solid_mesh
+{
+    char filename[1024];
+    short vertex_count;
+    short triangle_count;
+    solid_XYZ_t *vertices;
+    solid_textured_triangle_t *triangles;
+    solid_arena_t *arena; /* arena holding the mesh, NULL if it has been allocated with malloc */
+} solid_mesh_t;
+
+/* normals and bounding volumes of a solid mesh (see solid_mesh_geometry_compute) */
+typedef struct _solid_mesh_geometry
+{
+    int vertex_count;
+    int triangle_count;
+    solid_XYZ_t *vertex_normals; /* average of the normals of the triangles around each vertex weighted by their area (0 if it has none) */
+    solid_XYZ_t *face_normals; /* normal of each triangle (0 if it is degenerate or uses vertices out of range) */
+    solid_XYZ_t bounds_min; /* box holding all the vertices (0 for a mesh without vertices) */
+    solid_XYZ_t bounds_max;
+    solid_XYZ_t sphere_center; /* sphere holding all the vertices, centered on the box */
+    float sphere_radius;
+    solid_arena_t *arena; /* arena holding the normals, NULL if they have been allocated with malloc */
+} solid_mesh_geometry_t;
+
+/* solid file material structure */
+typedef struct _solid_material
+{
+    char name[1024];
+    int id;
+    float r, g, b;
+} solid_material_t;
+
+/* vertex in obj file */
+typedef struct _obj_vextex
+{
+    float x, y, z, w;
+} obj_vertex_t;
+
+/* material in obj file */
+typedef struct _obj_material
+{
+    char name[1024];
+    float ambient_r, ambient_g, ambient_b;
+    float diffuse_r, diffuse_g, diffuse_b;
+    float specular_r, specular_g, specular_b;
+    float specular_coefficient;
+} obj_material_t;
+
+/* obj file mesh structure (faces of any size are stored as arrays of corners) */
+typedef struct _obj_mesh
+{
+    char filename[1024];
+    char material_filename[1024];
+    int vertices_used;
+    int vertices_allocated;
+    obj_vertex_t *vertices;
+    int faces_used;
+    int faces_allocated;
+    int *face_offsets; /* face i uses the corners face_offsets[i] to face_offsets[i + 1] - 1 (faces_used + 1 entries) */
+    int *face_materials; /* index in materials of each face or -1 */
+    int corners_used;
+    int corners_allocated;
+    int *corner_vertices; /* vertex index of each corner (starting at 1 as in the obj file) */
+    int *corner_textures; /* texture index of each corner or 0, NULL until a face declares one */
+    int *corner_normals; /* normal index of each corner or 0, NULL until a face declares one */
+    int materials_used;
+    int materials_allocated;
+    obj_material_t *materials;
+    int material_slots_count; /* always a power of two */
+    int *material_slots; /* material names hash table (index in materials or -1 if the slot is free) */
+    solid_arena_t *arena; /* arena holding the mesh and its arrays, NULL if they have been allocated with malloc */
+} obj_mesh_t;
+
+/* file content mapped (or read) in memory */
+typedef struct _mapped_file
+{
+    char *data;
+    size_t size;
+    int is_mapped;
+    long long time; /* modification time in seconds when it was opened */
+} mapped_file_t;
+
+/* size, modification time and content of a file read by a conversion */
+typedef struct _solid_file_state
+{
+    int found; /* 0 if the file could not be read (nothing else is set) */
+    uint64_t size;
+    long long time; /* modification time in seconds */
+    uint64_t hash; /* mapped_file_hash of the content */
+} solid_file_state_t;
+
+/* growable byte buffer (files are formatted in memory and written at once) */
+typedef struct _solid_buffer
+{
+    unsigned char *data;
+    size_t used;
+    size_t allocated;
+} solid_buffer_t;
+
+/* options of a conversion (see conversion_options_init for the defaults) */
+typedef struct _conversion_options
+{
+    int float_precision; /* decimals of the floats in obj and mtl files, -1 for the shortest text reading back as the same float */
+    int threads_count; /* threads used to parse an obj file or to format one (1 to do it sequentially) */
+    float weld_epsilon; /* obj vertices closer than this are merged before writing a solid file (0 for exact duplicates only, negative to keep them all) */
+    int optimize_vertex_cache; /* reorder triangles and vertices for the vertex cache before writing a solid file */
+    int decimation_faces; /* triangles left by the decimation before writing a solid file (0 for no limit) */
+    int decimation_vertices; /* vertices left by the decimation before writing a solid file (0 for no limit, no decimation if both are 0) */
+    int stream_window_size; /* vertices or triangles held at a time when converting a solid file without loading it (0 to load it whole) */
+    const char *cache_directory; /* directory keeping the parsed obj meshes to skip parsing unchanged obj and mtl files (NULL for no cache) */
+    int solid_format; /* format of the solid files written : SOLID_FORMAT_V1 (read by Black Shades) or SOLID_FORMAT_V2 (compact) */
+    int compute_normals; /* write the normals and bounds of the meshes : vn lines and bounds comments in obj files, a SOLID_GEOMETRY_EXTENSION file next to solid files */
+    char *material_file_path; /* if not NULL (1024 bytes), receives the path of the material file declared by the obj file read by convert_obj_file_to_solid
+                                 ("" if none, its name as declared if it is missing) */
+    solid_file_state_t *material_file_state; /* if not NULL, receives the state of the material file read by convert_obj_file_to_solid (not found if none) */
+} conversion_options_t;
+
+/* entry of a pack being written */
+typedef struct _solid_pack_writer_entry
+{
+    char name[SOLID_PACK_MAX_NAME];
+    size_t data_offset; /* in the data of the writer */
+    size_t stored_size; /* size once compressed, or the size if it is stored as it is */
+    size_t size;
+    uint64_t hash; /* hash_xxh64 of the file */
+} solid_pack_writer_entry_t;
+
+/* pack being written, files are compressed as they are added */
+typedef struct _solid_pack_writer
+{
+    int entries_used;
+    int entries_allocated;
+    solid_pack_writer_entry_t *entries;
+    solid_buffer_t data;
+} solid_pack_writer_t;
+
+/* pack opened for reading (mapped in memory, entries are found and extracted in place) */
+typedef struct _solid_pack
+{
+    mapped_file_t file;
+    int entries_count;
+    const unsigned char *index;
+    const char *names;
+    size_t names_size;
+} solid_pack_t;
+
+/* durations and counters of the conversions run while they are captured (see stats_set_capture) */
+typedef struct _conversion_stats
+{
+    uint64_t stage_nanoseconds[STATS_STAGES_COUNT]; /* summed over the threads, the time of a stage run inside another one is only counted once */
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t keyword_lines[STATS_KEYWORDS_COUNT]; /* blank lines and comments are counted as STATS_KEYWORD_OTHER */
+    uint64_t reallocs; /* growths of the arrays, buffers and hash tables */
+    uint64_t hash_probes; /* slots looked at in the hash tables of materials */
+    uint64_t cache_hits; /* obj meshes loaded from the mesh cache */
+    uint64_t cache_misses; /* obj meshes parsed although a mesh cache was given */
+} conversion_stats_t;
+
+/* set the default conversion options */
+void conversion_options_init(conversion_options_t *options);
+
+/* init an empty byte buffer */
+void solid_buffer_init(solid_buffer_t *buffer);
+
+/* free the memory used by a byte buffer */
+void solid_buffer_free(solid_buffer_t *buffer);
+
+/* append "size" bytes to a buffer and return where to store them (NULL on error) */
+unsigned char * solid_buffer_append(solid_buffer_t *buffer, size_t size);
+
+/* append formatted text to a buffer (returns 0 on error) */
+int solid_buffer_printf(solid_buffer_t *buffer, const char *format, ...);
+
+/* make sure "size" more bytes can be appended to a buffer and return where they go (NULL on error, "used" is not changed) */
+unsigned char * solid_buffer_reserve(solid_buffer_t *buffer, size_t size);
+
+/* capture the messages of the current thread in a buffer instead of printing them (NULL to print them again), returns the previous buffer */
+solid_buffer_t * report_set_capture(solid_buffer_t *buffer);
+
+/* set all the durations and counters of statistics to 0 */
+void conversion_stats_init(conversion_stats_t *stats);
+
+/* add the durations and counters of the conversions of every thread to "stats" (NULL to stop), returns the previous statistics */
+conversion_stats_t * stats_set_capture(conversion_stats_t *stats);
+
+/* write statistics as a table or as JSON (returns 0 on error) */
+int conversion_stats_format(const conversion_stats_t *stats, int as_json, solid_buffer_t *buffer);
+
+/* init an empty arena */
+void solid_arena_init(solid_arena_t *arena);
+
+/* free all the blocks of an arena */
+void solid_arena_free(solid_arena_t *arena);
+
+/* give back at once all the memory of an arena (its blocks are kept for the next conversion) */
+void solid_arena_reset(solid_arena_t *arena);
+
+/* allocate "size" bytes in an arena (NULL on error) */
+void * solid_arena_alloc(solid_arena_t *arena, size_t size);
+
+/* grow an allocation of an arena (in place if it is the last one and its block has room, big allocations are moved to a block of their own
+   grown with realloc, NULL on error) */
+void * solid_arena_realloc(solid_arena_t *arena, void *pointer, size_t old_size, size_t new_size);
+
+/* allocate the meshes and material tables created by the current thread in an arena (NULL to use malloc again), returns the previous arena */
+solid_arena_t * solid_arena_set_current(solid_arena_t *arena);
+
+/* arena of the current thread (NULL if there is none) */
+solid_arena_t * solid_arena_current(void);
+
+/* make sure a obj mesh array can hold at least "needed" elements (allocated in "arena" if it is not NULL) */
+int obj_array_reserve(solid_arena_t *arena, void **buffer, int *allocated, int needed, size_t element_size);
+
+/* create a new obj mesh in memory (in the arena of the current thread if it has one) */
+obj_mesh_t * obj_mesh_create(char *filename);
+
+/* free a obj mesh from memory */
+void obj_mesh_free(obj_mesh_t *obj_mesh);
+
+/* length of the directory part of a path (up to and including its last separator) */
+size_t path_directory_length(const char *path);
+
+/* open a file and map its whole content in memory (read only) */
+int mapped_file_open(mapped_file_t *mapped_file, const char *path);
+
+/* release a file opened with mapped_file_open */
+void mapped_file_close(mapped_file_t *mapped_file);
+
+/* hash of the content of a file opened with mapped_file_open (the one the mesh cache keys and checks files with) */
+uint64_t mapped_file_hash(const mapped_file_t *mapped_file);
+
+/* true if the material file of an obj file can be found where the conversions look for it (next to the obj file, then relatively to the current directory) */
+int obj_material_file_exists(const char *obj_file_path, const char *material_filename);
+
+/* parse the content of an obj file (data does not need to be null terminated) */
+int obj_mesh_parse(obj_mesh_t *obj_mesh, const char *data, size_t size);
+
+/* parse the content of an obj file split in newline aligned chunks on a pool of threads (same result as obj_mesh_parse) */
+int obj_mesh_parse_parallel(obj_mesh_t *obj_mesh, const char *data, size_t size, int threads_count);
+
+/* parse the content of a mtl file (data does not need to be null terminated) */
+int obj_mesh_parse_materials(obj_mesh_t *obj_mesh, const char *data, size_t size);
+
+/* append the whole content of a file to a buffer (returns 0 on error) */
+int solid_buffer_read_file(solid_buffer_t *buffer, const char *path);
+
+/* write the whole content of a buffer to a file at once */
+int solid_buffer_write_file(const solid_buffer_t *buffer, const char *path);
+
+/* create a new solid mesh in memory (in the arena of the current thread if it has one) */
+solid_mesh_t *solid_mesh_create(char *filename, short vertex_count, short triangle_count);
+
+/* free a solid mesh from memory */
+void solid_mesh_free(solid_mesh_t *solid_mesh);
+
+/* decode a solid file held in memory (returns NULL if the data is not a valid solid file) */
+solid_mesh_t * solid_mesh_parse(char *filename, const unsigned char *data, size_t size);
+
+/* decode a compact solid file held in memory in a single pass into a solid mesh (self-contained reference loader, returns NULL on error) */
+solid_mesh_t * solid_mesh_parse_v2(char *filename, const unsigned char *data, size_t size);
+
+/* load a solid file (read in a single block or mapped) */
+solid_mesh_t * solid_mesh_load(char *path);
+
+/* init empty normals and bounds */
+void solid_mesh_geometry_init(solid_mesh_geometry_t *geometry);
+
+/* free the normals of a mesh and empty its bounds */
+void solid_mesh_geometry_free(solid_mesh_geometry_t *geometry);
+
+/* compute the face normals, the vertex normals (weighted by the area of the triangles) and the bounds of a solid mesh in a single pass over
+   its triangles and two over its vertices (the arrays go in the arena of the current thread if it has one, returns 0 on error) */
+int solid_mesh_geometry_compute(solid_mesh_geometry_t *geometry, const solid_mesh_t *solid_mesh);
+
+/* format an obj file and its mtl file into buffers ("material_name" is written as mtllib, options may be NULL, returns 0 on error) */
+int solid_mesh_serialize_obj(solid_mesh_t *solid_mesh, const char *obj_name, const char *material_name, const conversion_options_t *options, solid_buffer_t *obj_buffer, solid_buffer_t *material_buffer);
+
+/* convert a solid mesh to an obj one (options may be NULL, returns 0 on error) */
+int solid_mesh_convert_to_obj(solid_mesh_t *solid_mesh, char *output_file_path, char *output_material_file_path, const conversion_options_t *options);
+
+/* encode an obj mesh as a solid file in a buffer (returns 0 on error) */
+int obj_mesh_serialize_solid(obj_mesh_t *obj_mesh, solid_buffer_t *buffer);
+
+/* encode an obj mesh as a compact solid file in a buffer : 16 bits positions between the bounds of the mesh, 8 bits colors
+   in a palette of SOLID_V2_MAX_COLORS indexed by each triangle, little endian (returns 0 on error) */
+int obj_mesh_serialize_solid_v2(obj_mesh_t *obj_mesh, solid_buffer_t *buffer);
+
+/* convert an obj mesh to a solid one in the format of the options (options may be NULL, returns 0 on error) */
+int obj_mesh_convert_to_solid(obj_mesh_t *obj_mesh, char *solid_file_path, const conversion_options_t *options);
+
+/* remove the least recently used files of a mesh cache directory until it holds at most "max_size" bytes, and the temporary
+   files left by crashed writers (returns the number of files removed, -1 on error) */
+int obj_mesh_cache_trim(const char *directory, uint64_t max_size);
+
+/* load an obj file (and its mtl file) and encode it as a solid file in a buffer (options may be NULL, returns 0 on error) */
+int convert_obj_file_to_solid_buffer(char *obj_file_path, solid_buffer_t *solid_buffer, const conversion_options_t *options);
+
+/* load an obj file (and its mtl file) and write it as a solid file (options may be NULL, returns 0 on error) */
+int convert_obj_file_to_solid(char *obj_file_path, char *solid_file_path, const conversion_options_t *options);
+
+/* load a solid file and write it as an obj file and its mtl file (options may be NULL, returns 0 on error) */
+int convert_solid_file_to_obj(char *solid_file_path, char *obj_file_path, char *obj_material_file_path, const conversion_options_t *options);
+
+/* init an empty pack to write */
+void solid_pack_writer_init(solid_pack_writer_t *writer);
+
+/* free the entries of a pack being written */
+void solid_pack_writer_free(solid_pack_writer_t *writer);
+
+/* compress a file into a pack being written (its name must be shorter than SOLID_PACK_MAX_NAME and unique, returns 0 on error) */
+int solid_pack_writer_add(solid_pack_writer_t *writer, const char *name, const unsigned char *data, size_t size);
+
+/* write a pack : header, index sorted by name, names, then the data of the entries (returns 0 on error) */
+int solid_pack_writer_write(solid_pack_writer_t *writer, const char *path);
+
+/* open a pack for reading : it is mapped in memory and its index is checked once for all (returns 0 on error) */
+int solid_pack_open(solid_pack_t *pack, const char *path);
+
+/* release a pack opened with solid_pack_open */
+void solid_pack_close(solid_pack_t *pack);
+
+/* name of an entry of a pack */
+const char * solid_pack_entry_name(const solid_pack_t *pack, int entry_index);
+
+/* index of the entry of a pack with this name (binary search in the index, returns -1 if there is none) */
+int solid_pack_find(const solid_pack_t *pack, const char *name);
+
+/* decompress an entry of a pack at the end of a buffer, straight from the mapped file (returns 0 if it is damaged) */
+int solid_pack_extract(const solid_pack_t *pack, int entry_index, solid_buffer_t *buffer);
+
+/* decode the solid file of an entry of a pack (returns NULL on error) */
+solid_mesh_t * solid_pack_load_mesh(const solid_pack_t *pack, int entry_index);
+
+/* load the solid file of an entry of a pack and write it as an obj file and its mtl file (options may be NULL, returns 0 on error) */
+int convert_pack_entry_to_obj(const solid_pack_t *pack, int entry_index, char *obj_file_path, char *obj_material_file_path, const conversion_options_t *options);
+
+#endif
@@ -0,0 +1,450 @@
+/*
+    solid2obj
+    Copyright (C) 2013 melchips (Francois Truphemus : francois (at) truphemus (dot) fr)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "solid2obj_private.h"
+
+#define BENCH_NAME "solid2obj_bench"
+
+/* biggest count of vertices or triangles a solid file can hold (they are stored as shorts) */
+#define BENCH_SOLID_MAX_COUNT 32767
+
+/* most stages timed by a run */
+#define BENCH_MAX_STAGES 8
+
+/* shape of the synthetic mesh */
+typedef struct _bench_settings
+{
+    int triangles_count; /* triangles once the quads are split */
+    int colors_count;
+    double quad_ratio; /* part of the grid cells written as a quad instead of 2 triangles */
+    const char *index_format; /* "v", "vt", "vn", "vtvn" or "relative" */
+    int repeats; /* each stage is run this many times, the fastest run is kept */
+    unsigned int seed;
+    const char *output_prefix; /* the generated files are written as <prefix>.obj, .mtl and .solid if not NULL */
+} bench_settings_t;
+
+/* fastest run of a stage */
+typedef struct _bench_stage
+{
+    const char *name;
+    double seconds;
+    size_t bytes; /* bytes read or written by one run */
+    long triangles; /* triangles handled by one run (0 if the stage has none) */
+} bench_stage_t;
+
+/* data shared by the stages (the output of a stage is the input of the next one) */
+typedef struct _bench_data
+{
+    solid_buffer_t obj_text;
+    solid_buffer_t mtl_text;
+    solid_buffer_t solid_data;
+    solid_buffer_t obj_output;
+    obj_mesh_t *obj_mesh;
+    solid_mesh_t *solid_mesh;
+    solid_material_table_t *material_table;
+    int *triangle_material_ids;
+    solid_mesh_geometry_t geometry;
+    long triangles_count;
+} bench_data_t;
+
+/* seconds on a clock which never goes back */
+double bench_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/* next pseudo random number between 0 and 1 (xorshift, the same mesh for the same seed everywhere) */
+double bench_random(unsigned int *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (*state & 0xffffff) / (double) 0x1000000;
+}
+
+/* write a vertex reference of a face in the index format of the settings */
+int bench_format_corner(solid_buffer_t *buffer, const bench_settings_t *settings, int vertex, int vertices_count)
+{
+    if (strcmp(settings->index_format, "vt") == 0)
+        return solid_buffer_printf(buffer, " %d/%d", vertex, vertex);
+    if (strcmp(settings->index_format, "vn") == 0)
+        return solid_buffer_printf(buffer, " %d//%d", vertex, vertex);
+    if (strcmp(settings->index_format, "vtvn") == 0)
+        return solid_buffer_printf(buffer, " %d/%d/%d", vertex, vertex, vertex);
+    if (strcmp(settings->index_format, "relative") == 0)
+        return solid_buffer_printf(buffer, " %d", vertex - vertices_count - 1);
+    return solid_buffer_printf(buffer, " %d", vertex);
+}
+
+/* generate a grid of slightly bumpy cells as obj and mtl text, colors going in bands across the grid (returns 0 on error) */
+int bench_generate(const bench_settings_t *settings, bench_data_t *data)
+{
+    unsigned int state = settings->seed ? settings->seed : 1;
+    int cells_count = (settings->triangles_count + 1) / 2;
+    int columns = 1;
+    int rows = 0;
+    int vertices_count = 0;
+    int row = 0;
+    int column = 0;
+    int corners[4];
+    int color = 0;
+    int previous_color = -1;
+    int cell_index = 0;
+    const char *material_name = "bench";
+    int result = 1;
+
+    /* written files refer to the mtl file written next to them */
+    if (settings->output_prefix != NULL)
+        {
+            material_name = strrchr(settings->output_prefix, '/');
+            material_name = (material_name != NULL) ? material_name + 1 : settings->output_prefix;
+        }
+
+    while (columns * columns < cells_count)
+        columns++;
+    rows = (cells_count + columns - 1) / columns;
+    vertices_count = (rows + 1) * (columns + 1);
+
+    result &= solid_buffer_printf(&data->obj_text, "# synthetic mesh of %d triangles, %d colors\nmtllib %s.mtl\n", settings->triangles_count, settings->colors_count, material_name);
+    for (row = 0; result && row <= rows; row++)
+        {
+            for (column = 0; result && column <= columns; column++)
+                {
+                    result &= solid_buffer_printf(&data->obj_text, "v %f %f %f\n", column * 0.1, row * 0.1, bench_random(&state) * 0.05);
+                    if (strcmp(settings->index_format, "vt") == 0 || strcmp(settings->index_format, "vtvn") == 0)
+                        result &= solid_buffer_printf(&data->obj_text, "vt %f %f\n", (double) column / columns, (double) row / rows);
+                    if (strcmp(settings->index_format, "vn") == 0 || strcmp(settings->index_format, "vtvn") == 0)
+                        result &= solid_buffer_printf(&data->obj_text, "vn 0 0 1\n");
+                }
+        }
+
+    data->triangles_count = 0;
+    for (cell_index = 0; result && cell_index < cells_count && data->triangles_count < settings->triangles_count; cell_index++)
+        {
+            row = cell_index / columns;
+            column = cell_index % columns;
+            corners[0] = row * (columns + 1) + column + 1;
+            corners[1] = corners[0] + 1;
+            corners[2] = corners[1] + columns + 1;
+            corners[3] = corners[0] + columns + 1;
+
+            color = (int) ((long) cell_index * settings->colors_count / cells_count);
+            if (color != previous_color)
+                {
+                    result &= solid_buffer_printf(&data->obj_text, "usemtl color_%d\n", color);
+                    previous_color = color;
+                }
+
+            if (data->triangles_count + 2 <= settings->triangles_count && bench_random(&state) < settings->quad_ratio)
+                {
+                    result &= solid_buffer_printf(&data->obj_text, "f");
+                    result &= bench_format_corner(&data->obj_text, settings, corners[0], vertices_count);
+                    result &= bench_format_corner(&data->obj_text, settings, corners[1], vertices_count);
+                    result &= bench_format_corner(&data->obj_text, settings, corners[2], vertices_count);
+                    result &= bench_format_corner(&data->obj_text, settings, corners[3], vertices_count);
+                    result &= solid_buffer_printf(&data->obj_text, "\n");
+                    data->triangles_count += 2;
+                }
+            else
+                {
+                    result &= solid_buffer_printf(&data->obj_text, "f");
+                    result &= bench_format_corner(&data->obj_text, settings, corners[0], vertices_count);
+                    result &= bench_format_corner(&data->obj_text, settings, corners[1], vertices_count);
+                    result &= bench_format_corner(&data->obj_text, settings, corners[2], vertices_count);
+                    result &= solid_buffer_printf(&data->obj_text, "\n");
+                    data->triangles_count++;
+                    if (data->triangles_count < settings->triangles_count)
+                        {
+                            result &= solid_buffer_printf(&data->obj_text, "f");
+                            result &= bench_format_corner(&data->obj_text, settings, corners[0], vertices_count);
+                            result &= bench_format_corner(&data->obj_text, settings, corners[2], vertices_count);
+                            result &= bench_format_corner(&data->obj_text, settings, corners[3], vertices_count);
+                            result &= solid_buffer_printf(&data->obj_text, "\n");
+                            data->triangles_count++;
+                        }
+                }
+        }
+
+    for (color = 0; result && color < settings->colors_count; color++)
+        {
+            result &= solid_buffer_printf(&data->mtl_text, "newmtl color_%d\nKa 1.0 1.0 1.0\nKd %f %f %f\nKs 0.0 0.0 0.0\nNs 0.0\n\n", color,
+                                          bench_random(&state), bench_random(&state), bench_random(&state));
+        }
+
+    return result;
+}
+
+/* run one of the stages (returns 0 on error) */
+int bench_run_stage(int stage_index, bench_data_t *data, size_t *bytes)
+{
+    int result = 1;
+
+    switch (stage_index)
+        {
+        /* obj faces, vertices and usemtl lines */
+        case 0:
+            obj_mesh_free(data->obj_mesh);
+            data->obj_mesh = obj_mesh_create("bench.obj");
+            result = data->obj_mesh != NULL && obj_mesh_parse(data->obj_mesh, (const char *) data->obj_text.data, data->obj_text.used);
+            *bytes = data->obj_text.used;
+            break;
+
+        /* mtl colors, in the materials declared by the usemtl lines */
+        case 1:
+            result = obj_mesh_parse_materials(data->obj_mesh, (const char *) data->mtl_text.data, data->mtl_text.used);
+            *bytes = data->mtl_text.used;
+            break;
+
+        /* solid records (big endian) */
+        case 2:
+            data->solid_data.used = 0;
+            result = obj_mesh_serialize_solid(data->obj_mesh, &data->solid_data);
+            *bytes = data->solid_data.used;
+            break;
+
+        /* solid records back in memory */
+        case 3:
+            solid_mesh_free(data->solid_mesh);
+            data->solid_mesh = solid_mesh_parse("bench.solid", data->solid_data.data, data->solid_data.used);
+            result = data->solid_mesh != NULL;
+            *bytes = data->solid_data.used;
+            break;
+
+        /* one material per color */
+        case 4:
+            if (data->material_table != NULL)
+                solid_material_table_free(data->material_table);
+            free(data->triangle_material_ids);
+            data->material_table = NULL;
+            data->triangle_material_ids = NULL;
+            result = solid_mesh_material_ids(data->solid_mesh, &data->material_table, &data->triangle_material_ids);
+            *bytes = (size_t) data->solid_mesh->triangle_count * 20;
+            break;
+
+        /* obj text of the solid mesh */
+        case 5:
+            data->obj_output.used = 0;
+            result = solid_mesh_format_obj_vertices(data->solid_mesh, 0, data->solid_mesh->vertex_count, -1, &data->obj_output)
+                     && solid_mesh_format_obj_triangles(data->solid_mesh, data->triangle_material_ids, 0, data->solid_mesh->triangle_count, -1, 0, &data->obj_output);
+            *bytes = data->obj_output.used;
+            break;
+
+        /* face and vertex normals, box and sphere of the solid mesh */
+        case 6:
+            solid_mesh_geometry_free(&data->geometry);
+            result = solid_mesh_geometry_compute(&data->geometry, data->solid_mesh);
+            *bytes = (size_t) data->solid_mesh->vertex_count * 12 + (size_t) data->solid_mesh->triangle_count * 20;
+            break;
+
+        default:
+            result = 0;
+            break;
+        }
+
+    return result;
+}
+
+/* print the command line of the benchmark */
+void bench_usage(const char *command_name)
+{
+    printf("usage:\n"
+           "\n"
+           "\t%s [-n <triangles>] [-c <colors>] [-q <quad_ratio>] [-f <index_format>] [-r <repeats>] [-s <seed>] [-g <prefix>]\n"
+           "\n"
+           "\t-n triangles\t\t:\ttriangles of the synthetic mesh (default : 30000, at most %d for the solid stages)\n"
+           "\t-c colors\t\t:\tcolors of the synthetic mesh (default : 16)\n"
+           "\t-q quad_ratio\t\t:\tpart of the cells written as quads, between 0 and 1 (default : 0.5)\n"
+           "\t-f index_format\t\t:\tface corners as v, vt (v/vt), vn (v//vn), vtvn (v/vt/vn) or relative (-v) (default : v)\n"
+           "\t-r repeats\t\t:\truns of each stage, the fastest is kept (default : 5)\n"
+           "\t-s seed\t\t\t:\tseed of the synthetic mesh (default : 1)\n"
+           "\t-g prefix\t\t:\talso write the synthetic mesh as <prefix>.obj, <prefix>.mtl and <prefix>.solid\n"
+           "\n"
+           "\tthe results are printed as JSON : seconds, MB/s and triangles/s of each stage, peak resident memory\n"
+           "\n", command_name, BENCH_SOLID_MAX_COUNT);
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *stage_names[] = { "obj_parse", "mtl_parse", "solid_write", "solid_read", "material_dedup", "obj_format", "normals" };
+    bench_settings_t settings;
+    bench_data_t data;
+    bench_stage_t stages[BENCH_MAX_STAGES];
+    solid_buffer_t messages;
+    solid_buffer_t *previous_capture = NULL;
+    struct rusage usage;
+    char path[1024];
+    int stages_count = 0;
+    int stage_index = 0;
+    int repeat = 0;
+    int argument_index = 0;
+    size_t bytes = 0;
+    double start = 0.0;
+    double seconds = 0.0;
+    int result = 1;
+
+    memset(&settings, 0, sizeof(bench_settings_t));
+    settings.triangles_count = 30000;
+    settings.colors_count = 16;
+    settings.quad_ratio = 0.5;
+    settings.index_format = "v";
+    settings.repeats = 5;
+    settings.seed = 1;
+
+    for (argument_index = 1; argument_index < argc; argument_index += 2)
+        {
+            if (argument_index + 1 >= argc)
+                {
+                    bench_usage(argv[0]);
+                    return 1;
+                }
+            if (strcmp(argv[argument_index], "-n") == 0)
+                settings.triangles_count = atoi(argv[argument_index + 1]);
+            else if (strcmp(argv[argument_index], "-c") == 0)
+                settings.colors_count = atoi(argv[argument_index + 1]);
+            else if (strcmp(argv[argument_index], "-q") == 0)
+                settings.quad_ratio = atof(argv[argument_index + 1]);
+            else if (strcmp(argv[argument_index], "-f") == 0)
+                settings.index_format = argv[argument_index + 1];
+            else if (strcmp(argv[argument_index], "-r") == 0)
+                settings.repeats = atoi(argv[argument_index + 1]);
+            else if (strcmp(argv[argument_index], "-s") == 0)
+                settings.seed = (unsigned int) strtoul(argv[argument_index + 1], NULL, 10);
+            else if (strcmp(argv[argument_index], "-g") == 0)
+                settings.output_prefix = argv[argument_index + 1];
+            else
+                {
+                    bench_usage(argv[0]);
+                    return 1;
+                }
+        }
+    if (settings.triangles_count < 1 || settings.colors_count < 1 || settings.repeats < 1 || settings.quad_ratio < 0.0 || settings.quad_ratio > 1.0
+            || (strcmp(settings.index_format, "v") != 0 && strcmp(settings.index_format, "vt") != 0 && strcmp(settings.index_format, "vn") != 0
+                && strcmp(settings.index_format, "vtvn") != 0 && strcmp(settings.index_format, "relative") != 0))
+        {
+            bench_usage(argv[0]);
+            return 1;
+        }
+
+    memset(&data, 0, sizeof(bench_data_t));
+    solid_buffer_init(&data.obj_text);
+    solid_buffer_init(&data.mtl_text);
+    solid_buffer_init(&data.solid_data);
+    solid_buffer_init(&data.obj_output);
+    solid_buffer_init(&messages);
+
+    if (!bench_generate(&settings, &data))
+        {
+            fprintf(stderr, "Error : can't generate the synthetic mesh !\n");
+            return 1;
+        }
+
+    /* the library reports its progress, it would get mixed with the JSON */
+    previous_capture = report_set_capture(&messages);
+
+    /* the stages run in order, each one on the output of the previous one (solid files can't hold big meshes) */
+    for (stage_index = 0; result && stage_index < (int) (sizeof(stage_names) / sizeof(stage_names[0])); stage_index++)
+        {
+            if (stage_index == 2 && data.triangles_count > BENCH_SOLID_MAX_COUNT)
+                {
+                    fprintf(stderr, "Warning : solid files hold at most %d triangles, the solid stages are skipped !\n", BENCH_SOLID_MAX_COUNT);
+                    break;
+                }
+
+            stages[stages_count].name = stage_names[stage_index];
+            stages[stages_count].seconds = 0.0;
+            for (repeat = 0; result && repeat < settings.repeats; repeat++)
+                {
+                    start = bench_now();
+                    result = bench_run_stage(stage_index, &data, &bytes);
+                    seconds = bench_now() - start;
+                    if (repeat == 0 || seconds < stages[stages_count].seconds)
+                        stages[stages_count].seconds = seconds;
+                }
+            stages[stages_count].bytes = bytes;
+            stages[stages_count].triangles = (stage_index == 1) ? 0 : data.triangles_count;
+            stages_count++;
+        }
+
+    report_set_capture(previous_capture);
+    if (!result)
+        {
+            fprintf(stderr, "Error : stage %s failed !\n", stage_names[stage_index - 1]);
+            fwrite(messages.data, 1, messages.used, stderr);
+        }
+
+    if (result && settings.output_prefix != NULL)
+        {
+            snprintf(path, sizeof(path), "%s.obj", settings.output_prefix);
+            result &= solid_buffer_write_file(&data.obj_text, path);
+            snprintf(path, sizeof(path), "%s.mtl", settings.output_prefix);
+            result &= solid_buffer_write_file(&data.mtl_text, path);
+            if (data.solid_data.used > 0)
+                {
+                    snprintf(path, sizeof(path), "%s.solid", settings.output_prefix);
+                    result &= solid_buffer_write_file(&data.solid_data, path);
+                }
+        }
+
+    /* ru_maxrss is in kilobytes on Linux */
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("{\n");
+    printf("  \"benchmark\": \"%s\",\n", BENCH_NAME);
+    printf("  \"mesh\": { \"triangles\": %ld, \"colors\": %d, \"quad_ratio\": %g, \"index_format\": \"%s\", \"seed\": %u, \"obj_bytes\": %lu },\n",
+           data.triangles_count, settings.colors_count, settings.quad_ratio, settings.index_format, settings.seed, (unsigned long) data.obj_text.used);
+    printf("  \"repeats\": %d,\n", settings.repeats);
+    printf("  \"stages\": [\n");
+    for (stage_index = 0; stage_index < stages_count; stage_index++)
+        {
+            seconds = (stages[stage_index].seconds > 0.0) ? stages[stage_index].seconds : 1e-9;
+            printf("    { \"name\": \"%s\", \"seconds\": %.6f, \"bytes\": %lu, \"mb_per_s\": %.2f, \"triangles_per_s\": ",
+                   stages[stage_index].name, stages[stage_index].seconds, (unsigned long) stages[stage_index].bytes, stages[stage_index].bytes / seconds / 1e6);
+            if (stages[stage_index].triangles > 0)
+                printf("%.0f }%s\n", stages[stage_index].triangles / seconds, (stage_index + 1 < stages_count) ? "," : "");
+            else
+                printf("null }%s\n", (stage_index + 1 < stages_count) ? "," : "");
+        }
+    printf("  ],\n");
+    printf("  \"peak_rss_kb\": %ld,\n", usage.ru_maxrss);
+    printf("  \"succeeded\": %s\n", result ? "true" : "false");
+    printf("}\n");
+
+    obj_mesh_free(data.obj_mesh);
+    solid_mesh_free(data.solid_mesh);
+    if (data.material_table != NULL)
+        solid_material_table_free(data.material_table);
+    free(data.triangle_material_ids);
+    solid_mesh_geometry_free(&data.geometry);
+    solid_buffer_free(&data.obj_text);
+    solid_buffer_free(&data.mtl_text);
+    solid_buffer_free(&data.solid_data);
+    solid_buffer_free(&data.obj_output);
+    solid_buffer_free(&messages);
+
+    return result ? 0 : 1;
+}
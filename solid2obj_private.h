@@ -0,0 +1,646 @@
+/*
+    solid2obj
+    Copyright (C) 2013 melchips (Francois Truphemus : francois (at) truphemus (dot) fr)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLID2OBJ_PRIVATE_H
+#define SOLID2OBJ_PRIVATE_H
+
+/* internals of libsolid2obj (solid2obj_bench times some of them), the API is in solid2obj.h */
+#include "solid2obj.h"
+
+/* longest text written by text_format_float (sign included) */
+#define TEXT_FLOAT_MAX_LENGTH 64
+
+/* obj files are parsed in chunks of at least this size by obj_mesh_parse_parallel */
+#define OBJ_PARSE_MIN_CHUNK_SIZE (1 << 20)
+
+/* solid meshes are formatted as obj text in ranges of at least this many vertices or triangles per thread */
+#define OBJ_FORMAT_MIN_RANGE_SIZE 4096
+
+/* entries of the vertex cache that triangles are ordered for (and that ACMR figures are given for) */
+#define OBJ_VERTEX_CACHE_SIZE 16
+
+/* kinds of vertices for the decimation : free to move, sliding along a border (of the mesh or between materials), kept in place */
+#define OBJ_DECIMATION_INTERIOR 0
+#define OBJ_DECIMATION_BORDER 1
+#define OBJ_DECIMATION_LOCKED 2
+
+/* weight of the planes across the borders, relative to the planes of the triangles */
+#define OBJ_DECIMATION_BORDER_WEIGHT 10.0
+
+/* compact solid files (SOLID_FORMAT_V2, little endian) : header (magic, version, header size, vertex, triangle and color counts,
+   padding, bounds min and max as 3 floats each), vertices (3 quantized shorts), colors (3 bytes), triangles (3 shorts and a color index) */
+#define SOLID_V2_MAGIC "SLD2"
+#define SOLID_V2_VERSION 1
+#define SOLID_V2_HEADER_SIZE 40
+#define SOLID_V2_VERTEX_SIZE 6
+#define SOLID_V2_COLOR_SIZE 3
+#define SOLID_V2_TRIANGLE_SIZE 7
+#define SOLID_V2_MAX_COLORS 256
+
+/* compression of the entries of packs (LZ4 block format) : shortest and farthest matches, size of the hash table, bytes at the end
+   of a block kept as literals and bytes at the end where no match may start */
+#define SOLID_LZ_MIN_MATCH 4
+#define SOLID_LZ_MAX_OFFSET 65535
+#define SOLID_LZ_HASH_BITS 14
+#define SOLID_LZ_LAST_LITERALS 5
+#define SOLID_LZ_END_LIMIT 12
+
+/* triangles whose normals are computed at a time by solid_mesh_geometry_compute (gathered in separate x, y and z arrays) */
+#define SOLID_GEOMETRY_BLOCK_SIZE 64
+
+/* most buffers given to a single writev call by solid_buffers_write_file */
+#define SOLID_WRITE_MAX_VECTORS 64
+
+/* version of the mesh cache files (to be increased when their layout or what the parser stores changes) */
+#define OBJ_MESH_CACHE_VERSION 1
+
+/* sections of a mesh cache file are aligned on this many bytes so that a mapped file can be used in place */
+#define OBJ_MESH_CACHE_ALIGNMENT 16
+
+/* temporary files of the mesh cache older than this (in seconds) have been left by a crashed writer */
+#define OBJ_MESH_CACHE_TEMPORARY_AGE 3600
+
+/* material of the faces of a chunk read before its first usemtl line (it is known once the previous chunks are merged) */
+#define OBJ_MATERIAL_INHERITED (-2)
+
+/* solid materials indexed by color (open addressing hash table) */
+typedef struct _solid_material_table
+{
+    int materials_used;
+    int materials_allocated;
+    solid_material_t *materials;
+    int slots_count; /* always a power of two */
+    int *slots; /* index in materials or -1 if the slot is free */
+    solid_arena_t *arena; /* arena holding the table, NULL if it has been allocated with malloc */
+} solid_material_table_t;
+
+/* jobs shared by the threads of threads_run_jobs */
+typedef struct _threads_pool
+{
+    void * (*function)(void *);
+    void *jobs;
+    size_t job_size;
+    int jobs_count;
+    unsigned int next_job; /* next job to run, taken with ATOMIC_ADD_32 */
+} threads_pool_t;
+
+/* part of an obj file parsed on its own by obj_mesh_parse_parallel, merged afterwards in file order */
+typedef struct _obj_chunk
+{
+    const char *data;
+    size_t size;
+    obj_mesh_t *obj_mesh; /* vertices, faces and materials of the chunk only */
+    int last_material_index; /* material in use at the end of the chunk (index in obj_mesh->materials, -1 or OBJ_MATERIAL_INHERITED) */
+    int has_material_file; /* true if the chunk has a mtllib line (stored in obj_mesh->material_filename) */
+    int relative_corners_used;
+    int relative_corners_allocated;
+    int *relative_corners; /* corners with a negative vertex index, resolved against the vertices of the chunk only */
+    solid_buffer_t messages; /* errors reported while parsing the chunk */
+    int result;
+} obj_chunk_t;
+
+/* range of vertices or triangles of a solid mesh formatted as obj text by a thread */
+typedef struct _obj_format_job
+{
+    const solid_mesh_t *solid_mesh;
+    const int *triangle_material_ids; /* NULL for a range of vertices or of normals */
+    const solid_XYZ_t *vertex_normals; /* normals of a range of normals, or of the vertices of a range of triangles (NULL if they have none) */
+    int first;
+    int last; /* excluded */
+    int previous_material_id; /* material written before the first triangle of the range (-1 if none) */
+    int float_precision;
+    int part_index; /* buffer of obj_parts the job formats */
+    solid_buffer_t buffer;
+    int result;
+} obj_format_job_t;
+
+/* error quadric of a vertex : sum of the squared distances to planes a x + b y + c z + d = 0 (symmetric 4x4 matrix) */
+typedef struct _obj_quadric
+{
+    double a2, ab, ac, ad;
+    double b2, bc, bd;
+    double c2, cd;
+    double d2;
+} obj_quadric_t;
+
+/* state of the decimation of a triangulated obj mesh (vertices are collapsed into their neighbours, the cheapest first) */
+typedef struct _obj_decimation
+{
+    const obj_mesh_t *obj_mesh;
+    int vertices_count;
+    int triangles_count;
+    double *positions; /* 3 coordinates per vertex */
+    int *corners; /* 3 vertices per triangle (from 0, each one stands for its representative) */
+    obj_quadric_t *quadrics;
+    int *kinds; /* OBJ_DECIMATION_INTERIOR, OBJ_DECIMATION_BORDER or OBJ_DECIMATION_LOCKED */
+    int *representatives; /* vertex each vertex was collapsed into (itself while it is alive) */
+    int *next_merged; /* circular lists of the vertices collapsed together */
+    int *triangle_offsets; /* vertex i is used by the triangles vertex_triangles[triangle_offsets[i]] to vertex_triangles[triangle_offsets[i + 1] - 1] */
+    int *vertex_triangles;
+    int *live_triangles; /* triangles left around each alive vertex */
+    char *triangle_alive;
+    int *heap; /* vertices by cost of their cheapest collapse (binary heap) */
+    int *heap_positions;
+    double *heap_costs; /* cost of the vertex at each place of the heap (kept next to each other for the sifts) */
+    double *costs; /* DBL_MAX if the vertex can't be collapsed */
+    int *targets; /* vertex each vertex is collapsed into for its cost or -1 */
+    int *stamps; /* vertices already visited (equal to stamp) */
+    int stamp;
+    int live_vertices_count;
+    int live_triangles_count;
+    int compacted_triangles_count; /* triangles left when the lists of triangles were last rebuilt */
+} obj_decimation_t;
+
+/* header of a mesh cache file, followed by the vertices, face offsets, face materials, corner vertices, textures and normals
+   (if any) and materials of the mesh, each section aligned on OBJ_MESH_CACHE_ALIGNMENT (integers in the byte order of the machine) */
+typedef struct _obj_mesh_cache_header
+{
+    char magic[8]; /* "S2OMESH" */
+    uint32_t version; /* OBJ_MESH_CACHE_VERSION */
+    uint32_t byte_order; /* 0x01020304 */
+    uint64_t obj_hash; /* hash_xxh64 of the obj file */
+    uint64_t obj_size;
+    uint64_t mtl_hash; /* hash_xxh64 of the material file (0 if the mesh has none) */
+    uint64_t payload_hash; /* hash_xxh64 of everything following the header */
+    uint64_t payload_size;
+    int32_t vertices_count;
+    int32_t faces_count;
+    int32_t corners_count;
+    int32_t materials_count;
+    int32_t has_textures;
+    int32_t has_normals;
+    char material_filename[1024];
+} obj_mesh_cache_header_t;
+
+/* file of a mesh cache directory considered for trimming */
+typedef struct _obj_mesh_cache_entry
+{
+    char path[1024];
+    uint64_t size;
+    time_t time;
+} obj_mesh_cache_entry_t;
+
+/* 64 bits hash of "size" bytes (XXH64 algorithm, words read in the byte order of the machine) */
+uint64_t hash_xxh64(const void *data, size_t size, uint64_t seed);
+
+/* number of decimal digits of an unsigned integer */
+int text_decimal_length(uint64_t value);
+
+/* write an unsigned integer (no terminating null character) and return the end of the text */
+char * text_format_uint(char *text, uint64_t value);
+
+/* write a signed integer (no terminating null character) and return the end of the text */
+char * text_format_int(char *text, int value);
+
+/* shortest "digits * 10^exponent" reading back as the float of the given mantissa and exponent bits (finite, not zero) */
+void float_shortest_decimal(uint32_t ieee_mantissa, uint32_t ieee_exponent, uint32_t *digits, int *exponent);
+
+/* write "digits * 10^exponent" without exponent notation (no terminating null character) and return the end of the text */
+char * text_format_decimal(char *text, uint32_t digits, int exponent);
+
+/* write a positive float with "precision" decimals exactly as printf("%.*f") does (no terminating null character) */
+char * text_format_fixed(char *text, float value, int precision);
+
+/* write a float (no terminating null character) and return the end of the text : the shortest text reading back as
+   the same float if "precision" is negative, otherwise "precision" decimals (at most TEXT_FLOAT_MAX_PRECISION) as printf("%.*f") */
+char * text_format_float(char *text, float value, int precision);
+
+/* report again the messages captured by another thread (kept in the capture buffer of the current thread if there is one) */
+void report_replay(const solid_buffer_t *messages);
+
+/* monotonic clock in nanoseconds */
+uint64_t stats_clock(void);
+
+/* end the stage of the current thread and start another one (STATS_STAGE_NONE to start none), returns the stage ended */
+int stats_enter_stage(int stage);
+
+/* add the lines counted for each keyword to the statistics being captured */
+void stats_add_keyword_lines(const int *keyword_lines);
+
+/* largest memory used by the process so far in kB (-1 if unknown) */
+long stats_peak_memory_kb(void);
+
+/* allocate "size" bytes in a block of their own, put before the current block of an arena so that nothing else goes in it until the arena is reset
+   (NULL on error) */
+void * solid_arena_alloc_block(solid_arena_t *arena, size_t size);
+
+/* grow the block holding a single allocation of an arena with realloc (NULL if the allocation shares its block or on error) */
+void * solid_arena_grow_block(solid_arena_t *arena, void *pointer, size_t old_size, size_t new_size);
+
+/* allocate memory in an arena or with malloc if there is none */
+void * memory_alloc(solid_arena_t *arena, size_t size);
+
+/* allocate memory set to 0 in an arena or with calloc if there is none */
+void * memory_calloc(solid_arena_t *arena, size_t count, size_t size);
+
+/* grow memory allocated by memory_alloc */
+void * memory_realloc(solid_arena_t *arena, void *pointer, size_t old_size, size_t new_size);
+
+/* free memory allocated by memory_alloc (nothing to do in an arena, it is reset as a whole) */
+void memory_free(solid_arena_t *arena, void *pointer);
+
+/* run the jobs of a pool until there is none left, taking the next one each time (thread entry point of threads_run_jobs) */
+void * threads_pool_worker(void *data);
+
+/* run "function" on each job of an array with at most "threads_count" threads taking the jobs in turn (the calling thread is one of them) */
+void threads_run_jobs(void * (*function)(void *), void *jobs, size_t job_size, int jobs_count, int threads_count);
+
+/* capacity needed by an array to hold at least "needed" elements (grows geometrically, up to INT_MAX) */
+int obj_array_capacity(int allocated, int needed);
+
+/* make sure the face arrays of a obj mesh can hold at least "needed" faces */
+int obj_faces_reserve(obj_mesh_t *obj_mesh, int needed);
+
+/* make sure the corner arrays of a obj mesh can hold at least "needed" corners */
+int obj_corners_reserve(obj_mesh_t *obj_mesh, int needed);
+
+/* reserve memory for the given number of vertices, faces and materials in a obj mesh (counts are not changed) */
+int obj_mesh_reserve(obj_mesh_t *obj_mesh, int vertices, int faces, int materials);
+
+/* create a new vertex in a obj mesh and return its handle */
+obj_vertex_t * obj_add_vertex(obj_mesh_t *obj_mesh);
+
+/* start a new (empty) face in a obj mesh and return its index (-1 on error) */
+int obj_add_face(obj_mesh_t *obj_mesh, int material_index);
+
+/* allocate the texture or normal indexes of the corners already stored (they are set to 0) */
+int * obj_corner_indexes_create(obj_mesh_t *obj_mesh);
+
+/* append a corner to the last face of a obj mesh (texture and normal are 0 if absent) */
+int obj_add_face_corner(obj_mesh_t *obj_mesh, int vertex, int texture, int normal);
+
+/* number of corners of a face */
+int obj_face_corner_count(const obj_mesh_t *obj_mesh, int face_index);
+
+/* create a new material in a obj mesh and return its handle */
+obj_material_t * obj_add_material(obj_mesh_t *obj_mesh);
+
+/* "path" as seen from the directory of "file_path" (the directory is only stripped when both share it) */
+const char * path_relative_to_file(const char *path, const char *file_path);
+
+/* state of a file opened with mapped_file_open, "hash" is its mapped_file_hash (state may be NULL) */
+void solid_file_state_set(solid_file_state_t *state, const mapped_file_t *mapped_file, uint64_t hash);
+
+/* map the material file of an obj file, looked for next to the obj file then relatively to the current directory (material_file_path,
+   1024 bytes or NULL, receives the path opened or "material_filename" if it is found nowhere, returns 0 if it can't be opened) */
+int obj_material_file_open(mapped_file_t *mapped_file, const char *obj_file_path, const char *material_filename, char *material_file_path);
+
+/* skip spaces and tabs (never goes past the end of the line) */
+const char * obj_skip_blanks(const char *cursor, const char *end);
+
+/* true if the keyword at the start of the line is exactly "keyword" */
+int obj_line_has_keyword(const char *line, const char *end, const char *keyword, size_t keyword_length);
+
+/* read a signed decimal integer at the cursor and move the cursor after it (returns 0 if there is no number or if it does not fit in an int) */
+int obj_parse_int(const char **cursor, const char *end, int *value);
+
+/* read a float at the cursor (after optional blanks) and move the cursor after it (returns 0 if there is no number) */
+int obj_parse_float(const char **cursor, const char *end, float *value);
+
+/* read a "r g b" color at the cursor */
+int obj_parse_color(const char **cursor, const char *end, float *r, float *g, float *b);
+
+/* read a name (up to the next blank) at the cursor into a null terminated buffer */
+int obj_parse_name(const char **cursor, const char *end, char *name, size_t name_size);
+
+/* parse a face line ("v", "v/t", "v//n" or "v/t/n" groups) in a single pass (chunk is NULL unless parsing a part of a file, returns 0 on memory error only) */
+int obj_read_face(const char *read_line, const char *line_end, obj_mesh_t *obj_mesh, int material_index, obj_chunk_t *chunk);
+
+/* hash a material name (FNV-1a) */
+unsigned int obj_material_name_hash(const char *name);
+
+/* rebuild the material names hash table with at least twice as many slots as materials */
+int obj_material_slots_rebuild(obj_mesh_t *obj_mesh, int slots_count);
+
+/* get the index of a material from its name (returns -1 if there is no such material) */
+int obj_get_material_index(obj_mesh_t *obj_mesh, const char *name);
+
+/* get the index of a material from its name, a black material is created if there is no such material (returns -1 on error) */
+int obj_get_or_add_material(obj_mesh_t *obj_mesh, const char *name);
+
+/* get a material from its name */
+obj_material_t * obj_get_material_by_name(obj_mesh_t *obj_mesh, const char *name);
+
+/* count the lines starting with a keyword to reserve the obj mesh arrays in one go */
+void obj_mesh_reserve_from_data(obj_mesh_t *obj_mesh, const char *data, size_t size);
+
+/* parse the lines of an obj file or of a part of it (chunk is NULL when parsing a whole file) */
+int obj_mesh_parse_lines(obj_mesh_t *obj_mesh, const char *data, size_t size, obj_chunk_t *chunk);
+
+/* parse a chunk of an obj file into its own mesh (thread entry point, errors are kept in the chunk messages) */
+void * obj_chunk_parse(void *data);
+
+/* append a parsed chunk to an obj mesh, "material_index" is the material in use at the start of the chunk and is updated */
+int obj_chunk_merge(obj_mesh_t *obj_mesh, obj_chunk_t *chunk, int *material_index);
+
+/* bit pattern of a color component used as hash key (-0.0 and 0.0 are the same color) */
+unsigned int solid_color_bits(float component);
+
+/* hash a color from the bit patterns of its components */
+unsigned int solid_color_hash(float r, float g, float b);
+
+/* create an empty material table (in the arena of the current thread if it has one) */
+solid_material_table_t * solid_material_table_create(void);
+
+/* free a material table from memory */
+void solid_material_table_free(solid_material_table_t *table);
+
+/* double the number of slots of a material table and rehash its materials */
+int solid_material_table_grow(solid_material_table_t *table);
+
+/* get the index of the material matching the color supplied or insert a new one (returns -1 on error) */
+int solid_material_table_get_or_insert(solid_material_table_t *table, float r, float g, float b);
+
+/* assign unique id and name to each material in the table */
+void solid_material_table_assign_unique_id_and_name(solid_material_table_t *table);
+
+/* read short (2 bytes) from file */
+int solid_read_short(FILE *file, int count, short *s);
+
+/* store a short (2 bytes, big endian) in memory */
+void solid_store_short(unsigned char *buf, short s);
+
+/* load a short (2 bytes, big endian) from memory */
+short solid_load_short(const unsigned char *buf);
+
+/* write short (2 bytes) to file */
+int solid_write_short(FILE *file, int count, const short *s);
+
+/* read int (4 bytes) from file */
+int solid_read_int(FILE *file, int count, int *s);
+
+/* store an int (4 bytes, big endian) in memory */
+void solid_store_int(unsigned char *buf, int s);
+
+/* write int (4 bytes) to file */
+int solid_write_int(FILE *file, int count, const int *s);
+
+/* read float (here 4 bytes specifically to the solid file format) from file */
+int solid_read_float(FILE *file, int count, float *f);
+
+/* store a float (4 bytes, big endian) in memory */
+void solid_store_float(unsigned char *buf, float f);
+
+/* load a float (4 bytes, big endian) from memory */
+float solid_load_float(const unsigned char *buf);
+
+/* write float (4 bytes) to file */
+int solid_write_float(FILE *file, int count, const float *f);
+
+/* store an unsigned short (2 bytes, little endian as in compact solid files) in memory */
+void solid_store_ushort_le(unsigned char *buf, unsigned short s);
+
+/* load an unsigned short (2 bytes, little endian) from memory */
+unsigned short solid_load_ushort_le(const unsigned char *buf);
+
+/* store a float (4 bytes, little endian) in memory */
+void solid_store_float_le(unsigned char *buf, float f);
+
+/* load a float (4 bytes, little endian) from memory */
+float solid_load_float_le(const unsigned char *buf);
+
+/* quantize a coordinate of a compact solid file on 16 bits between the bounds of the mesh on its axis */
+unsigned short solid_v2_quantize(float value, float min, float max);
+
+/* coordinate of a compact solid file back from its 16 bits (the loader and the encoder must agree on it) */
+float solid_v2_dequantize(unsigned short quantized, float min, float max);
+
+/* quantize a color component of a compact solid file on 8 bits */
+unsigned char solid_v2_quantize_color(float component);
+
+/* write the content of several buffers one after the other to a file (gathered in as few system calls as possible) */
+int solid_buffers_write_file(const solid_buffer_t *buffers, int buffers_count, const char *path);
+
+/* copy "count" 32 bits words from src to dst swapping their bytes (big endian <-> little endian) */
+void solid_bswap32_copy(unsigned char *dst, const unsigned char *src, size_t count);
+
+/* copy "count" 16 bits words from src to dst swapping their bytes (big endian <-> little endian) */
+void solid_bswap16_copy(unsigned char *dst, const unsigned char *src, size_t count);
+
+/* read XYZ from file */
+int solid_read_XYZ(FILE *file, int count, solid_XYZ_t *xyz);
+
+/* read solid_textured_triangle from file */
+int solid_read_textured_triangle(FILE *file, int count, solid_textured_triangle_t *solid_textured_triangle);
+
+/* decode "count" vertex records of a solid file (3 big endian floats each) */
+void solid_decode_vertices(solid_XYZ_t *vertices, const unsigned char *data, int count);
+
+/* decode "count" triangle records of a solid file (3 big endian shorts, 2 bytes of padding and 3 big endian floats each) */
+void solid_decode_triangles(solid_textured_triangle_t *triangles, const unsigned char *data, int count);
+
+/* compute the materials of a solid mesh and the material id of each of its triangles (returns 0 on error) */
+int solid_mesh_material_ids(const solid_mesh_t *solid_mesh, solid_material_table_t **material_table, int **triangle_material_ids);
+
+/* normals of the triangles "first" to "first + count" (count <= SOLID_GEOMETRY_BLOCK_SIZE) of a solid mesh : the cross products
+   (b - a) x (c - a), twice as long as the area of each triangle, and their unit vectors (0 for degenerate triangles and for
+   triangles using vertices out of range, "valid" tells the latter apart) */
+void solid_mesh_triangle_normals(const solid_mesh_t *solid_mesh, int first, int count, float cross[3][SOLID_GEOMETRY_BLOCK_SIZE], float unit[3][SOLID_GEOMETRY_BLOCK_SIZE], char *valid);
+
+/* compute the normals and bounds of a solid mesh timed as the normals stage (returns 0 on error) */
+int solid_mesh_geometry_compute_staged(solid_mesh_geometry_t *geometry, const solid_mesh_t *solid_mesh);
+
+/* append a line made of a keyword and "count" floats to a buffer (returns 0 on error) */
+int solid_buffer_append_floats(solid_buffer_t *buffer, const char *keyword, const float *values, int count, int float_precision);
+
+/* format the bounds and normals of a solid mesh as a SOLID_GEOMETRY_EXTENSION file : a "box" line (minimum and maximum), a "sphere" line (center
+   and radius), then a "vn" line per vertex and a "fn" line per triangle in the coordinates and order of the solid file (returns 0 on error) */
+int solid_mesh_geometry_format(const solid_mesh_geometry_t *geometry, const char *solid_name, int float_precision, solid_buffer_t *buffer);
+
+/* write the SOLID_GEOMETRY_EXTENSION file of a solid file held in a buffer : the file is decoded again so that the bounds and normals are
+   those of what is read from it (quantized positions of compact files included, options may be NULL, returns 0 on error) */
+int solid_buffer_write_geometry_file(const solid_buffer_t *solid_buffer, char *solid_file_path, const conversion_options_t *options);
+
+/* format the bounds of a solid mesh as obj comments, in the coordinates of the obj file (returns 0 on error) */
+int solid_mesh_geometry_format_obj_bounds(const solid_mesh_geometry_t *geometry, int float_precision, solid_buffer_t *buffer);
+
+/* format the vertices "first" to "last" (excluded) of a solid mesh as obj "v" lines (returns 0 on error) */
+int solid_mesh_format_obj_vertices(const solid_mesh_t *solid_mesh, int first, int last, int float_precision, solid_buffer_t *buffer);
+
+/* format the normals of the vertices "first" to "last" (excluded) of a solid mesh as obj "vn" lines (returns 0 on error) */
+int solid_mesh_format_obj_normals(const solid_XYZ_t *vertex_normals, int first, int last, int float_precision, solid_buffer_t *buffer);
+
+/* format the triangles "first" to "last" (excluded) of a solid mesh as obj "f" lines (using the normals of their vertices if "with_normals"), with
+   a usemtl line when the material differs from the previous one ("previous_material_id" is the one in use before "first", returns 0 on error) */
+int solid_mesh_format_obj_triangles(const solid_mesh_t *solid_mesh, const int *triangle_material_ids, int first, int last, int previous_material_id, int with_normals, solid_buffer_t *buffer);
+
+/* format the mtl file of a solid mesh from its material table (returns 0 on error) */
+int solid_mesh_format_mtl(const solid_mesh_t *solid_mesh, const char *obj_name, const solid_material_table_t *material_table, int float_precision, solid_buffer_t *material_buffer);
+
+/* format a range of vertices, normals or triangles of a solid mesh (thread entry point of solid_mesh_serialize_obj_parts) */
+void * obj_format_job_run(void *data);
+
+/* format an obj file as 1 + 3 * ranges_count buffers to be written in order (the header, then ranges of vertices, of normals (empty
+   without normals) and of triangles formatted on threads) and its mtl file ("obj_parts" holds that many initialized buffers, returns 0 on error) */
+int solid_mesh_serialize_obj_parts(solid_mesh_t *solid_mesh, const char *obj_name, const char *material_name, const conversion_options_t *options, int ranges_count, solid_buffer_t *obj_parts, solid_buffer_t *material_buffer);
+
+/* write the content of a buffer to an open file and empty it (returns 0 on error) */
+int solid_buffer_write_stream(solid_buffer_t *buffer, FILE *file, const char *path);
+
+/* read "count" records of "record_size" bytes at "offset" in an open solid file (returns 0 on error) */
+int solid_file_read_records(FILE *file, const char *path, long offset, unsigned char *records, size_t record_size, int count);
+
+/* convert a solid file to an obj file reading and writing "window_size" vertices or triangles at a time, the triangles being
+   read twice (colors first, then faces) : the memory used depends on the window and on the number of colors only (options may be NULL, returns 0 on error) */
+int solid_file_stream_to_obj(char *solid_file_path, char *obj_file_path, char *obj_material_file_path, const conversion_options_t *options, int window_size);
+
+/* cell of the welding grid holding a coordinate (cells are "epsilon" wide, exact duplicates are looked for by bit pattern when it is 0) */
+int64_t obj_weld_cell(float coordinate, float epsilon);
+
+/* hash the coordinates of a cell of the welding grid */
+unsigned int obj_weld_cell_hash(int64_t x, int64_t y, int64_t z);
+
+/* true if the corners of a face use at least 3 different vertices */
+int obj_face_has_three_vertices(const int *corner_vertices, int corner_count);
+
+/* merge the vertices closer than "epsilon" (0 merges exact duplicates only) and remap the faces, the first vertex of a group is kept
+   (vertices are hashed in a grid of cells "epsilon" wide, so only the neighbouring cells are searched, returns the number of vertices removed or -1 on error) */
+int obj_mesh_weld_vertices(obj_mesh_t *obj_mesh, float epsilon);
+
+/* split the faces of a obj mesh with more than 3 corners in fans of triangles, as they are written in solid files (returns 0 on error) */
+int obj_mesh_triangulate(obj_mesh_t *obj_mesh);
+
+/* average cache miss ratio (misses per triangle) of a obj mesh drawn with a FIFO vertex cache of "cache_size" entries, faces being split in fans */
+double obj_mesh_acmr(const obj_mesh_t *obj_mesh, int cache_size);
+
+/* order in which to draw the triangles of a triangulated obj mesh for a vertex cache of "cache_size" entries
+   (Tipsify, Sander, Nehab and Barczak 2007 : fans around the vertices kept in the cache, returns NULL on error) */
+int * obj_mesh_tipsify(const obj_mesh_t *obj_mesh, int cache_size);
+
+/* average cache miss ratio of a triangulated obj mesh whose triangles are drawn in "order" (NULL for their own order)
+   with a FIFO vertex cache of "cache_size" entries (vertices must exist, returns a negative value on error) */
+double obj_mesh_order_acmr(const obj_mesh_t *obj_mesh, const int *order, int cache_size);
+
+/* reorder the triangles of a obj mesh for a vertex cache of "cache_size" entries (faces are split in triangles first),
+   then number the vertices in the order they are first used (the order is kept if it misses the cache less, returns 0 on error) */
+int obj_mesh_optimize_vertex_cache(obj_mesh_t *obj_mesh, int cache_size);
+
+/* add the squared distance to a plane (a x + b y + c z + d = 0, normalized) times "weight" to a quadric */
+void obj_quadric_add_plane(obj_quadric_t *quadric, double a, double b, double c, double d, double weight);
+
+/* add a quadric to another one */
+void obj_quadric_add(obj_quadric_t *quadric, const obj_quadric_t *other);
+
+/* value of a quadric at a position (3 doubles) */
+double obj_quadric_error(const obj_quadric_t *quadric, const double *position);
+
+/* true if the edge between two alive vertices is on a border (of the mesh or between two materials) */
+int obj_decimation_edge_is_border(const obj_decimation_t *decimation, int vertex, int other_vertex);
+
+/* true if collapsing a vertex into another one flips none of the triangles left */
+int obj_decimation_collapse_is_valid(const obj_decimation_t *decimation, int vertex, int target);
+
+/* find the cheapest collapse of an alive vertex into one of its neighbours, flipping no triangle if "check_flips" is true
+   (costs and targets, the heap is not updated) */
+void obj_decimation_best_collapse(obj_decimation_t *decimation, int vertex, int check_flips);
+
+/* move a vertex of the collapse heap to its place after its cost changed */
+void obj_decimation_heap_fix(obj_decimation_t *decimation, int vertex);
+
+/* move the vertex at a place of the collapse heap down until its children cost more (the subtrees below it must be heaps) */
+void obj_decimation_heap_sift_down(obj_decimation_t *decimation, int position);
+
+/* free the buffers of a decimation */
+void obj_decimation_free(obj_decimation_t *decimation);
+
+/* prepare the decimation of a triangulated obj mesh using only existing vertices : quadrics, vertex kinds and collapse heap (returns 0 on error) */
+int obj_decimation_init(obj_decimation_t *decimation, const obj_mesh_t *obj_mesh);
+
+/* rebuild the lists of triangles around the vertices with the triangles left only (the dropped ones slow the walks down as they pile up) */
+void obj_decimation_compact(obj_decimation_t *decimation);
+
+/* collapse an alive vertex into one of its neighbours, then update the costs of the vertices around */
+void obj_decimation_collapse(obj_decimation_t *decimation, int vertex, int target);
+
+/* reduce a obj mesh to "faces_budget" triangles and "vertices_budget" vertices (0 for no limit) by quadric error edge collapses
+   (Garland and Heckbert 1997), keeping the borders between materials and of the mesh (faces are split in triangles first, returns 0 on error) */
+int obj_mesh_decimate(obj_mesh_t *obj_mesh, int faces_budget, int vertices_budget);
+
+/* number of triangles of the fans of the faces of a obj mesh (as written in solid files) using a vertex more than once */
+int obj_mesh_degenerate_triangles_count(const obj_mesh_t *obj_mesh);
+
+/* encode an obj mesh as a solid file in the format of the options, warning about the Black Shades limits (options may be NULL, returns 0 on error) */
+int obj_mesh_format_solid(obj_mesh_t *obj_mesh, solid_buffer_t *buffer, const conversion_options_t *options);
+
+/* size of a section of a mesh cache file, padding included */
+size_t obj_mesh_cache_section_size(int count, size_t element_size);
+
+/* size of everything following the header of a mesh cache file */
+size_t obj_mesh_cache_payload_size(const obj_mesh_cache_header_t *header);
+
+/* append a section to a mesh cache file being written (returns 0 on error) */
+int obj_mesh_cache_append_section(solid_buffer_t *buffer, const void *data, int count, size_t element_size);
+
+/* write a parsed obj mesh as a mesh cache file (returns 0 on error) */
+int obj_mesh_serialize_cache(const obj_mesh_t *obj_mesh, uint64_t obj_hash, size_t obj_size, uint64_t mtl_hash, solid_buffer_t *buffer);
+
+/* check the header of a mesh cache file against the obj file it should come from (returns 0 if the file is stale or damaged) */
+int obj_mesh_cache_check(const unsigned char *data, size_t size, uint64_t obj_hash, size_t obj_size, obj_mesh_cache_header_t *header);
+
+/* copy a section of a mesh cache file and return the next one */
+const unsigned char * obj_mesh_cache_read_section(const unsigned char *section, void *data, int count, size_t element_size);
+
+/* fill an empty obj mesh from a mesh cache file checked by obj_mesh_cache_check (returns 0 on error) */
+int obj_mesh_parse_cache(obj_mesh_t *obj_mesh, const unsigned char *data, const obj_mesh_cache_header_t *header);
+
+/* path of the mesh cache file of an obj file content (returns 0 if it is too long) */
+int obj_mesh_cache_path(char *path, size_t path_size, const char *directory, uint64_t obj_hash);
+
+/* fill an empty obj mesh from the mesh cache if the obj file and its material file have not changed since they were stored
+   (material_file_path, 1024 bytes or NULL, receives the path of the material file checked and material_file_state, if not NULL, its state,
+   returns 0 if they must be parsed) */
+int obj_mesh_cache_load(obj_mesh_t *obj_mesh, const char *directory, const char *obj_file_path, uint64_t obj_hash, size_t obj_size, char *material_file_path,
+                        solid_file_state_t *material_file_state);
+
+/* store a parsed obj mesh in the mesh cache (written to a temporary file then renamed, so that other workers never see a partial file, returns 0 on error) */
+int obj_mesh_cache_store(const obj_mesh_t *obj_mesh, const char *directory, uint64_t obj_hash, size_t obj_size, uint64_t mtl_hash);
+
+/* order mesh cache files from the least recently used */
+int obj_mesh_cache_entry_compare(const void *entry1, const void *entry2);
+
+/* store an unsigned int (4 bytes, little endian as in packs) in memory */
+void solid_store_uint_le(unsigned char *buf, uint32_t value);
+
+/* load an unsigned int (4 bytes, little endian) from memory */
+uint32_t solid_load_uint_le(const unsigned char *buf);
+
+/* store an unsigned 64 bits integer (8 bytes, little endian) in memory */
+void solid_store_uint64_le(unsigned char *buf, uint64_t value);
+
+/* load an unsigned 64 bits integer (8 bytes, little endian) from memory */
+uint64_t solid_load_uint64_le(const unsigned char *buf);
+
+/* append a length of a compressed block, 255 by 255 past the 15 of its token */
+unsigned char * solid_lz_store_length(unsigned char *output, size_t length);
+
+/* append a sequence of a compressed block : literals, then a match of "match_length" bytes "offset" bytes back (none if match_length is 0) */
+unsigned char * solid_lz_store_sequence(unsigned char *output, const unsigned char *literals, size_t literals_length, size_t offset, size_t match_length);
+
+/* compress "size" bytes at the end of a buffer (LZ4 block format : greedy matches found with a hash table of 4 bytes sequences, returns 0 on error) */
+int solid_lz_compress(const unsigned char *data, size_t size, solid_buffer_t *buffer);
+
+/* read a length of a compressed block past the 15 of its token (returns 0 if the block ends first) */
+int solid_lz_load_length(const unsigned char *data, size_t size, size_t *position, size_t *length);
+
+/* decompress a block made by solid_lz_compress into exactly "output_size" bytes (returns 0 if it is damaged) */
+int solid_lz_decompress(const unsigned char *data, size_t size, unsigned char *output, size_t output_size);
+
+/* compare two entries of a pack being written by name for qsort */
+int solid_pack_writer_entry_compare(const void *entry1, const void *entry2);
+
+#endif